@@ -0,0 +1,1072 @@
+#include "CpuRenderer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include <thread>
+
+#include "IntervalTiles.h"
+#include "WorkStealing.h"
+
+// Pixel pro Aufruf von mandelbrotRow(); Vielfaches aller Lane-Breiten
+#define ROW_CHUNK 256
+
+// Kantenlänge der Kacheln, die im Mariani-Silver-Modus parallel verteilt werden
+#define MS_TILE 128
+// Rechtecke mit höchstens so vielen Pixeln Kantenlänge werden nicht weiter geteilt
+#define MS_MIN_SIZE 8
+
+// Kantenlänge der Startkacheln beim Work-Stealing (--schedule steal)
+#define STEAL_TILE 64
+// Aufgaben mit weniger Zeilen werden nicht weiter geteilt
+#define STEAL_MIN_ROWS 4
+// Eine Aufgabe wird geteilt, wenn ihre restlichen Zeilen nach den bisherigen voraussichtlich mehr Iterationen kosten
+#define STEAL_SPLIT_ITERATIONS (1 << 20)
+
+// Kantenlänge der Kacheln, die per Intervallarithmetik klassifiziert werden, und der kleinsten
+// Teilkacheln; Vielfache von PERIODICITY_BLOCK und Teiler von ROW_CHUNK
+#define INTERVAL_TILE 64
+#define INTERVAL_MIN_TILE 16
+
+/**
+ * @brief Gemeinsame Parameter eines Bildes für die Kachelfunktionen.
+ */
+struct FrameSetup
+{
+    FrameParams frame;
+    RenderOptions opts;
+    ColorOptions colors;
+    SimdLevel simd;
+    RenderStats *stats;
+    const std::atomic<bool> *cancel;
+    // iterations enthält schon die Pixel der per Intervallarithmetik gefüllten Kacheln, der Rest ist -1
+    bool classified;
+    // Glatte Iterationsanzahlen des ganzen Bildes, nur in renderFrame() mit smooth, sonst NULL
+    float *smooth;
+};
+
+/**
+ * @brief true, wenn das Bild nicht mehr gebraucht wird und die restlichen Zeilen/Kacheln entfallen.
+ */
+static bool cancelled(const FrameSetup &f)
+{
+    return f.cancel != NULL && f.cancel->load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Färbt count Pixel anhand ihrer Iterationen ein, mit colors.smooth und smooth anhand der
+ * glatten Iterationsanzahlen. Mit colors.histogram bleiben sie ungefärbt, das Histogramm steht erst
+ * mit dem ganzen Bild fest; siehe finishFrame().
+ */
+static void colorizeSpan(const int *iters, const float *smooth, int count, int MAX_ITER, const ColorOptions &colors, uint8_t *rgb)
+{
+    if (colors.histogram)
+        return;
+    if (smooth != NULL && colors.smooth)
+    {
+        for (int i = 0; i < count; i++)
+            smoothToRGB(smooth[i], MAX_ITER, colors, rgb[3 * i + 0], rgb[3 * i + 1], rgb[3 * i + 2]);
+        return;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        iterToRGB(iters[i], MAX_ITER, colors, rgb[3 * i + 0], rgb[3 * i + 1], rgb[3 * i + 2]);
+    }
+}
+
+/**
+ * @brief Macht aus den escapeNorm()-Werten, die die Kernel in smooth geschrieben haben, die glatten
+ * Iterationsanzahlen.
+ */
+static void smoothSpan(const int *iters, float *smooth, int count, int MAX_ITER)
+{
+    for (int i = 0; i < count; i++)
+        smooth[i] = smoothIterations(iters[i], smooth[i], MAX_ITER);
+}
+
+/**
+ * @brief Störungsrechnung für ein Pixel, zählt Iterationen und Schritte in local mit.
+ */
+static int perturbedPixel(const FrameSetup &f, int x, int y, RenderStats &local, float *norm = NULL)
+{
+    int steps;
+    int iter = pixelIterations(f.frame, f.opts, x, y, &steps, norm);
+    local.iterations += iter;
+    local.steps += steps;
+    return iter;
+}
+
+static void addStats(const FrameSetup &f, const RenderStats &local)
+{
+    if (f.stats == NULL)
+        return;
+#pragma omp atomic
+    f.stats->iterations += local.iterations;
+#pragma omp atomic
+    f.stats->steps += local.steps;
+}
+
+/**
+ * @brief Rechnet count Pixel der Bildzeile y ab Spalte x0. In float, double und Double-Double über die
+ * SIMD-Kernel, mit Störungsrechnung Pixel für Pixel. Mit smooth kommen dort die glatten
+ * Iterationsanzahlen hinzu.
+ */
+static void computeRow(const FrameSetup &f, int y, int x0, int count, int *iters, bool previousInside = true, float *smooth = NULL)
+{
+    const FrameParams &p = f.frame;
+    if (p.precision == PRECISION_PERTURBATION)
+    {
+        RenderStats local = {0, 0};
+        for (int i = 0; i < count; i++)
+            iters[i] = perturbedPixel(f, x0 + i, y, local, smooth != NULL ? smooth + i : NULL);
+        addStats(f, local);
+    }
+    else if (p.precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        DoubleDouble imag = DoubleDouble(p.centerY, p.centerYLo) + (p.HEIGHT / 2.0 - y) * p.scale;
+        mandelbrotRowDD(f.simd, p.scale, DoubleDouble(p.centerX, p.centerXLo), imag, p.WIDTH, x0, count, p.MAX_ITER, f.opts, iters, smooth);
+    }
+    else
+    {
+        double imag = (p.HEIGHT / 2.0 - y) * p.scale + p.centerY;
+        if (p.precision == PRECISION_FLOAT)
+            mandelbrotRowFloat(f.simd, p.scale, p.centerX, imag, p.WIDTH, x0, count, p.MAX_ITER, f.opts, iters, previousInside, smooth);
+        else
+            mandelbrotRow(f.simd, p.scale, p.centerX, imag, p.WIDTH, x0, count, p.MAX_ITER, f.opts, iters, previousInside, smooth);
+    }
+
+    if (smooth != NULL)
+        smoothSpan(iters, smooth, count, p.MAX_ITER);
+}
+
+/**
+ * @brief Wie computeRow(), lässt aber die Blöcke von PERIODICITY_BLOCK Pixeln aus, die classifyTiles()
+ * schon gefüllt hat. Jeder Abschnitt dazwischen bekommt mit, ob der Block davor max_iter enthält,
+ * und rechnet so bitgleich zu einem einzigen Aufruf über die ganze Strecke.
+ */
+static void computeRowUnknown(const FrameSetup &f, int y, int x0, int count, int *iters, float *smooth)
+{
+    if (!f.classified)
+    {
+        computeRow(f, y, x0, count, iters, true, smooth);
+        return;
+    }
+
+    int x = 0;
+    while (x < count)
+    {
+        if (iters[x] >= 0)
+        {
+            x += PERIODICITY_BLOCK;
+            continue;
+        }
+        int end = x + PERIODICITY_BLOCK;
+        while (end < count && iters[end] < 0)
+            end += PERIODICITY_BLOCK;
+        if (end > count)
+            end = count;
+
+        bool previousInside = x == 0;
+        for (int i = x - PERIODICITY_BLOCK; i >= 0 && i < x; i++)
+            previousInside = previousInside || iters[i] == f.frame.MAX_ITER;
+        computeRow(f, y, x0 + x, end - x, iters + x, previousInside, smooth != NULL ? smooth + x : NULL);
+        x = end;
+    }
+}
+
+/**
+ * @brief Rechnet count Pixel der Bildzeile y an den Spalten x0, x0 + step, x0 + 2 step, ... (count
+ * höchstens ROW_CHUNK). Gleiche Koordinaten und damit gleiche Ergebnisse wie computeRow().
+ */
+static void computeStrided(const FrameSetup &f, int y, int x0, int step, int count, int *iters)
+{
+    const FrameParams &p = f.frame;
+    if (step == 1)
+    {
+        computeRow(f, y, x0, count, iters);
+        return;
+    }
+    if (p.precision == PRECISION_PERTURBATION)
+    {
+        RenderStats local = {0, 0};
+        for (int i = 0; i < count; i++)
+            iters[i] = perturbedPixel(f, x0 + i * step, y, local);
+        addStats(f, local);
+        return;
+    }
+
+    double imagOffset = (p.HEIGHT / 2.0 - y) * p.scale;
+    double reals[ROW_CHUNK], imags[ROW_CHUNK];
+    double tolerance = periodTolerance(f.opts, p.scale);
+
+    if (p.precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        double realsLo[ROW_CHUNK], imagsLo[ROW_CHUNK];
+        DoubleDouble imag = DoubleDouble(p.centerY, p.centerYLo) + imagOffset;
+        for (int i = 0; i < count; i++)
+        {
+            DoubleDouble real = DoubleDouble(p.centerX, p.centerXLo) + (x0 + i * step - p.WIDTH / 2.0) * p.scale;
+            reals[i] = real.hi;
+            realsLo[i] = real.lo;
+            imags[i] = imag.hi;
+            imagsLo[i] = imag.lo;
+        }
+        mandelbrotPointsDD(f.simd, reals, realsLo, imags, imagsLo, count, p.MAX_ITER, f.opts, tolerance, iters);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        reals[i] = (x0 + i * step - p.WIDTH / 2.0) * p.scale + p.centerX;
+        imags[i] = imagOffset + p.centerY;
+    }
+    if (p.precision == PRECISION_FLOAT)
+    {
+        float realsF[ROW_CHUNK], imagsF[ROW_CHUNK];
+        for (int i = 0; i < count; i++)
+        {
+            realsF[i] = (float)reals[i];
+            imagsF[i] = (float)imags[i];
+        }
+        mandelbrotPointsFloat(f.simd, realsF, imagsF, count, p.MAX_ITER, f.opts, tolerance, iters);
+        return;
+    }
+    mandelbrotPoints(f.simd, reals, imags, count, p.MAX_ITER, f.opts, tolerance, iters);
+}
+
+/**
+ * @brief Rechnet die noch unbekannten (-1) Pixel einer Kachelzeile von Spalte x0 bis x1 (inklusive).
+ * Zusammenhängende unbekannte Abschnitte gehen gemeinsam an computeRow().
+ *
+ * @param f
+ * @param tile Iterationen der Kachel, Zeilenlänge stride
+ * @param stride
+ * @param tileX linke Bildspalte der Kachel
+ * @param tileY obere Bildzeile der Kachel
+ * @param x0 erste Spalte relativ zur Kachel
+ * @param x1 letzte Spalte relativ zur Kachel
+ * @param y Zeile relativ zur Kachel
+ */
+static void msComputeRow(const FrameSetup &f, int *tile, int stride, int tileX, int tileY, int x0, int x1, int y)
+{
+    int *row = tile + y * stride;
+
+    int x = x0;
+    while (x <= x1)
+    {
+        if (row[x] >= 0)
+        {
+            x++;
+            continue;
+        }
+        int end = x;
+        while (end + 1 <= x1 && row[end + 1] < 0)
+            end++;
+        computeRow(f, tileY + y, tileX + x, end - x + 1, row + x);
+        x = end + 1;
+    }
+}
+
+/**
+ * @brief Rechnet die noch unbekannten Pixel einer Kachelspalte von Zeile y0 bis y1 (inklusive).
+ */
+static void msComputeColumn(const FrameSetup &f, int *tile, int stride, int tileX, int tileY, int x, int y0, int y1)
+{
+    const FrameParams &p = f.frame;
+    if (p.precision == PRECISION_PERTURBATION)
+    {
+        RenderStats local = {0, 0};
+        for (int y = y0; y <= y1; y++)
+        {
+            if (tile[y * stride + x] < 0)
+                tile[y * stride + x] = perturbedPixel(f, tileX + x, tileY + y, local);
+        }
+        addStats(f, local);
+        return;
+    }
+
+    double offset = (tileX + x - p.WIDTH / 2.0) * p.scale;
+    double reals[MS_TILE], imags[MS_TILE];
+    double realsLo[MS_TILE], imagsLo[MS_TILE];
+    int rows[MS_TILE], iters[MS_TILE];
+    int n = 0;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        if (tile[y * stride + x] < 0)
+        {
+            double imagOffset = (p.HEIGHT / 2.0 - (tileY + y)) * p.scale;
+            if (p.precision == PRECISION_DOUBLE_DOUBLE)
+            {
+                DoubleDouble real = DoubleDouble(p.centerX, p.centerXLo) + offset;
+                DoubleDouble imag = DoubleDouble(p.centerY, p.centerYLo) + imagOffset;
+                reals[n] = real.hi;
+                realsLo[n] = real.lo;
+                imags[n] = imag.hi;
+                imagsLo[n] = imag.lo;
+            }
+            else
+            {
+                reals[n] = offset + p.centerX;
+                imags[n] = imagOffset + p.centerY;
+            }
+            rows[n++] = y;
+        }
+    }
+
+    if (n == 0)
+        return;
+
+    double tolerance = periodTolerance(f.opts, p.scale);
+    if (p.precision == PRECISION_FLOAT)
+    {
+        float realsF[MS_TILE], imagsF[MS_TILE];
+        for (int i = 0; i < n; i++)
+        {
+            realsF[i] = (float)reals[i];
+            imagsF[i] = (float)imags[i];
+        }
+        mandelbrotPointsFloat(f.simd, realsF, imagsF, n, p.MAX_ITER, f.opts, tolerance, iters);
+    }
+    else if (p.precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        mandelbrotPointsDD(f.simd, reals, realsLo, imags, imagsLo, n, p.MAX_ITER, f.opts, tolerance, iters);
+    }
+    else
+    {
+        mandelbrotPoints(f.simd, reals, imags, n, p.MAX_ITER, f.opts, tolerance, iters);
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        tile[rows[i] * stride + x] = iters[i];
+    }
+}
+
+/**
+ * @brief Mariani-Silver für das Rechteck [x0, x1] x [y0, y1] (inklusive, relativ zur Kachel).
+ * Der Rand wird gerechnet; ist er überall gleich, wird das Innere damit gefüllt. Sonst wird das
+ * Rechteck geviertelt, die Teilrechtecke teilen sich die Mittellinien.
+ */
+static void marianiSilver(const FrameSetup &f, int *tile, int stride, int tileX, int tileY, int x0, int y0, int x1, int y1)
+{
+    msComputeRow(f, tile, stride, tileX, tileY, x0, x1, y0);
+    msComputeRow(f, tile, stride, tileX, tileY, x0, x1, y1);
+    msComputeColumn(f, tile, stride, tileX, tileY, x0, y0, y1);
+    msComputeColumn(f, tile, stride, tileX, tileY, x1, y0, y1);
+
+    if (x1 - x0 < 2 || y1 - y0 < 2)
+        return;
+
+    int value = tile[y0 * stride + x0];
+    bool uniform = true;
+    for (int x = x0; x <= x1 && uniform; x++)
+    {
+        uniform = tile[y0 * stride + x] == value && tile[y1 * stride + x] == value;
+    }
+    for (int y = y0; y <= y1 && uniform; y++)
+    {
+        uniform = tile[y * stride + x0] == value && tile[y * stride + x1] == value;
+    }
+
+    if (uniform)
+    {
+        for (int y = y0 + 1; y < y1; y++)
+        {
+            for (int x = x0 + 1; x < x1; x++)
+            {
+                tile[y * stride + x] = value;
+            }
+        }
+        return;
+    }
+
+    if (x1 - x0 <= MS_MIN_SIZE || y1 - y0 <= MS_MIN_SIZE)
+    {
+        for (int y = y0 + 1; y < y1; y++)
+        {
+            msComputeRow(f, tile, stride, tileX, tileY, x0 + 1, x1 - 1, y);
+        }
+        return;
+    }
+
+    int mx = (x0 + x1) / 2;
+    int my = (y0 + y1) / 2;
+    marianiSilver(f, tile, stride, tileX, tileY, x0, y0, mx, my);
+    marianiSilver(f, tile, stride, tileX, tileY, mx, y0, x1, my);
+    marianiSilver(f, tile, stride, tileX, tileY, x0, my, mx, y1);
+    marianiSilver(f, tile, stride, tileX, tileY, mx, my, x1, y1);
+}
+
+/**
+ * @brief Rechnet eine Mariani-Silver-Kachel von höchstens MS_TILE x MS_TILE Pixeln und färbt sie ein.
+ *
+ * @param f
+ * @param tile Iterationen der Kachel, Ergebnis
+ * @param stride Zeilenlänge von tile
+ * @param tileX linke Bildspalte der Kachel
+ * @param tileY obere Bildzeile der Kachel
+ * @param w
+ * @param h
+ * @param rgb Ziel für das linke obere Pixel der Kachel
+ * @param rgbStride Pixel pro Zeile in rgb
+ */
+static void msRenderTile(const FrameSetup &f, int *tile, int stride, int tileX, int tileY, int w, int h, uint8_t *rgb,
+                         size_t rgbStride)
+{
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+            tile[y * stride + x] = -1;
+    }
+
+    marianiSilver(f, tile, stride, tileX, tileY, 0, 0, w - 1, h - 1);
+
+    for (int y = 0; y < h; y++)
+    {
+        colorizeSpan(tile + y * stride, NULL, w, f.frame.MAX_ITER, f.colors, rgb + 3 * y * rgbStride);
+    }
+}
+
+/**
+ * @brief Mariani-Silver-Modus: Kacheln von MS_TILE x MS_TILE Pixeln werden dynamisch auf die Threads
+ * verteilt, jeder Thread unterteilt seine Kachel rekursiv direkt im Iterationspuffer des Bildes.
+ */
+static void renderFrameMarianiSilver(uint8_t *image, int *iterations, const FrameSetup &f)
+{
+    const FrameParams &p = f.frame;
+    int tilesX = (p.WIDTH + MS_TILE - 1) / MS_TILE;
+    int tilesY = (p.HEIGHT + MS_TILE - 1) / MS_TILE;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < tilesX * tilesY; t++)
+    {
+        if (cancelled(f))
+            continue;
+
+        int tileX = (t % tilesX) * MS_TILE;
+        int tileY = (t / tilesX) * MS_TILE;
+        int w = p.WIDTH - tileX < MS_TILE ? p.WIDTH - tileX : MS_TILE;
+        int h = p.HEIGHT - tileY < MS_TILE ? p.HEIGHT - tileY : MS_TILE;
+        size_t offset = (size_t)tileY * p.WIDTH + tileX;
+
+        msRenderTile(f, iterations + offset, p.WIDTH, tileX, tileY, w, h, image + 3 * offset, p.WIDTH);
+    }
+}
+
+/**
+ * @brief Rechnet eine Kachel des gekachelten Modus in einem Thread, Zeile für Zeile wie renderFrame()
+ * oder in Mariani-Silver-Teilkacheln. Mit colors.smooth immer Zeile für Zeile, da gefüllte
+ * Mariani-Silver-Rechtecke kein |z| beim Entkommen haben.
+ *
+ * @param f
+ * @param msTile Iterationspuffer für Mariani-Silver (MS_TILE * MS_TILE), sonst ungenutzt
+ * @param tileX
+ * @param tileY
+ * @param w
+ * @param h
+ * @param rgb Ausgabe, w x h Pixel ohne Zeilenabstand
+ */
+static void renderTile(const FrameSetup &f, int *msTile, int tileX, int tileY, int w, int h, uint8_t *rgb)
+{
+    if (f.opts.marianiSilver && !f.colors.smooth)
+    {
+        for (int sy = 0; sy < h; sy += MS_TILE)
+        {
+            for (int sx = 0; sx < w; sx += MS_TILE)
+            {
+                int sw = w - sx < MS_TILE ? w - sx : MS_TILE;
+                int sh = h - sy < MS_TILE ? h - sy : MS_TILE;
+                msRenderTile(f, msTile, MS_TILE, tileX + sx, tileY + sy, sw, sh, rgb + 3 * ((size_t)sy * w + sx), w);
+            }
+        }
+        return;
+    }
+
+    int iters[ROW_CHUNK];
+    float smooth[ROW_CHUNK];
+    for (int y = 0; y < h; y++)
+    {
+        for (int x0 = 0; x0 < w; x0 += ROW_CHUNK)
+        {
+            int count = w - x0 < ROW_CHUNK ? w - x0 : ROW_CHUNK;
+            computeRow(f, tileY + y, tileX + x0, count, iters, true, f.colors.smooth ? smooth : NULL);
+            colorizeSpan(iters, smooth, count, f.frame.MAX_ITER, f.colors, rgb + 3 * ((size_t)y * w + x0));
+        }
+    }
+}
+
+/**
+ * @brief Füllt die Kachel x0, y0, w x h, wenn classifyTile() sie als einheitlich erkennt, sonst ihre
+ * Quadranten bis hinunter zu INTERVAL_MIN_TILE; was übrig bleibt, wird -1.
+ */
+static void classifyTileRecursive(const FrameSetup &f, int *iterations, int x0, int y0, int w, int h)
+{
+    const FrameParams &p = f.frame;
+    // Einheitlich entkommene Kacheln hätten keine glatten Iterationsanzahlen
+    int value = classifyTile(p, f.opts, x0, y0, x0 + w - 1, y0 + h - 1, f.smooth == NULL);
+    if (value == TILE_MIXED && (w > INTERVAL_MIN_TILE || h > INTERVAL_MIN_TILE))
+    {
+        // Links auf ein Vielfaches von PERIODICITY_BLOCK teilen, damit die Blöcke ganz bleiben
+        int left = w > INTERVAL_MIN_TILE ? (w / 2 + PERIODICITY_BLOCK - 1) / PERIODICITY_BLOCK * PERIODICITY_BLOCK : w;
+        int top = h > INTERVAL_MIN_TILE ? h / 2 : h;
+        classifyTileRecursive(f, iterations, x0, y0, left, top);
+        if (left < w)
+            classifyTileRecursive(f, iterations, x0 + left, y0, w - left, top);
+        if (top < h)
+        {
+            classifyTileRecursive(f, iterations, x0, y0 + top, left, h - top);
+            if (left < w)
+                classifyTileRecursive(f, iterations, x0 + left, y0 + top, w - left, h - top);
+        }
+        return;
+    }
+
+    for (int y = y0; y < y0 + h; y++)
+    {
+        int *row = iterations + (size_t)y * p.WIDTH;
+        for (int x = x0; x < x0 + w; x++)
+            row[x] = value;
+        if (f.smooth != NULL)
+        {
+            float *smooth = f.smooth + (size_t)y * p.WIDTH;
+            for (int x = x0; x < x0 + w; x++)
+                smooth[x] = (float)value;
+        }
+    }
+}
+
+/**
+ * @brief Vorlauf von renderFrame() mit opts.intervalTiles: füllt alle Kacheln, deren Pixel nach
+ * classifyTile() beweisbar dieselbe Iterationsanzahl haben, ohne ein Pixel zu iterieren. Alle
+ * übrigen Pixel werden -1 und danach von computeRowUnknown() gerechnet.
+ */
+static void classifyTiles(int *iterations, const FrameSetup &f)
+{
+    const FrameParams &p = f.frame;
+    int cols = (p.WIDTH + INTERVAL_TILE - 1) / INTERVAL_TILE;
+    int rows = (p.HEIGHT + INTERVAL_TILE - 1) / INTERVAL_TILE;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int t = 0; t < cols * rows; t++)
+    {
+        int x0 = (t % cols) * INTERVAL_TILE;
+        int y0 = (t / cols) * INTERVAL_TILE;
+        int w = p.WIDTH - x0 < INTERVAL_TILE ? p.WIDTH - x0 : INTERVAL_TILE;
+        int h = p.HEIGHT - y0 < INTERVAL_TILE ? p.HEIGHT - y0 : INTERVAL_TILE;
+        classifyTileRecursive(f, iterations, x0, y0, w, h);
+    }
+}
+
+/**
+ * @brief Rechnet und färbt eine Aufgabe des Work-Stealings Zeile für Zeile. Solange die eigene Deque
+ * leer ist und der Rest nach den bisherigen Zeilen teuer aussieht, wird die untere Hälfte der
+ * restlichen Zeilen abgespalten und abgelegt, wo andere Threads sie stehlen (und selbst weiter
+ * teilen) können.
+ *
+ * @return Anzahl der gerechneten Pixel, ohne abgespaltene
+ */
+static long long renderStealTask(const FrameSetup &f, StealDeque &own, StealTask task, uint8_t *image, int *iterations)
+{
+    const FrameParams &p = f.frame;
+    long long cost = 0;
+    long long pixels = 0;
+    for (int y = 0; y < task.h; y++)
+    {
+        if (cancelled(f))
+            break;
+
+        int rest = task.h - y;
+        if (y > 0 && rest >= 2 * STEAL_MIN_ROWS && stealDequeEmpty(own) && cost / y * rest > STEAL_SPLIT_ITERATIONS)
+        {
+            StealTask lower = {task.x0, task.y0 + y + rest / 2, task.w, rest - rest / 2};
+            if (pushTask(own, lower))
+                task.h = lower.y0 - task.y0;
+        }
+
+        size_t offset = (size_t)(task.y0 + y) * p.WIDTH + task.x0;
+        for (int x = 0; x < task.w; x += ROW_CHUNK)
+        {
+            int count = task.w - x < ROW_CHUNK ? task.w - x : ROW_CHUNK;
+            float *smooth = f.smooth != NULL ? f.smooth + offset + x : NULL;
+            computeRowUnknown(f, task.y0 + y, task.x0 + x, count, iterations + offset + x, smooth);
+            colorizeSpan(iterations + offset + x, smooth, count, p.MAX_ITER, f.colors, image + 3 * (offset + x));
+        }
+        for (int x = 0; x < task.w; x++)
+            cost += iterations[offset + x];
+        pixels += task.w;
+    }
+    return pixels;
+}
+
+/**
+ * @brief Verteilt das Bild per Work-Stealing (--schedule steal): jeder Thread bekommt zunächst ein
+ * zusammenhängendes Band aus Kacheln von STEAL_TILE Pixeln in seine Deque, also dieselbe Aufteilung
+ * wie ein statischer Schedule. Wer fertig ist, stiehlt bei zufälligen anderen Threads; teure
+ * Aufgaben werden dabei weiter geteilt, siehe renderStealTask(). Gleiche Pixel wie renderFrame().
+ *
+ * @return false bei fehlendem Speicher für die Deques, dann ist noch nichts gerechnet
+ */
+static bool renderFrameStealing(uint8_t *image, int *iterations, const FrameSetup &f)
+{
+    const FrameParams &p = f.frame;
+    int cols = (p.WIDTH + STEAL_TILE - 1) / STEAL_TILE;
+    int rows = (p.HEIGHT + STEAL_TILE - 1) / STEAL_TILE;
+    long long tiles = (long long)cols * rows;
+    int threads = omp_get_max_threads();
+
+    StealDeque *deques = (StealDeque *)malloc(sizeof(StealDeque) * threads);
+    if (deques == NULL)
+        return false;
+    int ready = 0;
+    // Startkacheln plus eine abgespaltene Hälfte
+    while (ready < threads && initStealDeque(deques[ready], tiles / threads + 2))
+        ready++;
+    if (ready < threads)
+    {
+        for (int i = 0; i < ready; i++)
+            freeStealDeque(deques[i]);
+        free(deques);
+        return false;
+    }
+
+    // Rückwärts ablegen, damit jeder Thread sein Band von oben abarbeitet und Diebe unten anfangen
+    for (int t = 0; t < threads; t++)
+    {
+        for (long long i = (t + 1) * tiles / threads - 1; i >= t * tiles / threads; i--)
+        {
+            int x0 = (int)(i % cols) * STEAL_TILE;
+            int y0 = (int)(i / cols) * STEAL_TILE;
+            StealTask task = {x0, y0, p.WIDTH - x0 < STEAL_TILE ? p.WIDTH - x0 : STEAL_TILE, p.HEIGHT - y0 < STEAL_TILE ? p.HEIGHT - y0 : STEAL_TILE};
+            pushTask(deques[t], task);
+        }
+    }
+
+    std::atomic<long long> remaining((long long)p.WIDTH * p.HEIGHT);
+#pragma omp parallel num_threads(threads)
+    {
+        int id = omp_get_thread_num();
+        unsigned int seed = 2654435761u * (id + 1);
+        while (remaining.load(std::memory_order_relaxed) > 0 && !cancelled(f))
+        {
+            StealTask task;
+            bool found = popTask(deques[id], task);
+            // Opfer zufällig wählen, damit nicht alle Diebe beim selben Thread anstehen
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            for (int i = 0; i < threads && !found; i++)
+            {
+                int victim = (int)((seed + i) % threads);
+                found = victim != id && stealTask(deques[victim], task);
+            }
+            if (!found)
+            {
+                // Die übrigen Aufgaben laufen schon, teilbar wird erst wieder etwas nach der nächsten Zeile
+                std::this_thread::yield();
+                continue;
+            }
+            remaining.fetch_sub(renderStealTask(f, deques[id], task, image, iterations), std::memory_order_relaxed);
+        }
+    }
+
+    for (int i = 0; i < threads; i++)
+        freeStealDeque(deques[i]);
+    free(deques);
+    return true;
+}
+
+bool renderRegion(uint8_t *rgb, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors, SimdLevel simd,
+                  int x0, int y0, int w, int h)
+{
+    FrameSetup f = {frame, opts, colors, simd, NULL, NULL, false, NULL};
+    f.colors.histogram = false;
+    int *msTile = NULL;
+    if (opts.marianiSilver)
+    {
+        msTile = (int *)malloc(sizeof(int) * MS_TILE * MS_TILE);
+        if (msTile == NULL)
+            return false;
+    }
+    renderTile(f, msTile, x0, y0, w, h, rgb);
+    free(msTile);
+    return true;
+}
+
+void computeRegion(int *iterations, const FrameParams &frame, const RenderOptions &opts, SimdLevel simd, int x0, int y0, int w, int h,
+                   RenderStats *stats, float *smooth)
+{
+    FrameSetup f = {frame, opts, ColorOptions(), simd, stats, NULL, false, NULL};
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x += ROW_CHUNK)
+        {
+            int count = w - x < ROW_CHUNK ? w - x : ROW_CHUNK;
+            size_t offset = (size_t)y * w + x;
+            computeRow(f, y0 + y, x0 + x, count, iterations + offset, true, smooth != NULL ? smooth + offset : NULL);
+        }
+    }
+}
+
+/**
+ * @brief Abschluss von renderFrame(): mit colors.histogram wird das fertige Bild jetzt gefärbt.
+ *
+ * @return false, wenn das Bild wegen cancel unvollständig ist
+ */
+static bool finishFrame(uint8_t *image, const int *iterations, const FrameSetup &f)
+{
+    if (cancelled(f))
+        return false;
+    if (f.colors.histogram && !colorizeFrame(image, iterations, (size_t)f.frame.WIDTH * f.frame.HEIGHT, f.frame.MAX_ITER, f.colors, f.smooth))
+    {
+        // Ohne Speicher für das Histogramm wenigstens die gewohnten Farben
+        ColorOptions plain = f.colors;
+        plain.histogram = false;
+        colorizeFrame(image, iterations, (size_t)f.frame.WIDTH * f.frame.HEIGHT, f.frame.MAX_ITER, plain, f.smooth);
+    }
+    return true;
+}
+
+bool renderFrame(uint8_t *image, int *iterations, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors,
+                 SimdLevel simd, RenderStats *stats, const std::atomic<bool> *cancel, float *smooth)
+{
+    FrameSetup f = {frame, opts, colors, simd, stats, cancel, false, smooth};
+    if (stats != NULL)
+    {
+        stats->iterations = 0;
+        stats->steps = 0;
+    }
+
+    if (opts.marianiSilver && smooth == NULL)
+    {
+        renderFrameMarianiSilver(image, iterations, f);
+        return finishFrame(image, iterations, f);
+    }
+    if (opts.intervalTiles && (frame.precision == PRECISION_FLOAT || frame.precision == PRECISION_DOUBLE))
+    {
+        classifyTiles(iterations, f);
+        f.classified = true;
+    }
+    if (opts.workStealing && renderFrameStealing(image, iterations, f))
+        return finishFrame(image, iterations, f);
+
+    // Zeilen nahe der Menge kosten um Größenordnungen mehr als Zeilen außerhalb,
+    // daher kein statisches Verteilen. Der Schedule wird in main() gesetzt (dynamic/guided).
+#pragma omp parallel for schedule(runtime)
+    for (int y = 0; y < frame.HEIGHT; y++)
+    {
+        if (cancelled(f))
+            continue;
+
+        uint8_t *row = image + (size_t)3 * y * frame.WIDTH;
+        int *iters = iterations + (size_t)y * frame.WIDTH;
+        float *rowSmooth = smooth != NULL ? smooth + (size_t)y * frame.WIDTH : NULL;
+
+        for (int x0 = 0; x0 < frame.WIDTH; x0 += ROW_CHUNK)
+        {
+            int count = frame.WIDTH - x0 < ROW_CHUNK ? frame.WIDTH - x0 : ROW_CHUNK;
+            computeRowUnknown(f, y, x0, count, iters + x0, rowSmooth != NULL ? rowSmooth + x0 : NULL);
+            colorizeSpan(iters + x0, rowSmooth != NULL ? rowSmooth + x0 : NULL, count, frame.MAX_ITER, colors, row + 3 * x0);
+        }
+    }
+    return finishFrame(image, iterations, f);
+}
+
+/**
+ * @brief Verschiebt die Iterationen eines Bildes an Ort und Stelle: Pixel (x, y) erhält den Wert von
+ * (x + shiftX, y + shiftY), Pixel ohne Quelle werden -1.
+ */
+static void shiftIterations(int *iterations, int WIDTH, int HEIGHT, int shiftX, int shiftY)
+{
+    // Gültige Zielspalten [x0, x1)
+    int x0 = shiftX < 0 ? -shiftX : 0;
+    int x1 = shiftX > 0 ? WIDTH - shiftX : WIDTH;
+
+    // In der Richtung kopieren, in der keine Quellzeile vor dem Lesen überschrieben wird
+    for (int i = 0; i < HEIGHT; i++)
+    {
+        int y = shiftY >= 0 ? i : HEIGHT - 1 - i;
+        int *row = iterations + (size_t)y * WIDTH;
+        int source = y + shiftY;
+        if (source < 0 || source >= HEIGHT)
+        {
+            for (int x = 0; x < WIDTH; x++)
+                row[x] = -1;
+            continue;
+        }
+        memmove(row + x0, iterations + (size_t)source * WIDTH + x0 + shiftX, sizeof(int) * (x1 - x0));
+        for (int x = 0; x < x0; x++)
+            row[x] = -1;
+        for (int x = x1; x < WIDTH; x++)
+            row[x] = -1;
+    }
+}
+
+bool renderFramePanned(uint8_t *image, int *iterations, int shiftX, int shiftY, const FrameParams &frame, const RenderOptions &opts,
+                       const ColorOptions &colors, SimdLevel simd, RenderStats *stats, const std::atomic<bool> *cancel)
+{
+    shiftIterations(iterations, frame.WIDTH, frame.HEIGHT, shiftX, shiftY);
+    // Nur die neu sichtbaren Streifen sind -1
+    return renderFrameRemaining(image, iterations, frame, opts, colors, simd, stats, cancel);
+}
+
+bool renderFrameRemaining(uint8_t *image, int *iterations, const FrameParams &frame, const RenderOptions &opts,
+                          const ColorOptions &colors, SimdLevel simd, RenderStats *stats, const std::atomic<bool> *cancel)
+{
+    FrameSetup f = {frame, opts, colors, simd, stats, cancel, false, NULL};
+    if (stats != NULL)
+    {
+        stats->iterations = 0;
+        stats->steps = 0;
+    }
+
+    // msComputeRow() rechnet genau die Abschnitte aus -1
+#pragma omp parallel for schedule(runtime)
+    for (int y = 0; y < frame.HEIGHT; y++)
+    {
+        if (cancelled(f))
+            continue;
+        msComputeRow(f, iterations, frame.WIDTH, 0, 0, 0, frame.WIDTH - 1, y);
+    }
+    if (cancelled(f))
+        return false;
+
+    return colorizeFrame(image, iterations, (size_t)frame.WIDTH * frame.HEIGHT, frame.MAX_ITER, colors);
+}
+
+bool renderPass(int *iterations, int step, bool first, const FrameParams &frame, const RenderOptions &opts, SimdLevel simd,
+                RenderStats *stats, const std::atomic<bool> *cancel)
+{
+    FrameSetup f = {frame, opts, ColorOptions(), simd, stats, cancel, false, NULL};
+    int rows = (frame.HEIGHT + step - 1) / step;
+
+#pragma omp parallel for schedule(runtime)
+    for (int j = 0; j < rows; j++)
+    {
+        if (cancelled(f))
+            continue;
+
+        int y = j * step;
+        // In Zeilen des vorigen Durchlaufs sind die geraden Vielfachen von step schon gerechnet
+        bool known = !first && y % (2 * step) == 0;
+        int x0 = known ? step : 0;
+        int xStep = known ? 2 * step : step;
+        int *row = iterations + (size_t)y * frame.WIDTH;
+
+        for (int x = x0; x < frame.WIDTH; x += ROW_CHUNK * xStep)
+        {
+            int count = (frame.WIDTH - x + xStep - 1) / xStep;
+            if (count > ROW_CHUNK)
+                count = ROW_CHUNK;
+            int iters[ROW_CHUNK];
+            computeStrided(f, y, x, xStep, count, xStep == 1 ? row + x : iters);
+            if (xStep != 1)
+            {
+                for (int i = 0; i < count; i++)
+                    row[x + i * xStep] = iters[i];
+            }
+        }
+    }
+    return !cancelled(f);
+}
+
+/**
+ * @brief Verteilung der Iterationen für colors.histogram, erster der beiden Durchläufe. Jeder Thread
+ * zählt seinen Teil der Pixel in ein eigenes Histogramm, danach summiert jeder Thread einen Teil der
+ * Bins über alle Histogramme; kein Pixel braucht eine atomare Operation. Gezählt werden die Pixel
+ * j * step, i * step eines WIDTH breiten Bildes, w x h Stück.
+ *
+ * @return MAX_ITER + 1 Einträge für histogramToColor(), NULL bei fehlendem Speicher; mit free() freigeben
+ */
+static float *histogramCdf(const int *iterations, int WIDTH, int w, int h, int step, int MAX_ITER)
+{
+    int threads = omp_get_max_threads();
+    // Auf Cachezeilen gerundet, damit die Threads nicht auf denselben Zeilen zählen
+    size_t stride = ((size_t)MAX_ITER + 16) & ~(size_t)15;
+    unsigned int *counts = (unsigned int *)calloc(stride * threads, sizeof(unsigned int));
+    float *cdf = (float *)malloc(sizeof(float) * (MAX_ITER + 1));
+    if (counts == NULL || cdf == NULL)
+    {
+        free(counts);
+        free(cdf);
+        return NULL;
+    }
+
+#pragma omp parallel num_threads(threads)
+    {
+        unsigned int *local = counts + stride * omp_get_thread_num();
+#pragma omp for schedule(static)
+        for (int j = 0; j < h; j++)
+        {
+            const int *row = iterations + (size_t)j * step * WIDTH;
+            for (int i = 0; i < w; i++)
+            {
+                int iter = row[i * step];
+                // Punkte der Menge (MAX_ITER) bleiben schwarz und zählen nicht
+                if ((unsigned int)iter < (unsigned int)MAX_ITER)
+                    local[iter]++;
+            }
+        }
+        // Zusammenführen in das Histogramm von Thread 0; jeden Bin fasst nur ein Thread an
+#pragma omp for schedule(static)
+        for (int i = 0; i < MAX_ITER; i++)
+        {
+            unsigned int sum = 0;
+            for (int t = 0; t < threads; t++)
+                sum += counts[stride * t + i];
+            counts[i] = sum;
+        }
+    }
+
+    histogramToCdf(counts, cdf, MAX_ITER);
+    free(counts);
+    return cdf;
+}
+
+void colorizePass(uint8_t *image, const int *iterations, int WIDTH, int HEIGHT, int step, int MAX_ITER, const ColorOptions &colors)
+{
+    int w = (WIDTH + step - 1) / step;
+    int h = (HEIGHT + step - 1) / step;
+    // Die Vorschau nach dem Histogramm ihrer eigenen Pixel
+    float *cdf = colors.histogram ? histogramCdf(iterations, WIDTH, w, h, step, MAX_ITER) : NULL;
+
+#pragma omp parallel for schedule(static)
+    for (int j = 0; j < h; j++)
+    {
+        const int *row = iterations + (size_t)j * step * WIDTH;
+        uint8_t *rgb = image + (size_t)3 * j * w;
+        for (int i = 0; i < w; i++)
+        {
+            if (cdf != NULL)
+                colorToRGB(histogramToColor((float)row[i * step], cdf, MAX_ITER), colors, rgb[3 * i + 0], rgb[3 * i + 1], rgb[3 * i + 2]);
+            else
+                iterToRGB(row[i * step], MAX_ITER, colors, rgb[3 * i + 0], rgb[3 * i + 1], rgb[3 * i + 2]);
+        }
+    }
+    free(cdf);
+}
+
+bool colorizeFrame(uint8_t *image, const int *iterations, size_t count, int MAX_ITER, const ColorOptions &colors, const float *smooth)
+{
+    // Histogramm über alle Pixel als ein Bild aus count Zeilen zu einem Pixel
+    float *cdf = NULL;
+    if (colors.histogram)
+    {
+        cdf = histogramCdf(iterations, 1, 1, (int)count, 1, MAX_ITER);
+        if (cdf == NULL)
+            return false;
+    }
+
+    if (smooth != NULL && colors.smooth)
+    {
+        // Stufenlos, daher keine Palette
+#pragma omp parallel for schedule(static)
+        for (long long i = 0; i < (long long)count; i++)
+        {
+            if (cdf != NULL)
+                colorToRGB(histogramToColor(smooth[i], cdf, MAX_ITER), colors, image[3 * i + 0], image[3 * i + 1], image[3 * i + 2]);
+            else
+                smoothToRGB(smooth[i], MAX_ITER, colors, image[3 * i + 0], image[3 * i + 1], image[3 * i + 2]);
+        }
+        free(cdf);
+        return true;
+    }
+
+    // Farben vorab pro Iterationszahl, der Durchlauf selbst ist dann nur noch ein Nachschlagen
+    uint8_t *palette = (uint8_t *)malloc((size_t)3 * (MAX_ITER + 1));
+    if (palette == NULL)
+    {
+        free(cdf);
+        return false;
+    }
+    for (int i = 0; i <= MAX_ITER; i++)
+    {
+        if (cdf != NULL)
+            colorToRGB(histogramToColor((float)i, cdf, MAX_ITER), colors, palette[3 * i + 0], palette[3 * i + 1], palette[3 * i + 2]);
+        else
+            iterToRGB(i, MAX_ITER, colors, palette[3 * i + 0], palette[3 * i + 1], palette[3 * i + 2]);
+    }
+    free(cdf);
+
+#pragma omp parallel for schedule(static)
+    for (long long i = 0; i < (long long)count; i++)
+    {
+        int iter = iterations[i] < MAX_ITER ? iterations[i] : MAX_ITER;
+        const uint8_t *color = palette + 3 * iter;
+        image[3 * i + 0] = color[0];
+        image[3 * i + 1] = color[1];
+        image[3 * i + 2] = color[2];
+    }
+    free(palette);
+    return true;
+}
+
+bool renderFrameTiled(TileWriter &out, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors, SimdLevel simd,
+                      RenderStats *stats)
+{
+    // Kacheln gehen hinaus, bevor das Histogramm des ganzen Bildes feststeht
+    FrameSetup f = {frame, opts, colors, simd, stats, NULL, false, NULL};
+    f.colors.histogram = false;
+    if (stats != NULL)
+    {
+        stats->iterations = 0;
+        stats->steps = 0;
+    }
+
+    int tileSize = out.tileSize;
+    int tilesX = (frame.WIDTH + tileSize - 1) / tileSize;
+    int tilesY = (frame.HEIGHT + tileSize - 1) / tileSize;
+    bool tilesOk = true;
+    bool rowsOk = true;
+
+#pragma omp parallel
+    {
+        uint8_t *rgb = (uint8_t *)malloc((size_t)tileSize * tileSize * 3);
+        int *msTile = (int *)malloc(sizeof(int) * MS_TILE * MS_TILE);
+        if (rgb == NULL || msTile == NULL)
+        {
+#pragma omp critical(tileOutput)
+            tilesOk = false;
+        }
+
+        for (int ty = 0; ty < tilesY; ty++)
+        {
+            int tileY = ty * tileSize;
+            int h = frame.HEIGHT - tileY < tileSize ? frame.HEIGHT - tileY : tileSize;
+
+#pragma omp for schedule(dynamic, 1)
+            for (int tx = 0; tx < tilesX; tx++)
+            {
+                if (rgb == NULL || msTile == NULL)
+                    continue;
+
+                int tileX = tx * tileSize;
+                int w = frame.WIDTH - tileX < tileSize ? frame.WIDTH - tileX : tileSize;
+                renderTile(f, msTile, tileX, tileY, w, h, rgb);
+
+#pragma omp critical(tileOutput)
+                {
+                    if (tilesOk && !writeTile(out, rgb, tileX, tileY, w, h))
+                        tilesOk = false;
+                }
+            }
+
+            // Ein Thread schreibt die fertige Kachelzeile, die anderen rechnen schon die nächste.
+            // Die Barriere am Ende der nächsten Schleife wartet auf ihn, bevor sein Streifen wieder dran ist.
+            // Fehlt eine Kachel (kein Speicher, Schreibfehler), geht kein Streifen mehr hinaus, er wäre unvollständig
+#pragma omp single nowait
+            {
+                bool ok;
+#pragma omp critical(tileOutput)
+                ok = tilesOk;
+                if (ok && rowsOk && !finishTileRow(out, tileY))
+                    rowsOk = false;
+            }
+        }
+
+        free(rgb);
+        free(msTile);
+    }
+    return tilesOk && rowsOk;
+}
@@ -0,0 +1,184 @@
+#ifndef CPU_RENDERER_H
+#define CPU_RENDERER_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "../common/TileWriter.h"
+#include "FractalSimd.h"
+
+/**
+ * @brief Zähler der Störungsrechnung für das Log: Iterationen im Bild und davon tatsächlich
+ * gerechnete Schritte (der Rest wurde per BLA übersprungen).
+ */
+struct RenderStats
+{
+    long long iterations;
+    long long steps;
+};
+
+/**
+ * @brief Render-Funktion für das Mandelbrot auf der CPU. Entspricht render() im CUDA-Backend,
+ * die Zeilen werden per OpenMP auf alle Kerne verteilt. Mit opts.marianiSilver werden stattdessen
+ * Kacheln per Rechteck-Unterteilung berechnet.
+ *
+ * @param image RGB24-Puffer mit frame.WIDTH * frame.HEIGHT * 3 Bytes
+ * @param iterations Ergebnis: Iterationen jedes Pixels, frame.WIDTH * frame.HEIGHT Einträge; bleibt für
+ * colorizeFrame() erhalten
+ * @param frame Bildparameter aus prepareFrame(), Referenzorbit im Host-Speicher
+ * @param opts
+ * @param colors
+ * @param simd Kernel für die Iterationen einer Zeile
+ * @param stats wenn nicht NULL: Ergebnis, nur bei Störungsrechnung gefüllt
+ * @param cancel wenn nicht NULL: wird es gesetzt, entfallen alle noch nicht begonnenen Zeilen bzw. Kacheln
+ * @param smooth wenn nicht NULL: Ergebnis, glatte Iterationsanzahl jedes Pixels (smoothIterations()),
+ * frame.WIDTH * frame.HEIGHT Einträge; mit colors.smooth wird danach gefärbt. Schaltet Mariani-Silver
+ * und das Füllen entkommener Kacheln per Intervallarithmetik ab, da beide kein |z| liefern.
+ * @return false, wenn das Bild wegen cancel unvollständig ist
+ */
+bool renderFrame(uint8_t *image, int *iterations, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors,
+                 SimdLevel simd, RenderStats *stats, const std::atomic<bool> *cancel = NULL, float *smooth = NULL);
+
+/**
+ * @brief Wie renderFrame() für ein Bild, das das vorige um ganze Pixel verschoben zeigt (siehe
+ * panShift()). Die Iterationen in iterations werden verschoben, gerechnet werden nur die neu
+ * sichtbaren Streifen, danach wird das ganze Bild gefärbt.
+ *
+ * @param image
+ * @param iterations Iterationen des vorigen Bildes, Ergebnis wie bei renderFrame()
+ * @param shiftX Pixel (x, y) des Bildes ist Pixel (x + shiftX, y + shiftY) des vorigen
+ * @param shiftY
+ * @param frame
+ * @param opts
+ * @param colors
+ * @param simd
+ * @param stats
+ * @param cancel
+ * @return false, wenn das Bild wegen cancel unvollständig ist oder der Speicher zum Färben fehlt;
+ * iterations ist dann unbrauchbar
+ */
+bool renderFramePanned(uint8_t *image, int *iterations, int shiftX, int shiftY, const FrameParams &frame, const RenderOptions &opts,
+                       const ColorOptions &colors, SimdLevel simd, RenderStats *stats, const std::atomic<bool> *cancel = NULL);
+
+/**
+ * @brief Wie renderFrame() für ein teilweise bekanntes Bild: rechnet nur die Pixel, die in iterations
+ * -1 sind, und färbt dann das ganze Bild (Kachelcache, Verschieben).
+ *
+ * @param image
+ * @param iterations bekannte Iterationen und -1, Ergebnis wie bei renderFrame()
+ * @param frame
+ * @param opts
+ * @param colors
+ * @param simd
+ * @param stats
+ * @param cancel
+ * @return false, wenn das Bild wegen cancel unvollständig ist oder der Speicher zum Färben fehlt
+ */
+bool renderFrameRemaining(uint8_t *image, int *iterations, const FrameParams &frame, const RenderOptions &opts,
+                          const ColorOptions &colors, SimdLevel simd, RenderStats *stats, const std::atomic<bool> *cancel = NULL);
+
+/**
+ * @brief Ein Durchlauf des schrittweisen Renderns (REQUEST_FLAG_PROGRESSIVE): rechnet jedes Pixel,
+ * dessen Spalte und Zeile Vielfache von step sind, außer denen des vorigen Durchlaufs mit 2 step.
+ * Nach den Durchläufen PROGRESSIVE_FIRST_STEP, ..., 2, 1 enthält iterations dasselbe wie nach
+ * renderFrame(), jedes Pixel wurde genau einmal gerechnet.
+ *
+ * @param iterations WIDTH * HEIGHT Einträge, Ergebnis
+ * @param step Zweierpotenz
+ * @param first true im ersten Durchlauf, dann ist noch nichts gerechnet
+ * @param frame
+ * @param opts
+ * @param simd
+ * @param stats wenn nicht NULL: Zähler der Störungsrechnung, wird nicht zurückgesetzt
+ * @param cancel
+ * @return false, wenn der Durchlauf wegen cancel unvollständig ist
+ */
+bool renderPass(int *iterations, int step, bool first, const FrameParams &frame, const RenderOptions &opts, SimdLevel simd,
+                RenderStats *stats, const std::atomic<bool> *cancel = NULL);
+
+/**
+ * @brief Färbt die Vorschau nach einem Durchlauf mit Schrittweite step: ein Pixel pro gerechnetem
+ * Punkt, ceil(WIDTH / step) x ceil(HEIGHT / step) Pixel.
+ *
+ * @param image RGB24-Ausgabe
+ * @param iterations
+ * @param WIDTH
+ * @param HEIGHT
+ * @param step
+ * @param MAX_ITER
+ * @param colors
+ */
+void colorizePass(uint8_t *image, const int *iterations, int WIDTH, int HEIGHT, int step, int MAX_ITER, const ColorOptions &colors);
+
+/**
+ * @brief Rechnet und färbt einen Ausschnitt des Bildes im aufrufenden Thread, für Aufrufer, die selbst
+ * über viele Ausschnitte parallelisieren (DeepZoomExport). Gleiche Pixel wie renderFrame(), mit
+ * colors.smooth glatt gefärbt.
+ *
+ * @param rgb Ausgabe, w x h Pixel
+ * @param frame
+ * @param opts
+ * @param colors
+ * @param simd
+ * @param x0 linke Bildspalte des Ausschnitts
+ * @param y0 obere Bildzeile des Ausschnitts
+ * @param w
+ * @param h
+ * @return false bei fehlendem Speicher
+ */
+bool renderRegion(uint8_t *rgb, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors, SimdLevel simd,
+                  int x0, int y0, int w, int h);
+
+/**
+ * @brief Rechnet die Iterationen eines Ausschnitts im aufrufenden Thread, ohne zu färben (Arbeiter
+ * des MPI-Backends). Jedes Pixel wird gerechnet, auch mit opts.marianiSilver; gleiche Iterationen wie
+ * renderFrame() ohne Mariani-Silver.
+ *
+ * @param iterations Ergebnis, w x h Einträge
+ * @param frame
+ * @param opts
+ * @param simd
+ * @param x0 linke Bildspalte des Ausschnitts
+ * @param y0 obere Bildzeile des Ausschnitts
+ * @param w
+ * @param h
+ * @param stats wenn nicht NULL: Zähler der Störungsrechnung, wird nicht zurückgesetzt
+ * @param smooth wenn nicht NULL: Ergebnis, glatte Iterationsanzahlen, w x h Einträge
+ */
+void computeRegion(int *iterations, const FrameParams &frame, const RenderOptions &opts, SimdLevel simd, int x0, int y0, int w, int h,
+                   RenderStats *stats, float *smooth = NULL);
+
+/**
+ * @brief Färbt ein fertig gerechnetes Bild aus seinen Iterationen neu, ohne etwas zu rechnen.
+ * Ergibt dieselben Pixel wie renderFrame() mit diesen Farben.
+ *
+ * @param image RGB24-Puffer mit count * 3 Bytes
+ * @param iterations aus renderFrame()
+ * @param count Anzahl der Pixel
+ * @param MAX_ITER Iterationsgrenze, mit der das Bild gerechnet wurde
+ * @param colors
+ * @param smooth wenn nicht NULL: glatte Iterationsanzahlen aus renderFrame(), mit colors.smooth wird
+ * danach gefärbt, sonst nach iterations
+ * @return false bei fehlendem Speicher
+ */
+bool colorizeFrame(uint8_t *image, const int *iterations, size_t count, int MAX_ITER, const ColorOptions &colors, const float *smooth = NULL);
+
+/**
+ * @brief Wie renderFrame(), aber in Kacheln von out.tileSize Pixeln, die direkt an out gehen. Nicht
+ * abbrechbar, da ein gestreamtes Bild vollständig ausgeliefert werden muss. Der
+ * Speicherbedarf hängt nur von der Kachelgröße und der Anzahl der Threads ab (ohne Seek zusätzlich
+ * zwei Kachelzeilen), nicht von der Bildgröße.
+ *
+ * @param out aus openTileWriter()
+ * @param frame
+ * @param opts
+ * @param colors
+ * @param simd
+ * @param stats
+ * @return false bei Schreibfehler oder fehlendem Speicher
+ */
+bool renderFrameTiled(TileWriter &out, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors, SimdLevel simd,
+                      RenderStats *stats);
+
+#endif
@@ -0,0 +1,248 @@
+#include "ExpMap.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Zellen pro Aufruf der SIMD-Kernel; Vielfaches aller Lane-Breiten
+#define EXP_MAP_CHUNK 256
+
+static const double TWO_PI = 6.283185307179586;
+
+/**
+ * @brief Rechnet count Zellen einer Streifenzeile ab Spalte j0.
+ *
+ * @param map
+ * @param row Bildparameter der Zeile (Zentrum, MAX_ITER, Referenzorbit)
+ * @param precision Rechenverfahren der Zeile
+ * @param radius Radius der Zeile
+ * @param j0 erste Spalte
+ * @param count
+ * @param opts
+ * @param simd
+ * @param tolerance Ergebnis von periodTolerance() für die Zeile
+ * @param iters Ausgabe, count Einträge
+ */
+static void computeCells(const ExpMap &map, const FrameParams &row, Precision precision, double radius, int j0, int count,
+                         const RenderOptions &opts, SimdLevel simd, double tolerance, int *iters)
+{
+    double dr[EXP_MAP_CHUNK], di[EXP_MAP_CHUNK];
+    for (int i = 0; i < count; i++)
+    {
+        double angle = (j0 + i) * map.logStep;
+        dr[i] = radius * cos(angle);
+        di[i] = radius * sin(angle);
+    }
+
+    if (precision == PRECISION_PERTURBATION)
+    {
+        for (int i = 0; i < count; i++)
+            iters[i] = mandelbrotPerturbed(row, dr[i], di[i]);
+        return;
+    }
+
+    if (precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        double realsLo[EXP_MAP_CHUNK], imagsLo[EXP_MAP_CHUNK];
+        for (int i = 0; i < count; i++)
+        {
+            DoubleDouble real = DoubleDouble(row.centerX, row.centerXLo) + dr[i];
+            DoubleDouble imag = DoubleDouble(row.centerY, row.centerYLo) + di[i];
+            dr[i] = real.hi;
+            realsLo[i] = real.lo;
+            di[i] = imag.hi;
+            imagsLo[i] = imag.lo;
+        }
+        mandelbrotPointsDD(simd, dr, realsLo, di, imagsLo, count, row.MAX_ITER, opts, tolerance, iters);
+        return;
+    }
+
+    if (precision == PRECISION_FLOAT)
+    {
+        float realsF[EXP_MAP_CHUNK], imagsF[EXP_MAP_CHUNK];
+        for (int i = 0; i < count; i++)
+        {
+            realsF[i] = (float)(dr[i] + row.centerX);
+            imagsF[i] = (float)(di[i] + row.centerY);
+        }
+        mandelbrotPointsFloat(simd, realsF, imagsF, count, row.MAX_ITER, opts, tolerance, iters);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        dr[i] += row.centerX;
+        di[i] += row.centerY;
+    }
+    mandelbrotPoints(simd, dr, di, count, row.MAX_ITER, opts, tolerance, iters);
+}
+
+bool renderExpMap(ExpMap &map, const FrameRequest &req, double zoomFrom, const RenderOptions &opts, SimdLevel simd,
+                  ReferenceOrbit &orbit, BlaTable &bla)
+{
+    double scaleFrom = 4.0 / (req.WIDTH * zoomFrom);
+    double scaleTo = 4.0 / (req.WIDTH * req.zoom);
+    double halfDiagonal = 0.5 * sqrt((double)req.WIDTH * req.WIDTH + (double)req.HEIGHT * req.HEIGHT);
+
+    map.WIDTH = req.WIDTH;
+    map.HEIGHT = req.HEIGHT;
+    map.centerX = req.centerX;
+    map.centerY = req.centerY;
+    map.columns = (int)ceil(TWO_PI * halfDiagonal);
+    map.logStep = TWO_PI / map.columns;
+    map.rMax = scaleFrom * halfDiagonal;
+    // Bis zum halben Pixel des tiefsten Bildes, darunter liegt nur noch dessen Mittelpunkt;
+    // zwei Zeilen Reserve für das bilineare Abtasten
+    map.rows = (int)ceil(log(map.rMax / (0.5 * scaleTo)) / map.logStep) + 2;
+    map.iters = (uint16_t *)malloc(sizeof(uint16_t) * map.rows * (size_t)map.columns);
+    map.pixelColumn = (float *)malloc(sizeof(float) * req.WIDTH * (size_t)req.HEIGHT);
+    map.pixelLogRadius = (float *)malloc(sizeof(float) * req.WIDTH * (size_t)req.HEIGHT);
+    if (map.iters == NULL || map.pixelColumn == NULL || map.pixelLogRadius == NULL)
+    {
+        fprintf(stderr, "Out of memory for %d x %d exponential map\n", map.columns, map.rows);
+        freeExpMap(map);
+        return false;
+    }
+
+    // Referenzorbit und Precision des tiefsten Bildes; flachere Zeilen wählen selbst
+    FrameParams frame;
+    if (!prepareFrame(frame, req, opts, orbit, bla))
+    {
+        freeExpMap(map);
+        return false;
+    }
+    map.precision = frame.precision;
+    frame.centerXLo = decimalRemainder(req.centerXText, req.centerX);
+    frame.centerYLo = decimalRemainder(req.centerYText, req.centerY);
+
+    RenderOptions rowOpts = opts;
+    if (req.precision != PRECISION_AUTO)
+        rowOpts.precision = req.precision;
+
+    // Die BLA-Tabelle aus prepareFrame() gilt nur für |dc| bis zur Bildecke des tiefsten Bildes;
+    // hier muss sie bis zur äußersten Zeile mit Störungsrechnung reichen
+    if (frame.blaLevels > 0)
+    {
+        double dcMax = 0.0;
+        for (int k = 0; k < map.rows && dcMax == 0.0; k++)
+        {
+            double radius = map.rMax * exp(-k * map.logStep);
+            if (selectPrecision(rowOpts, fmax(radius / halfDiagonal, scaleTo), req.centerX, req.centerY) == PRECISION_PERTURBATION)
+                dcMax = radius;
+        }
+        frame.blaLevels = 0;
+        if (computeBlaTable(bla, orbit, dcMax))
+        {
+            frame.bla = bla.steps;
+            frame.blaLevels = bla.levels;
+            memcpy(frame.blaOffset, bla.offset, sizeof(bla.offset));
+        }
+    }
+
+#pragma omp parallel for schedule(runtime)
+    for (int k = 0; k < map.rows; k++)
+    {
+        // Pixelgröße des tiefsten Bildes, das diese Zeile noch in seinen Ecken abtastet
+        double radius = map.rMax * exp(-k * map.logStep);
+        double rowScale = fmax(radius / halfDiagonal, scaleTo);
+
+        FrameParams row = frame;
+        row.MAX_ITER = computeMaxIter(rowScale, req.WIDTH);
+        Precision precision = selectPrecision(rowOpts, rowScale, req.centerX, req.centerY);
+        double tolerance = periodTolerance(opts, rowScale);
+
+        uint16_t *out = map.iters + (size_t)k * map.columns;
+        int iters[EXP_MAP_CHUNK];
+        for (int j0 = 0; j0 < map.columns; j0 += EXP_MAP_CHUNK)
+        {
+            int count = map.columns - j0 < EXP_MAP_CHUNK ? map.columns - j0 : EXP_MAP_CHUNK;
+            computeCells(map, row, precision, radius, j0, count, opts, simd, tolerance, iters);
+            for (int i = 0; i < count; i++)
+                out[j0 + i] = (uint16_t)iters[i];
+        }
+    }
+
+    // Lage jedes Pixels im Streifen, gemessen in Pixeln vom Bildmittelpunkt; für alle Zooms gleich
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < req.HEIGHT; y++)
+    {
+        double di = req.HEIGHT / 2.0 - y;
+        for (int x = 0; x < req.WIDTH; x++)
+        {
+            double dr = x - req.WIDTH / 2.0;
+            double angle = atan2(di, dr);
+            if (angle < 0.0)
+                angle += TWO_PI;
+            float column = (float)(angle / map.logStep);
+            size_t index = (size_t)y * req.WIDTH + x;
+            // Knapp unter 2 pi kann die Rundung genau columns ergeben
+            map.pixelColumn[index] = (int)column < map.columns ? column : 0.0f;
+            // Der Mittelpunkt selbst liegt hinter der letzten Zeile
+            map.pixelLogRadius[index] = dr == 0.0 && di == 0.0 ? -1e30f : (float)(0.5 * log(dr * dr + di * di) / map.logStep);
+        }
+    }
+    return true;
+}
+
+void expMapFrame(const ExpMap &map, double zoom, const ColorOptions &colors, uint8_t *image)
+{
+    double scale = 4.0 / (map.WIDTH * zoom);
+    // Farben vorab pro Iterationszahl; ab der Grenze dieses Bildes gilt ein Punkt als innen, wie bei renderFrame()
+    int MAX_ITER = computeMaxIter(scale, map.WIDTH);
+    uint8_t *palette = (uint8_t *)malloc((size_t)3 * (MAX_ITER + 1));
+    if (palette == NULL)
+        return;
+    for (int i = 0; i <= MAX_ITER; i++)
+        iterToRGB(i, MAX_ITER, colors, palette[3 * i + 0], palette[3 * i + 1], palette[3 * i + 2]);
+
+    // Zeile eines Pixels: (ln rMax - ln scale - ln |Pixelabstand|) / logStep, nur der erste Teil hängt vom Zoom ab
+    double rowOffset = (log(map.rMax) - log(scale)) / map.logStep;
+    double lastRow = map.rows - 1;
+
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < map.HEIGHT; y++)
+    {
+        uint8_t *pixel = image + (size_t)3 * y * map.WIDTH;
+        size_t index = (size_t)y * map.WIDTH;
+
+        for (int x = 0; x < map.WIDTH; x++, pixel += 3, index++)
+        {
+            float u = map.pixelColumn[index];
+            double v = rowOffset - map.pixelLogRadius[index];
+            if (v < 0.0)
+                v = 0.0;
+            if (v > lastRow)
+                v = lastRow;
+
+            int j = (int)u;
+            int k = (int)v;
+            float fu = u - j;
+            float fv = (float)(v - k);
+            int j1 = j + 1 < map.columns ? j + 1 : 0;
+            int k1 = k + 1 < map.rows ? k + 1 : k;
+
+            const uint16_t *row0 = map.iters + (size_t)k * map.columns;
+            const uint16_t *row1 = map.iters + (size_t)k1 * map.columns;
+            const uint8_t *c00 = palette + 3 * (row0[j] < MAX_ITER ? row0[j] : MAX_ITER);
+            const uint8_t *c01 = palette + 3 * (row0[j1] < MAX_ITER ? row0[j1] : MAX_ITER);
+            const uint8_t *c10 = palette + 3 * (row1[j] < MAX_ITER ? row1[j] : MAX_ITER);
+            const uint8_t *c11 = palette + 3 * (row1[j1] < MAX_ITER ? row1[j1] : MAX_ITER);
+
+            float w00 = (1.0f - fu) * (1.0f - fv), w01 = fu * (1.0f - fv);
+            float w10 = (1.0f - fu) * fv, w11 = fu * fv;
+            for (int c = 0; c < 3; c++)
+                pixel[c] = (uint8_t)(w00 * c00[c] + w01 * c01[c] + w10 * c10[c] + w11 * c11[c] + 0.5f);
+        }
+    }
+    free(palette);
+}
+
+void freeExpMap(ExpMap &map)
+{
+    free(map.iters);
+    free(map.pixelColumn);
+    free(map.pixelLogRadius);
+    map.iters = NULL;
+    map.pixelColumn = NULL;
+    map.pixelLogRadius = NULL;
+}
@@ -0,0 +1,71 @@
+#ifndef EXP_MAP_H
+#define EXP_MAP_H
+
+#include <stdint.h>
+
+#include "../common/FractalProtocol.h"
+#include "../common/Perturbation.h"
+#include "FractalSimd.h"
+
+/*
+ * Exponentialkarte für Zoomvideos: statt jedes Bild einzeln zu rechnen, wird die Ebene einmal in
+ * logarithmischen Polarkoordinaten um das Zoomziel abgetastet. Spalte j ist der Winkel
+ * j * logStep, Zeile k der Radius rMax * exp(-k * logStep); weil Winkel- und Radiusschritt gleich
+ * sind, ist jede Zelle annähernd quadratisch. Ein Streifen von columns Spalten deckt so jede Oktave
+ * Zoom mit gleich vielen Zeilen ab, und jedes Bild des Videos entsteht durch Umrechnen seiner Pixel
+ * in (Winkel, ln r) und bilineares Abtasten des Streifens.
+ *
+ * columns ist so gewählt, dass ein Zellenabstand in den Bildecken einem Pixel entspricht; zur Mitte
+ * hin ist der Streifen überabgetastet.
+ */
+
+struct ExpMap
+{
+    int WIDTH, HEIGHT;
+    double centerX, centerY;
+    // Radius der Zeile 0: halbe Bilddiagonale beim flachsten Zoom
+    double rMax;
+    // Winkelschritt einer Spalte und Schritt in ln r einer Zeile
+    double logStep;
+    int columns, rows;
+    // Rechenverfahren der tiefsten Zeilen
+    Precision precision;
+    // Iterationen, rows x columns; MAX_ITER ist höchstens 8192 und passt in 16 Bit. Jede Zeile
+    // rechnet mit der Iterationsgrenze des tiefsten Bildes, das sie noch abtastet
+    uint16_t *iters;
+    // Pro Bildpixel, unabhängig vom Zoom: Spalte und ln(Abstand zur Bildmitte in Pixeln) / logStep
+    float *pixelColumn;
+    float *pixelLogRadius;
+};
+
+/**
+ * @brief Rechnet den Streifen für alle Zooms von zoomFrom bis req.zoom um das Zentrum der Anfrage.
+ * Jede Zeile nimmt das Rechenverfahren, das selectPrecision() für ihren Zellenabstand wählt; für
+ * Zeilen mit Störungsrechnung wird einmal der Referenzorbit des tiefsten Bildes berechnet.
+ *
+ * @param map Ergebnis, mit freeExpMap() freigeben
+ * @param req Zentrum, Bildformat und tiefster Zoom
+ * @param zoomFrom flachster Zoom
+ * @param opts
+ * @param simd
+ * @param orbit Speicher für den Referenzorbit
+ * @param bla Speicher für die BLA-Tabelle
+ * @return false bei fehlendem Speicher oder ungültigem Zentrum
+ */
+bool renderExpMap(ExpMap &map, const FrameRequest &req, double zoomFrom, const RenderOptions &opts, SimdLevel simd,
+                  ReferenceOrbit &orbit, BlaTable &bla);
+
+/**
+ * @brief Setzt aus dem Streifen ein Bild beim Zoom zoom zusammen, gleiche Pixelgeometrie und
+ * Färbung wie renderFrame().
+ *
+ * @param map
+ * @param zoom zwischen zoomFrom und req.zoom von renderExpMap()
+ * @param colors
+ * @param image RGB24-Puffer mit map.WIDTH * map.HEIGHT * 3 Bytes
+ */
+void expMapFrame(const ExpMap &map, double zoom, const ColorOptions &colors, uint8_t *image);
+
+void freeExpMap(ExpMap &map);
+
+#endif
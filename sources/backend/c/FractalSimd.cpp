@@ -0,0 +1,392 @@
+#include "FractalSimd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Punkte pro Aufruf von mandelbrotPoints() in mandelbrotRow(), Vielfaches von PERIODICITY_BLOCK
+#define ROW_POINTS 256
+
+
+SimdLevel detectSimdLevel()
+{
+#ifdef FRACTAL_SIMD_X86
+    // __builtin_cpu_supports liest CPUID und prüft über XGETBV auch, ob das
+    // Betriebssystem die breiten Register beim Kontextwechsel sichert.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_SSE2:
+        return "sse2";
+    case SIMD_AVX2:
+        return "avx2";
+    case SIMD_AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+bool parseSimdLevel(const char *name, SimdLevel &level)
+{
+    for (int i = SIMD_SCALAR; i <= SIMD_AVX512; i++)
+    {
+        if (strcmp(name, simdLevelName((SimdLevel)i)) == 0)
+        {
+            level = (SimdLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Skalare Referenz: ruft computeIterations() für jeden Punkt auf.
+ */
+static void mandelbrotPointsScalar(const double *real, const double *imag, int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters,
+                                   bool previousInside, float *norms)
+{
+    bool periodic = false;
+    bool blockInside = previousInside;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i % PERIODICITY_BLOCK == 0)
+        {
+            periodic = tolerance >= 0.0 && blockInside;
+            blockInside = false;
+        }
+
+        iters[i] = computeIterations(real[i], imag[i], max_iter, opts, periodic ? tolerance : -1.0, norms != NULL ? norms + i : NULL);
+
+        if (iters[i] == max_iter)
+            blockInside = true;
+    }
+}
+
+void mandelbrotPoints(SimdLevel level, const double *real, const double *imag, int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters,
+                      bool previousInside, float *norms)
+{
+    switch (level)
+    {
+#ifdef FRACTAL_SIMD_X86
+    case SIMD_AVX512:
+        mandelbrotPointsAvx512(real, imag, count, max_iter, opts.interiorCheck, tolerance, iters, previousInside, norms);
+        break;
+    case SIMD_AVX2:
+        mandelbrotPointsAvx2(real, imag, count, max_iter, opts.interiorCheck, tolerance, iters, previousInside, norms);
+        break;
+    case SIMD_SSE2:
+        mandelbrotPointsSse2(real, imag, count, max_iter, opts.interiorCheck, tolerance, iters, previousInside, norms);
+        break;
+#endif
+    default:
+        mandelbrotPointsScalar(real, imag, count, max_iter, opts, tolerance, iters, previousInside, norms);
+        break;
+    }
+}
+
+/**
+ * @brief Skalare Referenz in float, gleiche Blockregel wie mandelbrotPointsScalar().
+ */
+static void mandelbrotPointsFloatScalar(const float *real, const float *imag, int count, int max_iter, const RenderOptions &opts, float tolerance, int *iters,
+                                        bool previousInside, float *norms)
+{
+    bool periodic = false;
+    bool blockInside = previousInside;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i % PERIODICITY_BLOCK == 0)
+        {
+            periodic = tolerance >= 0.0f && blockInside;
+            blockInside = false;
+        }
+
+        iters[i] = computeIterations(real[i], imag[i], max_iter, opts, periodic ? tolerance : -1.0f, norms != NULL ? norms + i : NULL);
+
+        if (iters[i] == max_iter)
+            blockInside = true;
+    }
+}
+
+void mandelbrotPointsFloat(SimdLevel level, const float *real, const float *imag, int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters,
+                           bool previousInside, float *norms)
+{
+    float ftolerance = (float)tolerance;
+    switch (level)
+    {
+#ifdef FRACTAL_SIMD_X86
+    case SIMD_AVX512:
+        mandelbrotPointsFloatAvx512(real, imag, count, max_iter, opts.interiorCheck, ftolerance, iters, previousInside, norms);
+        break;
+    case SIMD_AVX2:
+        mandelbrotPointsFloatAvx2(real, imag, count, max_iter, opts.interiorCheck, ftolerance, iters, previousInside, norms);
+        break;
+    case SIMD_SSE2:
+        mandelbrotPointsFloatSse2(real, imag, count, max_iter, opts.interiorCheck, ftolerance, iters, previousInside, norms);
+        break;
+#endif
+    default:
+        mandelbrotPointsFloatScalar(real, imag, count, max_iter, opts, ftolerance, iters, previousInside, norms);
+        break;
+    }
+}
+
+/**
+ * @brief Skalare Referenz in Double-Double, gleiche Blockregel wie mandelbrotPointsScalar().
+ */
+static void mandelbrotPointsDDScalar(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                                     int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters, float *norms)
+{
+    bool periodic = false;
+    bool blockInside = true;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i % PERIODICITY_BLOCK == 0)
+        {
+            periodic = tolerance >= 0.0 && blockInside;
+            blockInside = false;
+        }
+
+        DoubleDouble real(realHi[i], realLo[i]);
+        DoubleDouble imag(imagHi[i], imagLo[i]);
+        iters[i] = computeIterations(real, imag, max_iter, opts, periodic ? tolerance : -1.0, norms != NULL ? norms + i : NULL);
+
+        if (iters[i] == max_iter)
+            blockInside = true;
+    }
+}
+
+void mandelbrotPointsDD(SimdLevel level, const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                        int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters, float *norms)
+{
+    switch (level)
+    {
+#ifdef FRACTAL_SIMD_X86
+    case SIMD_AVX512:
+        mandelbrotPointsDDAvx512(realHi, realLo, imagHi, imagLo, count, max_iter, opts.interiorCheck, tolerance, iters, norms);
+        break;
+    case SIMD_AVX2:
+        mandelbrotPointsDDAvx2(realHi, realLo, imagHi, imagLo, count, max_iter, opts.interiorCheck, tolerance, iters, norms);
+        break;
+    case SIMD_SSE2:
+        mandelbrotPointsDDSse2(realHi, realLo, imagHi, imagLo, count, max_iter, opts.interiorCheck, tolerance, iters, norms);
+        break;
+#endif
+    default:
+        mandelbrotPointsDDScalar(realHi, realLo, imagHi, imagLo, count, max_iter, opts, tolerance, iters, norms);
+        break;
+    }
+}
+
+void mandelbrotRow(SimdLevel level, double scale, double centerX, double imag, int WIDTH, int x0, int count, int max_iter, const RenderOptions &opts, int *iters,
+                   bool previousInside, float *norms)
+{
+    double tolerance = periodTolerance(opts, scale);
+    double reals[ROW_POINTS];
+    double imags[ROW_POINTS];
+
+    for (int i = 0; i < ROW_POINTS; i++)
+        imags[i] = imag;
+
+    for (int start = 0; start < count; start += ROW_POINTS)
+    {
+        int n = count - start < ROW_POINTS ? count - start : ROW_POINTS;
+        for (int i = 0; i < n; i++)
+        {
+            reals[i] = (x0 + start + i - WIDTH / 2.0) * scale + centerX;
+        }
+        mandelbrotPoints(level, reals, imags, n, max_iter, opts, tolerance, iters + start, start == 0 ? previousInside : true,
+                         norms != NULL ? norms + start : NULL);
+    }
+}
+
+void mandelbrotRowFloat(SimdLevel level, double scale, double centerX, double imag, int WIDTH, int x0, int count, int max_iter, const RenderOptions &opts, int *iters,
+                        bool previousInside, float *norms)
+{
+    double tolerance = periodTolerance(opts, scale);
+    float reals[ROW_POINTS];
+    float imags[ROW_POINTS];
+
+    for (int i = 0; i < ROW_POINTS; i++)
+        imags[i] = (float)imag;
+
+    for (int start = 0; start < count; start += ROW_POINTS)
+    {
+        int n = count - start < ROW_POINTS ? count - start : ROW_POINTS;
+        for (int i = 0; i < n; i++)
+        {
+            reals[i] = (float)((x0 + start + i - WIDTH / 2.0) * scale + centerX);
+        }
+        mandelbrotPointsFloat(level, reals, imags, n, max_iter, opts, tolerance, iters + start, start == 0 ? previousInside : true,
+                         norms != NULL ? norms + start : NULL);
+    }
+}
+
+void mandelbrotRowDD(SimdLevel level, double scale, const DoubleDouble &centerX, const DoubleDouble &imag, int WIDTH, int x0, int count, int max_iter,
+                     const RenderOptions &opts, int *iters, float *norms)
+{
+    double tolerance = periodTolerance(opts, scale);
+    double realHi[ROW_POINTS], realLo[ROW_POINTS];
+    double imagHi[ROW_POINTS], imagLo[ROW_POINTS];
+
+    for (int i = 0; i < ROW_POINTS; i++)
+    {
+        imagHi[i] = imag.hi;
+        imagLo[i] = imag.lo;
+    }
+
+    for (int start = 0; start < count; start += ROW_POINTS)
+    {
+        int n = count - start < ROW_POINTS ? count - start : ROW_POINTS;
+        for (int i = 0; i < n; i++)
+        {
+            DoubleDouble real = centerX + (x0 + start + i - WIDTH / 2.0) * scale;
+            realHi[i] = real.hi;
+            realLo[i] = real.lo;
+        }
+        mandelbrotPointsDD(level, realHi, realLo, imagHi, imagLo, n, max_iter, opts, tolerance, iters + start, norms != NULL ? norms + start : NULL);
+    }
+}
+
+// Testansicht für verifySimdKernels()
+struct VerifyView
+{
+    double zoom, centerX, centerY;
+    int WIDTH, HEIGHT;
+    Precision precision;
+};
+
+/**
+ * @brief Eine Zeile einer Testansicht mit dem Kernel level, in der Genauigkeit der Ansicht.
+ * norms ist vorher mit 0 gefüllt, damit die Punkte mit max_iter auch skalar 0 behalten.
+ */
+static void verifyRow(SimdLevel level, const VerifyView &view, double scale, int y, int MAX_ITER, const RenderOptions &opts, int *iters,
+                      float *norms)
+{
+    double offset = (view.HEIGHT / 2.0 - y) * scale;
+    memset(norms, 0, sizeof(float) * view.WIDTH);
+    if (view.precision == PRECISION_FLOAT)
+    {
+        mandelbrotRowFloat(level, scale, view.centerX, offset + view.centerY, view.WIDTH, 0, view.WIDTH, MAX_ITER, opts, iters, true, norms);
+    }
+    else if (view.precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        DoubleDouble imag = DoubleDouble(view.centerY) + offset;
+        mandelbrotRowDD(level, scale, DoubleDouble(view.centerX), imag, view.WIDTH, 0, view.WIDTH, MAX_ITER, opts, iters, norms);
+    }
+    else
+    {
+        mandelbrotRow(level, scale, view.centerX, offset + view.centerY, view.WIDTH, 0, view.WIDTH, MAX_ITER, opts, iters, true, norms);
+    }
+}
+
+/**
+ * @brief Rechnet eine Testansicht mit dem Kernel level und skalar und zählt die abweichenden Pixel,
+ * in den Iterationen oder in escapeNorm().
+ *
+ * @param level
+ * @param view
+ * @param opts
+ * @param pixels wird um die Anzahl der geprüften Pixel erhöht
+ * @return Anzahl abweichender Pixel, -1 bei fehlendem Speicher
+ */
+static long countMismatches(SimdLevel level, const VerifyView &view, const RenderOptions &opts, long &pixels)
+{
+    double scale = 4.0 / (view.WIDTH * view.zoom);
+    int MAX_ITER = computeMaxIter(scale, view.WIDTH);
+
+    int *expected = (int *)malloc(sizeof(int) * view.WIDTH);
+    int *actual = (int *)malloc(sizeof(int) * view.WIDTH);
+    float *expectedNorms = (float *)malloc(sizeof(float) * view.WIDTH);
+    float *actualNorms = (float *)malloc(sizeof(float) * view.WIDTH);
+    long mismatches = -1;
+    if (expected != NULL && actual != NULL && expectedNorms != NULL && actualNorms != NULL)
+    {
+        mismatches = 0;
+        for (int y = 0; y < view.HEIGHT; y++)
+        {
+            verifyRow(SIMD_SCALAR, view, scale, y, MAX_ITER, opts, expected, expectedNorms);
+            verifyRow(level, view, scale, y, MAX_ITER, opts, actual, actualNorms);
+
+            for (int x = 0; x < view.WIDTH; x++)
+            {
+                if (expected[x] != actual[x] || expectedNorms[x] != actualNorms[x])
+                    mismatches++;
+            }
+            pixels += view.WIDTH;
+        }
+    }
+    free(expected);
+    free(actual);
+    free(expectedNorms);
+    free(actualNorms);
+    return mismatches;
+}
+
+bool verifySimdKernels()
+{
+    // Ansichten aus docs/cuda measurments, verkleinert, plus Ausschnitte mit vielen Randpixeln
+    // und großen Flächen in der Menge außerhalb der Kardioide, je in der passenden Genauigkeit
+    const VerifyView views[] = {
+        {1.0, 0.0, 0.0, 203, 97, PRECISION_DOUBLE},
+        {100.0, 0.5, 0.5, 250, 250, PRECISION_DOUBLE},
+        {6.884310827443782E9, -1.484610808411835, -4.721191790807227E-10, 131, 67, PRECISION_DOUBLE},
+        {2500.0, -0.7436447860, 0.1318252536, 161, 83, PRECISION_DOUBLE},
+        {8.0, -0.12, 0.75, 120, 90, PRECISION_DOUBLE},
+        {1.0, 0.0, 0.0, 203, 97, PRECISION_FLOAT},
+        {8.0, -0.12, 0.75, 120, 90, PRECISION_FLOAT},
+        {50.0, -0.7436447860, 0.1318252536, 161, 83, PRECISION_FLOAT},
+        {1.0, 0.0, 0.0, 101, 49, PRECISION_DOUBLE_DOUBLE},
+        {1e15, -0.7436451337453429, 0.13182587861695685, 97, 53, PRECISION_DOUBLE_DOUBLE},
+        {1e18, -0.7436451337453429, 0.13182587861695685, 67, 41, PRECISION_DOUBLE_DOUBLE},
+    };
+    const int viewCount = (int)(sizeof(views) / sizeof(views[0]));
+
+    // Jede Option einmal an und aus, da die SIMD-Kernel dafür eigenen Code haben
+    RenderOptions variants[3];
+    variants[1].interiorCheck = false;
+    variants[2].periodicityCheck = false;
+    const int variantCount = (int)(sizeof(variants) / sizeof(variants[0]));
+
+    SimdLevel best = detectSimdLevel();
+    bool allOk = true;
+
+    for (int level = SIMD_SSE2; level <= best; level++)
+    {
+        long mismatches = 0;
+        long pixels = 0;
+
+        for (int v = 0; v < viewCount; v++)
+        {
+            for (int o = 0; o < variantCount; o++)
+            {
+                long m = countMismatches((SimdLevel)level, views[v], variants[o], pixels);
+                if (m < 0)
+                    return false;
+                mismatches += m;
+            }
+        }
+
+        fprintf(stderr, "SIMD verify %-6s: %ld of %ld pixels differ from scalar reference -> %s\n",
+                simdLevelName((SimdLevel)level), mismatches, pixels, mismatches == 0 ? "OK" : "FAILED");
+        if (mismatches != 0)
+            allOk = false;
+    }
+    fflush(stderr);
+    return allOk;
+}
@@ -0,0 +1,171 @@
+#ifndef FRACTAL_SIMD_H
+#define FRACTAL_SIMD_H
+
+/*
+ * Vektorisierte Escape-Time-Kernel für die CPU. Die Kernel für SSE2, AVX2 und
+ * AVX-512 liegen in eigenen Übersetzungseinheiten, die per #pragma GCC target
+ * für ihren Befehlssatz übersetzt werden. Welcher Kernel läuft, entscheidet
+ * detectSimdLevel() zur Laufzeit über CPUID, so dass ein Binary auf allen
+ * Rechnern läuft.
+ *
+ * Alle Kernel rechnen dieselbe Operationsfolge wie mandelbrot() und liefern
+ * daher bitgleiche Iterationszahlen. Voraussetzung ist, dass der Compiler keine
+ * Multiplikationen und Additionen zu FMA zusammenzieht: die Kernel-Dateien setzen
+ * dafür fp-contract=off, für den skalaren Pfad steht -ffp-contract=off in
+ * docs/makescript. verifySimdKernels() prüft das.
+ */
+#include "../common/FractalCore.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FRACTAL_SIMD_X86 1
+#endif
+
+/*
+ * Die Zykluserkennung kostet bei entkommenden Punkten Zeit und bringt nur innen etwas.
+ * Wie bei Fractint wird sie deshalb nur eingeschaltet, wenn im vorigen Block von
+ * PERIODICITY_BLOCK Pixeln ein Punkt max_iter erreicht hat (und im ersten Block eines
+ * Aufrufs). Der Block ist ein Vielfaches aller Lane-Breiten, so treffen skalarer Pfad
+ * und alle SIMD-Kernel dieselbe Entscheidung.
+ */
+#define PERIODICITY_BLOCK 16
+
+enum SimdLevel
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE2 = 1,
+    SIMD_AVX2 = 2,
+    SIMD_AVX512 = 3
+};
+
+/**
+ * @brief Ermittelt per CPUID den besten Befehlssatz, den CPU und Betriebssystem unterstützen.
+ *
+ * @return SimdLevel
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Name eines SimdLevel für Logausgaben ("scalar", "sse2", "avx2", "avx512").
+ *
+ * @param level
+ * @return Name
+ */
+const char *simdLevelName(SimdLevel level);
+
+/**
+ * @brief Wandelt einen Namen wie bei simdLevelName() zurück in ein SimdLevel.
+ *
+ * @param name
+ * @param level Ergebnis
+ * @return true, wenn der Name bekannt ist
+ */
+bool parseSimdLevel(const char *name, SimdLevel &level);
+
+/**
+ * @brief Berechnet die Iterationen für count beliebige Punkte, S::LANES Punkte gleichzeitig.
+ * Die Periodizitätsprüfung gilt pro Aufruf nach der Blockregel von PERIODICITY_BLOCK.
+ *
+ * @param level zu verwendender Kernel, höchstens detectSimdLevel()
+ * @param real Realteile, count Einträge
+ * @param imag Imaginärteile, count Einträge
+ * @param count Anzahl der Punkte
+ * @param max_iter
+ * @param opts
+ * @param tolerance Ergebnis von periodTolerance() für das aktuelle Bild
+ * @param iters Ausgabe, count Einträge
+ * @param previousInside ob im Block vor real[0] ein Punkt max_iter erreicht hat. Damit rechnet ein
+ * Teilstück an einer Blockgrenze wie als Teil eines längeren Aufrufs; true am Anfang eines Aufrufs.
+ * @param norms wenn nicht NULL: Ausgabe, count Einträge escapeNorm() für smoothIterations(),
+ * 0 für Punkte mit max_iter
+ * @return void
+ */
+void mandelbrotPoints(SimdLevel level, const double *real, const double *imag, int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters,
+                      bool previousInside = true, float *norms = NULL);
+
+/**
+ * @brief Berechnet die Iterationen für count Pixel einer Bildzeile ab Spalte x0.
+ * Der Realteil eines Pixels ist wie in render() (x - WIDTH / 2.0) * scale + centerX.
+ *
+ * @param level zu verwendender Kernel, höchstens detectSimdLevel()
+ * @param scale
+ * @param centerX
+ * @param imag Imaginärteil der Zeile
+ * @param WIDTH
+ * @param x0 erste Spalte
+ * @param count Anzahl der Pixel
+ * @param max_iter
+ * @param opts
+ * @param iters Ausgabe, count Einträge
+ * @param previousInside wie bei mandelbrotPoints(), für den ersten Aufruf
+ * @param norms wie bei mandelbrotPoints()
+ * @return void
+ */
+void mandelbrotRow(SimdLevel level, double scale, double centerX, double imag, int WIDTH, int x0, int count, int max_iter, const RenderOptions &opts, int *iters,
+                   bool previousInside = true, float *norms = NULL);
+
+/**
+ * @brief Wie mandelbrotPoints(), aber in float mit doppelt so vielen Lanes. tolerance wird auf float
+ * gerundet wie in pixelIterations().
+ *
+ * @return void
+ */
+void mandelbrotPointsFloat(SimdLevel level, const float *real, const float *imag, int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters,
+                           bool previousInside = true, float *norms = NULL);
+
+/**
+ * @brief Wie mandelbrotRow(), aber in float. Der Realteil eines Pixels wird in double berechnet
+ * und erst dann gerundet, wie in pixelIterations().
+ *
+ * @return void
+ */
+void mandelbrotRowFloat(SimdLevel level, double scale, double centerX, double imag, int WIDTH, int x0, int count, int max_iter, const RenderOptions &opts, int *iters,
+                        bool previousInside = true, float *norms = NULL);
+
+/**
+ * @brief Wie mandelbrotPoints(), aber in Double-Double: Punkt i ist realHi[i] + realLo[i], imagHi[i] + imagLo[i].
+ *
+ * @return void
+ */
+void mandelbrotPointsDD(SimdLevel level, const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                        int count, int max_iter, const RenderOptions &opts, double tolerance, int *iters, float *norms = NULL);
+
+/**
+ * @brief Wie mandelbrotRow(), aber in Double-Double. Der Realteil eines Pixels ist wie in
+ * pixelIterations() centerX + (x - WIDTH / 2.0) * scale.
+ *
+ * @return void
+ */
+void mandelbrotRowDD(SimdLevel level, double scale, const DoubleDouble &centerX, const DoubleDouble &imag, int WIDTH, int x0, int count, int max_iter,
+                     const RenderOptions &opts, int *iters, float *norms = NULL);
+
+/**
+ * @brief Vergleicht alle auf diesem Rechner lauffähigen Kernel (float, double und Double-Double) mit der
+ * skalaren Referenz mandelbrot().
+ * Gibt das Ergebnis pro Kernel auf stderr aus.
+ *
+ * @return true, wenn alle Iterationszahlen bitgleich sind
+ */
+bool verifySimdKernels();
+
+#ifdef FRACTAL_SIMD_X86
+void mandelbrotPointsSse2(const double *real, const double *imag, int count, int max_iter, bool interiorCheck, double tolerance, int *iters,
+                          bool previousInside, float *norms);
+void mandelbrotPointsAvx2(const double *real, const double *imag, int count, int max_iter, bool interiorCheck, double tolerance, int *iters,
+                          bool previousInside, float *norms);
+void mandelbrotPointsAvx512(const double *real, const double *imag, int count, int max_iter, bool interiorCheck, double tolerance, int *iters,
+                            bool previousInside, float *norms);
+void mandelbrotPointsFloatSse2(const float *real, const float *imag, int count, int max_iter, bool interiorCheck, float tolerance, int *iters,
+                               bool previousInside, float *norms);
+void mandelbrotPointsFloatAvx2(const float *real, const float *imag, int count, int max_iter, bool interiorCheck, float tolerance, int *iters,
+                               bool previousInside, float *norms);
+void mandelbrotPointsFloatAvx512(const float *real, const float *imag, int count, int max_iter, bool interiorCheck, float tolerance, int *iters,
+                                 bool previousInside, float *norms);
+void mandelbrotPointsDDSse2(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                            int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms);
+void mandelbrotPointsDDAvx2(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                            int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms);
+void mandelbrotPointsDDAvx512(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                              int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms);
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+#include "FractalSimd.h"
+
+#ifdef FRACTAL_SIMD_X86
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")
+
+#include "FractalSimdKernel.h"
+
+namespace
+{
+
+struct Avx2Double
+{
+    typedef double Scalar;
+    typedef __m256d Vec;
+    typedef __m256d Mask;
+    static const int LANES = 4;
+
+    static inline Vec set1(double v) { return _mm256_set1_pd(v); }
+    static inline Vec load(const double *p) { return _mm256_loadu_pd(p); }
+    static inline void store(double *p, Vec v) { _mm256_storeu_pd(p, v); }
+    static inline Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+    static inline Vec abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static inline Mask cmple(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static inline Mask maskAnd(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+    static inline Mask maskOr(Mask a, Mask b) { return _mm256_or_pd(a, b); }
+    static inline Mask maskAndNot(Mask a, Mask b) { return _mm256_andnot_pd(a, b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b, a, m); }
+    static inline Mask allTrue() { return _mm256_castsi256_pd(_mm256_set1_epi32(-1)); }
+    static inline bool any(Mask m) { return _mm256_movemask_pd(m) != 0; }
+    static inline Vec addIfActive(Vec c, Mask m) { return _mm256_add_pd(c, _mm256_and_pd(m, _mm256_set1_pd(1.0))); }
+};
+
+struct Avx2Float
+{
+    typedef float Scalar;
+    typedef __m256 Vec;
+    typedef __m256 Mask;
+    static const int LANES = 8;
+
+    static inline Vec set1(float v) { return _mm256_set1_ps(v); }
+    static inline Vec load(const float *p) { return _mm256_loadu_ps(p); }
+    static inline void store(float *p, Vec v) { _mm256_storeu_ps(p, v); }
+    static inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    static inline Vec abs(Vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static inline Mask cmple(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static inline Mask maskAnd(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static inline Mask maskOr(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    static inline Mask maskAndNot(Mask a, Mask b) { return _mm256_andnot_ps(a, b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+    static inline Mask allTrue() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    static inline bool any(Mask m) { return _mm256_movemask_ps(m) != 0; }
+    static inline Vec addIfActive(Vec c, Mask m) { return _mm256_add_ps(c, _mm256_and_ps(m, _mm256_set1_ps(1.0f))); }
+};
+
+}
+
+void mandelbrotPointsAvx2(const double *real, const double *imag, int count, int max_iter, bool interiorCheck, double tolerance, int *iters,
+                          bool previousInside, float *norms)
+{
+    escapeTimePoints<Avx2Double>(real, imag, count, max_iter, interiorCheck, tolerance, iters, previousInside, norms);
+}
+
+void mandelbrotPointsDDAvx2(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                            int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms)
+{
+    escapeTimePointsDD<Avx2Double>(realHi, realLo, imagHi, imagLo, count, max_iter, interiorCheck, tolerance, iters, norms);
+}
+
+void mandelbrotPointsFloatAvx2(const float *real, const float *imag, int count, int max_iter, bool interiorCheck, float tolerance, int *iters,
+                               bool previousInside, float *norms)
+{
+    escapeTimePoints<Avx2Float>(real, imag, count, max_iter, interiorCheck, tolerance, iters, previousInside, norms);
+}
+
+#pragma GCC pop_options
+
+#endif
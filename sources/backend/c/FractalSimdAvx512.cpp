@@ -0,0 +1,86 @@
+#include "FractalSimd.h"
+
+#ifdef FRACTAL_SIMD_X86
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+
+#include "FractalSimdKernel.h"
+
+namespace
+{
+
+struct Avx512Double
+{
+    typedef double Scalar;
+    typedef __m512d Vec;
+    typedef __mmask8 Mask;
+    static const int LANES = 8;
+
+    static inline Vec set1(double v) { return _mm512_set1_pd(v); }
+    static inline Vec load(const double *p) { return _mm512_loadu_pd(p); }
+    static inline void store(double *p, Vec v) { _mm512_storeu_pd(p, v); }
+    static inline Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+    static inline Vec abs(Vec a) { return _mm512_abs_pd(a); }
+    static inline Mask cmple(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+    static inline Mask maskAnd(Mask a, Mask b) { return (Mask)(a & b); }
+    static inline Mask maskOr(Mask a, Mask b) { return (Mask)(a | b); }
+    static inline Mask maskAndNot(Mask a, Mask b) { return (Mask)(~a & b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m, b, a); }
+    static inline Mask allTrue() { return (Mask)0xFF; }
+    static inline bool any(Mask m) { return m != 0; }
+    static inline Vec addIfActive(Vec c, Mask m) { return _mm512_mask_add_pd(c, m, c, _mm512_set1_pd(1.0)); }
+};
+
+struct Avx512Float
+{
+    typedef float Scalar;
+    typedef __m512 Vec;
+    typedef __mmask16 Mask;
+    static const int LANES = 16;
+
+    static inline Vec set1(float v) { return _mm512_set1_ps(v); }
+    static inline Vec load(const float *p) { return _mm512_loadu_ps(p); }
+    static inline void store(float *p, Vec v) { _mm512_storeu_ps(p, v); }
+    static inline Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+    static inline Vec abs(Vec a) { return _mm512_abs_ps(a); }
+    static inline Mask cmple(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static inline Mask maskAnd(Mask a, Mask b) { return (Mask)(a & b); }
+    static inline Mask maskOr(Mask a, Mask b) { return (Mask)(a | b); }
+    static inline Mask maskAndNot(Mask a, Mask b) { return (Mask)(~a & b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+    static inline Mask allTrue() { return (Mask)0xFFFF; }
+    static inline bool any(Mask m) { return m != 0; }
+    static inline Vec addIfActive(Vec c, Mask m) { return _mm512_mask_add_ps(c, m, c, _mm512_set1_ps(1.0f)); }
+};
+
+}
+
+void mandelbrotPointsAvx512(const double *real, const double *imag, int count, int max_iter, bool interiorCheck, double tolerance, int *iters,
+                            bool previousInside, float *norms)
+{
+    escapeTimePoints<Avx512Double>(real, imag, count, max_iter, interiorCheck, tolerance, iters, previousInside, norms);
+}
+
+void mandelbrotPointsDDAvx512(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                              int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms)
+{
+    escapeTimePointsDD<Avx512Double>(realHi, realLo, imagHi, imagLo, count, max_iter, interiorCheck, tolerance, iters, norms);
+}
+
+void mandelbrotPointsFloatAvx512(const float *real, const float *imag, int count, int max_iter, bool interiorCheck, float tolerance, int *iters,
+                                 bool previousInside, float *norms)
+{
+    escapeTimePoints<Avx512Float>(real, imag, count, max_iter, interiorCheck, tolerance, iters, previousInside, norms);
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef FRACTAL_SIMD_KERNEL_H
+#define FRACTAL_SIMD_KERNEL_H
+
+/*
+ * Generischer Escape-Time-Kernel über eine Trait-Klasse S, die die Intrinsics
+ * eines Befehlssatzes kapselt (Vec, Mask, LANES, set1, add, ...). Wird nur von
+ * den FractalSimd*.cpp-Dateien nach ihrem #pragma GCC target eingebunden und
+ * darf deshalb selbst keine Header mit Inline-Funktionen einziehen: diese würden
+ * sonst mit dem erweiterten Befehlssatz übersetzt und könnten vom Linker auch für
+ * den skalaren Pfad ausgewählt werden.
+ */
+
+/**
+ * @brief Lädt S::LANES Werte ab p[base]. Überzählige Lanes am Ende (lanes < S::LANES) wiederholen
+ * den letzten Wert und kosten so nichts extra.
+ */
+template <class S>
+inline typename S::Vec loadPadded(const typename S::Scalar *p, int base, int lanes)
+{
+    if (lanes == S::LANES)
+        return S::load(p + base);
+
+    typename S::Scalar values[S::LANES];
+    for (int i = 0; i < S::LANES; i++)
+        values[i] = p[base + (i < lanes ? i : lanes - 1)];
+    return S::load(values);
+}
+
+/**
+ * @brief Berechnet die Iterationen für count Punkte, jeweils S::LANES Punkte gleichzeitig.
+ * Eine Lane-Gruppe wird erst verlassen, wenn alle Lanes entkommen sind oder max_iter erreicht ist;
+ * entkommene Lanes rechnen maskiert weiter, zählen aber nicht mehr.
+ * Die Periodizitätsprüfung folgt pro Block von PERIODICITY_BLOCK Pixeln derselben Regel wie
+ * mandelbrotPointsScalar(), damit alle Kernel bitgleich bleiben; previousInside ist der Zustand vor
+ * dem ersten Block, siehe mandelbrotPoints(). Gerechnet wird in S::Scalar
+ * (double oder float), auch die Zähler: bis 2^24 sind sie in float exakt.
+ * Mit norms wird escapeNorm() mitgeschrieben (0 für Punkte mit max_iter): z beim Entkommen wird
+ * festgehalten und danach wie dort SMOOTH_EXTRA_ITER Schritte weiter iteriert.
+ */
+template <class S>
+inline void escapeTimePoints(const typename S::Scalar *real, const typename S::Scalar *imag, int count, int max_iter, bool interiorCheck,
+                             typename S::Scalar tolerance, int *iters, bool previousInside, float *norms)
+{
+    typedef typename S::Vec Vec;
+    typedef typename S::Mask Mask;
+    typedef typename S::Scalar Real;
+
+    const Vec two = S::set1(2.0);
+    const Vec four = S::set1(4.0);
+    const Vec one = S::set1(1.0);
+    const Vec quarter = S::set1(0.25);
+    const Vec sixteenth = S::set1(0.0625);
+    const Vec maxIter = S::set1((Real)max_iter);
+    const Vec vtolerance = S::set1(tolerance);
+
+    bool periodic = false;
+    bool blockInside = previousInside;
+
+    for (int base = 0; base < count; base += S::LANES)
+    {
+        int lanes = count - base < S::LANES ? count - base : S::LANES;
+
+        if (base % PERIODICITY_BLOCK == 0)
+        {
+            periodic = tolerance >= 0 && blockInside;
+            blockInside = false;
+        }
+
+        Vec cr = loadPadded<S>(real, base, lanes);
+        Vec ci = loadPadded<S>(imag, base, lanes);
+
+        Vec zr = S::set1(0.0);
+        Vec zi = S::set1(0.0);
+        Vec counts = S::set1(0.0);
+        Vec escapeNorm = S::set1(0.0);
+        Vec escapeR = S::set1(0.0);
+        Vec escapeI = S::set1(0.0);
+        Vec savedR = S::set1(0.0);
+        Vec savedI = S::set1(0.0);
+        int check = 0, checkLimit = 1;
+        Mask active = S::allTrue();
+
+        if (interiorCheck)
+        {
+            // Gleiche Operationsfolge wie isInMainCardioidOrBulb()
+            Vec xm = S::sub(cr, quarter);
+            Vec y2 = S::mul(ci, ci);
+            Vec q = S::add(S::mul(xm, xm), y2);
+            Mask inside = S::cmple(S::mul(q, S::add(q, xm)), S::mul(quarter, y2));
+            Vec xp = S::add(cr, one);
+            inside = S::maskOr(inside, S::cmple(S::add(S::mul(xp, xp), y2), sixteenth));
+
+            counts = S::select(inside, maxIter, counts);
+            active = S::maskAndNot(inside, active);
+        }
+
+        for (int k = 0; k < max_iter; k++)
+        {
+            Vec zr2 = S::mul(zr, zr);
+            Vec zi2 = S::mul(zi, zi);
+            Vec norm = S::add(zr2, zi2);
+            Mask bounded = S::cmple(norm, four);
+            if (norms != NULL)
+            {
+                Mask escaping = S::maskAndNot(bounded, active);
+                escapeNorm = S::select(escaping, norm, escapeNorm);
+                escapeR = S::select(escaping, zr, escapeR);
+                escapeI = S::select(escaping, zi, escapeI);
+            }
+            active = S::maskAnd(active, bounded);
+            if (!S::any(active))
+                break;
+
+            Vec temp = S::add(S::sub(zr2, zi2), cr);
+            zi = S::add(S::mul(S::mul(two, zr), zi), ci);
+            zr = temp;
+            counts = S::addIfActive(counts, active);
+
+            if (periodic)
+            {
+                // Gleiche Regel wie in mandelbrot(): Zyklus gefunden -> max_iter
+                Mask near = S::maskAnd(S::cmple(S::abs(S::sub(zr, savedR)), vtolerance),
+                                       S::cmple(S::abs(S::sub(zi, savedI)), vtolerance));
+                Mask hit = S::maskAnd(active, near);
+                counts = S::select(hit, maxIter, counts);
+                active = S::maskAndNot(hit, active);
+
+                if (++check == checkLimit)
+                {
+                    savedR = zr;
+                    savedI = zi;
+                    check = 0;
+                    checkLimit *= 2;
+                }
+            }
+        }
+
+        Real out[S::LANES];
+        S::store(out, counts);
+        for (int i = 0; i < lanes; i++)
+        {
+            iters[base + i] = (int)out[i];
+            if (iters[base + i] == max_iter)
+                blockInside = true;
+        }
+        if (norms != NULL)
+        {
+            // Wie escapeNorm(); Lanes, die nicht entkommen sind, behalten 0
+            for (int k = 0; k < SMOOTH_EXTRA_ITER; k++)
+            {
+                Vec temp = S::add(S::sub(S::mul(escapeR, escapeR), S::mul(escapeI, escapeI)), cr);
+                escapeI = S::add(S::mul(S::mul(two, escapeR), escapeI), ci);
+                escapeR = temp;
+            }
+            Vec extended = S::add(S::mul(escapeR, escapeR), S::mul(escapeI, escapeI));
+            escapeNorm = S::select(S::cmple(escapeNorm, four), escapeNorm, extended);
+            S::store(out, escapeNorm);
+            for (int i = 0; i < lanes; i++)
+                norms[base + i] = (float)out[i];
+        }
+    }
+}
+
+/**
+ * @brief Double-Double-Arithmetik auf S::LANES Lanes, Operation für Operation wie in DoubleDouble.h
+ * (Dekker-Variante ohne FMA), damit die Kernel bitgleich zu mandelbrot<DoubleDouble>() rechnen.
+ */
+template <class S>
+struct SimdDoubleDouble
+{
+    typedef typename S::Vec Vec;
+
+    struct DD
+    {
+        Vec hi, lo;
+    };
+
+    static inline DD make(Vec hi, Vec lo)
+    {
+        DD r = {hi, lo};
+        return r;
+    }
+
+    static inline DD constant(double v)
+    {
+        return make(S::set1(v), S::set1(0.0));
+    }
+
+    // -x wie beim Vorzeichenwechsel in C, auch für +-0
+    static inline Vec neg(Vec x)
+    {
+        return S::sub(S::set1(-0.0), x);
+    }
+
+    static inline void twoSum(Vec a, Vec b, Vec &s, Vec &e)
+    {
+        s = S::add(a, b);
+        Vec bb = S::sub(s, a);
+        e = S::add(S::sub(a, S::sub(s, bb)), S::sub(b, bb));
+    }
+
+    static inline void quickTwoSum(Vec a, Vec b, Vec &s, Vec &e)
+    {
+        s = S::add(a, b);
+        e = S::sub(b, S::sub(s, a));
+    }
+
+    static inline void twoProd(Vec a, Vec b, Vec &p, Vec &e)
+    {
+        const Vec splitter = S::set1(DD_SPLITTER);
+        p = S::mul(a, b);
+        Vec t = S::mul(splitter, a);
+        Vec ah = S::sub(t, S::sub(t, a));
+        Vec al = S::sub(a, ah);
+        t = S::mul(splitter, b);
+        Vec bh = S::sub(t, S::sub(t, b));
+        Vec bl = S::sub(b, bh);
+        e = S::add(S::add(S::add(S::sub(S::mul(ah, bh), p), S::mul(ah, bl)), S::mul(al, bh)), S::mul(al, bl));
+    }
+
+    static inline DD add(const DD &a, const DD &b)
+    {
+        Vec s, e;
+        twoSum(a.hi, b.hi, s, e);
+        e = S::add(e, S::add(a.lo, b.lo));
+        DD r;
+        quickTwoSum(s, e, r.hi, r.lo);
+        return r;
+    }
+
+    static inline DD sub(const DD &a, const DD &b)
+    {
+        return add(a, make(neg(b.hi), neg(b.lo)));
+    }
+
+    static inline DD mul(const DD &a, const DD &b)
+    {
+        Vec p, e;
+        twoProd(a.hi, b.hi, p, e);
+        e = S::add(e, S::add(S::mul(a.hi, b.lo), S::mul(a.lo, b.hi)));
+        DD r;
+        quickTwoSum(p, e, r.hi, r.lo);
+        return r;
+    }
+
+    static inline DD twice(const DD &a)
+    {
+        const Vec two = S::set1(2.0);
+        return make(S::mul(two, a.hi), S::mul(two, a.lo));
+    }
+};
+
+/**
+ * @brief Wie escapeTimePoints(), aber in Double-Double. Jeder Punkt ist real = realHi + realLo,
+ * imag = imagHi + imagLo. Bitgleich zu computeIterations<DoubleDouble>() mit derselben Blockregel,
+ * norms wie bei escapeTimePoints().
+ */
+template <class S>
+inline void escapeTimePointsDD(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                               int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms)
+{
+    typedef typename S::Vec Vec;
+    typedef typename S::Mask Mask;
+    typedef SimdDoubleDouble<S> D;
+    typedef typename D::DD DD;
+
+    const Vec zero = S::set1(0.0);
+    const Vec four = S::set1(4.0);
+    const Vec maxIter = S::set1((double)max_iter);
+    const Vec vtolerance = S::set1(tolerance);
+
+    bool periodic = false;
+    bool blockInside = true;
+
+    for (int base = 0; base < count; base += S::LANES)
+    {
+        int lanes = count - base < S::LANES ? count - base : S::LANES;
+
+        if (base % PERIODICITY_BLOCK == 0)
+        {
+            periodic = tolerance >= 0.0 && blockInside;
+            blockInside = false;
+        }
+
+        DD cr = D::make(loadPadded<S>(realHi, base, lanes), loadPadded<S>(realLo, base, lanes));
+        DD ci = D::make(loadPadded<S>(imagHi, base, lanes), loadPadded<S>(imagLo, base, lanes));
+
+        DD zr = D::constant(0.0);
+        DD zi = D::constant(0.0);
+        DD savedR = D::constant(0.0);
+        DD savedI = D::constant(0.0);
+        Vec counts = zero;
+        Vec escapeNorm = zero;
+        DD escapeR = D::constant(0.0);
+        DD escapeI = D::constant(0.0);
+        int check = 0, checkLimit = 1;
+        Mask active = S::allTrue();
+
+        if (interiorCheck)
+        {
+            // Gleiche Operationsfolge wie isInMainCardioidOrBulb(DoubleDouble, DoubleDouble)
+            DD xm = D::sub(cr, D::constant(0.25));
+            DD y2 = D::mul(ci, ci);
+            DD q = D::add(D::mul(xm, xm), y2);
+            DD t = D::sub(D::mul(q, D::add(q, xm)), D::mul(D::constant(0.25), y2));
+            Mask inside = S::cmple(t.hi, zero);
+            DD xp = D::add(cr, D::constant(1.0));
+            DD u = D::sub(D::add(D::mul(xp, xp), y2), D::constant(0.0625));
+            inside = S::maskOr(inside, S::cmple(u.hi, zero));
+
+            counts = S::select(inside, maxIter, counts);
+            active = S::maskAndNot(inside, active);
+        }
+
+        for (int k = 0; k < max_iter; k++)
+        {
+            DD zr2 = D::mul(zr, zr);
+            DD zi2 = D::mul(zi, zi);
+            Vec norm = D::add(zr2, zi2).hi;
+            Mask bounded = S::cmple(norm, four);
+            if (norms != NULL)
+            {
+                Mask escaping = S::maskAndNot(bounded, active);
+                escapeNorm = S::select(escaping, norm, escapeNorm);
+                escapeR = D::make(S::select(escaping, zr.hi, escapeR.hi), S::select(escaping, zr.lo, escapeR.lo));
+                escapeI = D::make(S::select(escaping, zi.hi, escapeI.hi), S::select(escaping, zi.lo, escapeI.lo));
+            }
+            active = S::maskAnd(active, bounded);
+            if (!S::any(active))
+                break;
+
+            DD temp = D::add(D::sub(zr2, zi2), cr);
+            zi = D::add(D::mul(D::twice(zr), zi), ci);
+            zr = temp;
+            counts = S::addIfActive(counts, active);
+
+            if (periodic)
+            {
+                Mask near = S::maskAnd(S::cmple(S::abs(D::sub(zr, savedR).hi), vtolerance),
+                                       S::cmple(S::abs(D::sub(zi, savedI).hi), vtolerance));
+                Mask hit = S::maskAnd(active, near);
+                counts = S::select(hit, maxIter, counts);
+                active = S::maskAndNot(hit, active);
+
+                if (++check == checkLimit)
+                {
+                    savedR = zr;
+                    savedI = zi;
+                    check = 0;
+                    checkLimit *= 2;
+                }
+            }
+        }
+
+        double out[S::LANES];
+        S::store(out, counts);
+        for (int i = 0; i < lanes; i++)
+        {
+            iters[base + i] = (int)out[i];
+            if (iters[base + i] == max_iter)
+                blockInside = true;
+        }
+        if (norms != NULL)
+        {
+            // Wie escapeNorm<DoubleDouble>(); Lanes, die nicht entkommen sind, behalten 0
+            for (int k = 0; k < SMOOTH_EXTRA_ITER; k++)
+            {
+                DD temp = D::add(D::sub(D::mul(escapeR, escapeR), D::mul(escapeI, escapeI)), cr);
+                escapeI = D::add(D::mul(D::twice(escapeR), escapeI), ci);
+                escapeR = temp;
+            }
+            Vec extended = D::add(D::mul(escapeR, escapeR), D::mul(escapeI, escapeI)).hi;
+            escapeNorm = S::select(S::cmple(escapeNorm, four), escapeNorm, extended);
+            S::store(out, escapeNorm);
+            for (int i = 0; i < lanes; i++)
+                norms[base + i] = (float)out[i];
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "FractalSimd.h"
+
+#ifdef FRACTAL_SIMD_X86
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#pragma GCC optimize("fp-contract=off")
+
+#include "FractalSimdKernel.h"
+
+namespace
+{
+
+struct Sse2Double
+{
+    typedef double Scalar;
+    typedef __m128d Vec;
+    typedef __m128d Mask;
+    static const int LANES = 2;
+
+    static inline Vec set1(double v) { return _mm_set1_pd(v); }
+    static inline Vec load(const double *p) { return _mm_loadu_pd(p); }
+    static inline void store(double *p, Vec v) { _mm_storeu_pd(p, v); }
+    static inline Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+    static inline Vec abs(Vec a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static inline Mask cmple(Vec a, Vec b) { return _mm_cmple_pd(a, b); }
+    static inline Mask maskAnd(Mask a, Mask b) { return _mm_and_pd(a, b); }
+    static inline Mask maskOr(Mask a, Mask b) { return _mm_or_pd(a, b); }
+    static inline Mask maskAndNot(Mask a, Mask b) { return _mm_andnot_pd(a, b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    static inline Mask allTrue() { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+    static inline bool any(Mask m) { return _mm_movemask_pd(m) != 0; }
+    static inline Vec addIfActive(Vec c, Mask m) { return _mm_add_pd(c, _mm_and_pd(m, _mm_set1_pd(1.0))); }
+};
+
+struct Sse2Float
+{
+    typedef float Scalar;
+    typedef __m128 Vec;
+    typedef __m128 Mask;
+    static const int LANES = 4;
+
+    static inline Vec set1(float v) { return _mm_set1_ps(v); }
+    static inline Vec load(const float *p) { return _mm_loadu_ps(p); }
+    static inline void store(float *p, Vec v) { _mm_storeu_ps(p, v); }
+    static inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    static inline Vec abs(Vec a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static inline Mask cmple(Vec a, Vec b) { return _mm_cmple_ps(a, b); }
+    static inline Mask maskAnd(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static inline Mask maskOr(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    static inline Mask maskAndNot(Mask a, Mask b) { return _mm_andnot_ps(a, b); }
+    static inline Vec select(Mask m, Vec a, Vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static inline Mask allTrue() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    static inline bool any(Mask m) { return _mm_movemask_ps(m) != 0; }
+    static inline Vec addIfActive(Vec c, Mask m) { return _mm_add_ps(c, _mm_and_ps(m, _mm_set1_ps(1.0f))); }
+};
+
+}
+
+void mandelbrotPointsSse2(const double *real, const double *imag, int count, int max_iter, bool interiorCheck, double tolerance, int *iters,
+                          bool previousInside, float *norms)
+{
+    escapeTimePoints<Sse2Double>(real, imag, count, max_iter, interiorCheck, tolerance, iters, previousInside, norms);
+}
+
+void mandelbrotPointsDDSse2(const double *realHi, const double *realLo, const double *imagHi, const double *imagLo,
+                            int count, int max_iter, bool interiorCheck, double tolerance, int *iters, float *norms)
+{
+    escapeTimePointsDD<Sse2Double>(realHi, realLo, imagHi, imagLo, count, max_iter, interiorCheck, tolerance, iters, norms);
+}
+
+void mandelbrotPointsFloatSse2(const float *real, const float *imag, int count, int max_iter, bool interiorCheck, float tolerance, int *iters,
+                               bool previousInside, float *norms)
+{
+    escapeTimePoints<Sse2Float>(real, imag, count, max_iter, interiorCheck, tolerance, iters, previousInside, norms);
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef INTERVAL_TILES_H
+#define INTERVAL_TILES_H
+
+#include "../common/FractalCore.h"
+
+/*
+ * Klassifikation ganzer Kacheln per Intervallarithmetik: statt jedes Pixel zu iterieren, wird ein
+ * Rechteck aus Real- und Imaginärteilen als Ganzes iteriert. Die Intervalle werden mit denselben
+ * Operationen in derselben Reihenfolge und demselben Typ (float bzw. double) wie in mandelbrot() und
+ * escapeTimePoints() gerechnet. Addition, Subtraktion und Multiplikation sind auch nach dem Runden
+ * monoton in jedem Argument, daher enthält jedes Intervall die gerundeten Werte aller Pixel der
+ * Kachel, ohne dass nach außen gerundet werden muss. Ein Ergebnis gilt deshalb exakt für die
+ * Pixel, wie sie der Kernel rechnen würde, nicht nur für die mathematische Menge.
+ */
+
+template <typename Real>
+struct Interval
+{
+    Real lo, hi;
+};
+
+template <typename Real>
+inline Interval<Real> intervalAdd(Interval<Real> a, Interval<Real> b)
+{
+    Interval<Real> r = {a.lo + b.lo, a.hi + b.hi};
+    return r;
+}
+
+template <typename Real>
+inline Interval<Real> intervalSub(Interval<Real> a, Interval<Real> b)
+{
+    Interval<Real> r = {a.lo - b.hi, a.hi - b.lo};
+    return r;
+}
+
+template <typename Real>
+inline Interval<Real> intervalMul(Interval<Real> a, Interval<Real> b)
+{
+    Real p1 = a.lo * b.lo, p2 = a.lo * b.hi, p3 = a.hi * b.lo, p4 = a.hi * b.hi;
+    Interval<Real> r = {fmin(fmin(p1, p2), fmin(p3, p4)), fmax(fmax(p1, p2), fmax(p3, p4))};
+    return r;
+}
+
+/**
+ * @brief x * x für alle x im Intervall, enger als intervalMul(a, a), da beide Faktoren gleich sind.
+ */
+template <typename Real>
+inline Interval<Real> intervalSqr(Interval<Real> a)
+{
+    Real l = a.lo * a.lo, h = a.hi * a.hi;
+    Interval<Real> r;
+    if (a.lo >= 0)
+        r.lo = l, r.hi = h;
+    else if (a.hi <= 0)
+        r.lo = h, r.hi = l;
+    else
+        r.lo = 0, r.hi = fmax(l, h);
+    return r;
+}
+
+template <typename Real>
+inline Interval<Real> intervalScale(Real s, Interval<Real> a)
+{
+    Interval<Real> r = {s * a.lo, s * a.hi};
+    return r;
+}
+
+/**
+ * @brief Ergebnis von classifyTile(), wenn die Kachel nicht einheitlich ist.
+ */
+#define TILE_MIXED -1
+
+/**
+ * @brief Prüft, ob alle Punkte des Rechtecks [crLo, crHi] x [ciLo, ciHi] dieselbe Iterationsanzahl
+ * haben, entweder weil sie nach dem Kardioiden-/Knospen-Test innen liegen oder weil sie alle im
+ * selben Schritt entkommen, ohne dass die Periodizitätsprüfung vorher für einen von ihnen anschlägt.
+ *
+ * @param crLo
+ * @param crHi
+ * @param ciLo
+ * @param ciHi
+ * @param max_iter
+ * @param interiorCheck wie RenderOptions::interiorCheck
+ * @param tolerance wie im Kernel, negativ ohne Periodizitätsprüfung
+ * @param escaping false: nur innen liegende Kacheln erkennen
+ * @return gemeinsame Iterationsanzahl oder TILE_MIXED
+ */
+template <typename Real>
+inline int classifyInterval(Real crLo, Real crHi, Real ciLo, Real ciHi, int max_iter, bool interiorCheck, Real tolerance, bool escaping)
+{
+    Interval<Real> cr = {crLo, crHi};
+    Interval<Real> ci = {ciLo, ciHi};
+
+    if (interiorCheck)
+    {
+        // Gleiche Rechnung wie isInMainCardioidOrBulb()
+        Interval<Real> quarter = {(Real)0.25, (Real)0.25};
+        Interval<Real> one = {(Real)1.0, (Real)1.0};
+        Interval<Real> xm = intervalSub(cr, quarter);
+        Interval<Real> y2 = intervalSqr(ci);
+        Interval<Real> q = intervalAdd(intervalSqr(xm), y2);
+        Interval<Real> cardioid = intervalMul(q, intervalAdd(q, xm));
+        Interval<Real> bound = intervalScale((Real)0.25, y2);
+        Interval<Real> bulb = intervalAdd(intervalSqr(intervalAdd(cr, one)), y2);
+
+        if (cardioid.hi <= bound.lo || bulb.hi <= (Real)0.0625)
+            return max_iter;
+        if (!(cardioid.lo > bound.hi && bulb.lo > (Real)0.0625))
+            return TILE_MIXED;
+    }
+    if (!escaping)
+        return TILE_MIXED;
+
+    Interval<Real> zr = {0, 0}, zi = {0, 0};
+    Interval<Real> savedR = {0, 0}, savedI = {0, 0};
+    int check = 0, checkLimit = 1;
+    for (int iter = 0; iter < max_iter; iter++)
+    {
+        Interval<Real> zr2 = intervalSqr(zr);
+        Interval<Real> zi2 = intervalSqr(zi);
+        Interval<Real> norm = intervalAdd(zr2, zi2);
+        if (norm.lo > (Real)4.0)
+            return iter;
+        if (norm.hi > (Real)4.0)
+            return TILE_MIXED;
+
+        Interval<Real> temp = intervalAdd(intervalSub(zr2, zi2), cr);
+        zi = intervalAdd(intervalMul(intervalScale((Real)2.0, zr), zi), ci);
+        zr = temp;
+
+        if (tolerance >= 0)
+        {
+            // Kann die Prüfung für einen Punkt anschlagen, ist die Kachel nicht einheitlich
+            Interval<Real> dr = intervalSub(zr, savedR);
+            Interval<Real> di = intervalSub(zi, savedI);
+            if (!(dr.lo > tolerance || dr.hi < -tolerance || di.lo > tolerance || di.hi < -tolerance))
+                return TILE_MIXED;
+
+            if (++check == checkLimit)
+            {
+                savedR = zr;
+                savedI = zi;
+                check = 0;
+                checkLimit *= 2;
+            }
+        }
+    }
+    return max_iter;
+}
+
+/**
+ * @brief classifyInterval() für die Pixel x0 .. x1, y0 .. y1 (inklusive) eines Bildes in float oder
+ * double. Die Randkoordinaten werden wie in mandelbrotRow() bzw. mandelbrotRowFloat() berechnet;
+ * sie sind monoton in x und y, daher liegen alle Pixel der Kachel dazwischen.
+ *
+ * @param escaping wie bei classifyInterval()
+ * @return gemeinsame Iterationsanzahl oder TILE_MIXED, auch für andere Rechenverfahren
+ */
+inline int classifyTile(const FrameParams &p, const RenderOptions &opts, int x0, int y0, int x1, int y1, bool escaping)
+{
+    double crLo = (x0 - p.WIDTH / 2.0) * p.scale + p.centerX;
+    double crHi = (x1 - p.WIDTH / 2.0) * p.scale + p.centerX;
+    double ciLo = (p.HEIGHT / 2.0 - y1) * p.scale + p.centerY;
+    double ciHi = (p.HEIGHT / 2.0 - y0) * p.scale + p.centerY;
+    double tolerance = periodTolerance(opts, p.scale);
+
+    if (p.precision == PRECISION_FLOAT)
+        return classifyInterval<float>((float)crLo, (float)crHi, (float)ciLo, (float)ciHi, p.MAX_ITER, opts.interiorCheck, (float)tolerance, escaping);
+    if (p.precision == PRECISION_DOUBLE)
+        return classifyInterval<double>(crLo, crHi, ciLo, ciHi, p.MAX_ITER, opts.interiorCheck, tolerance, escaping);
+    return TILE_MIXED;
+}
+
+#endif
@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "../common/FractalProtocol.h"
+#include "../common/FrameCache.h"
+#include "../common/Palette.h"
+#include "../common/Perturbation.h"
+#include "../common/RequestQueue.h"
+#include "../common/SharedFrames.h"
+#include "../common/TileCache.h"
+#include "CpuRenderer.h"
+#include "ExpMap.h"
+#include "FractalSimd.h"
+
+/**
+ * @brief Liest die Kommandozeile. Unterstützt werden
+ *   --threads N                  Anzahl der OpenMP-Threads (Standard: alle Kerne)
+ *   --schedule dynamic|guided|steal  Verteilung der Bildzeilen bzw. mit steal der Kacheln per
+ *                                Work-Stealing, siehe WorkStealing.h (Standard: dynamic)
+ *   --simd scalar|sse2|avx2|avx512  Kernel erzwingen (Standard: bester per CPUID)
+ *   --no-interior-check          Kardioiden-/Knospen-Test abschalten (zum Validieren)
+ *   --no-periodicity-check       Zykluserkennung in mandelbrot() abschalten (zum Validieren)
+ *   --periodicity-tolerance F    Toleranz der Zykluserkennung in Vielfachen der Pixelgröße (Standard: 1e-3)
+ *   --mariani-silver             Kacheln mit einheitlichem Rand füllen statt jedes Pixel zu rechnen
+ *   --precision auto|float|double|double-double|perturbation  Rechenverfahren erzwingen (Standard: auto nach Zoomtiefe)
+ *   --no-bla                     Bei Störungsrechnung keine Iterationen per BLA überspringen (zum Validieren)
+ *   --no-pan-cache               Beim Verschieben jedes Bild ganz neu rechnen (zum Validieren)
+ *   --no-interval-tiles          Keine Kacheln per Intervallarithmetik füllen, jedes Pixel iterieren (zum Validieren)
+ *   --tile-cache MB              Größe des Kachelcaches im Speicher, 0 schaltet ihn ab (Standard:
+ *                                TILE_CACHE_DEFAULT_MB), siehe TileCache.h
+ *   --tile-cache-dir DIR         Verdrängte Kacheln in das vorhandene Verzeichnis DIR auslagern und beim
+ *                                Beenden alle Kacheln dort ablegen
+ *   --tile N                     Jedes Bild in Kacheln von N x N Pixeln rechnen und direkt ausgeben
+ *                                (Standard: nur Bilder über TILE_FRAME_LIMIT, mit TILE_SIZE_DEFAULT)
+ *   --output FILE                Bilder als PPM in FILE schreiben statt roh auf stdout (für Poster)
+ *   --protocol binary|text       Anfrage-/Antwortformat, siehe FractalProtocol.h (Standard: binary)
+ *   --protocol-version           Nur FRACTAL_PROTOCOL_VERSION ausgeben und beenden (Abfrage der GUI)
+ *   --no-coalesce                Jede Anfrage vollständig rechnen, statt veraltete zu verwerfen (Stapelbetrieb)
+ *                                (im Textprotokoll immer so, dort sind Antworten nicht zuzuordnen)
+ *   --palette FILE               Farbverlauf aus FILE statt des HSV-Farbkreises, siehe Palette.h
+ *   --zoom-video N               Jede Anfrage als Zoomvideo mit N Bildern von Zoom 1 bis zu ihrem Zoom in die
+ *                                Datei von --output schreiben (aneinandergehängte PPMs), siehe ExpMap.h
+ *   --shared-memory FILE         Bilder in die gemeinsam gemappte Datei FILE rechnen statt durch die Pipe
+ *                                (nur Binärprotokoll, siehe SharedFrames.h)
+ *   --verify-simd                Alle SIMD-Kernel gegen die skalare Referenz prüfen und beenden
+ *   --benchmark                  Skalierung von 1 bis --threads Kernen mit allen Schedules auf den Fällen
+ *                                aus docs/cuda measurments messen und beenden
+ *   --benchmark-scale F          Breite und Höhe der Benchmark-Fälle mit F multiplizieren (Standard: 1)
+ * Ein gesetztes OMP_SCHEDULE hat Vorrang vor dem Standard, nicht aber vor --schedule.
+ *
+ * @param argc
+ * @param argv
+ * @param opts Ergebnis der Rechenschalter
+ * @param simd Ergebnis von --simd, vorbelegt mit detectSimdLevel()
+ * @param verifySimd Ergebnis von --verify-simd
+ * @param tileSize Ergebnis von --tile, 0 ohne
+ * @param outputPath Ergebnis von --output, NULL ohne
+ * @param textProtocol Ergebnis von --protocol
+ * @param coalesce Ergebnis von --no-coalesce
+ * @param sharedPath Ergebnis von --shared-memory, NULL ohne
+ * @param palettePath Ergebnis von --palette, NULL ohne
+ * @param videoFrames Ergebnis von --zoom-video, 0 ohne
+ * @param tileCacheMb Ergebnis von --tile-cache
+ * @param tileCacheDir Ergebnis von --tile-cache-dir, NULL ohne
+ * @param benchmark Ergebnis von --benchmark
+ * @param benchmarkScale Ergebnis von --benchmark-scale
+ * @return 0 bei Erfolg, sonst 1
+ */
+static int parseArguments(int argc, char **argv, RenderOptions &opts, SimdLevel &simd, bool &verifySimd, int &tileSize, const char *&outputPath,
+                          bool &textProtocol, bool &coalesce, const char *&sharedPath, const char *&palettePath,
+                          int &videoFrames, int &tileCacheMb, const char *&tileCacheDir, bool &benchmark, double &benchmarkScale)
+{
+    if (getenv("OMP_SCHEDULE") == NULL)
+    {
+        omp_set_schedule(omp_sched_dynamic, 1);
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            int threads = atoi(argv[++i]);
+            if (threads < 1)
+            {
+                fprintf(stderr, "Invalid thread count: %s\n", argv[i]);
+                return 1;
+            }
+            omp_set_num_threads(threads);
+        }
+        else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc)
+        {
+            const char *kind = argv[++i];
+            if (strcmp(kind, "dynamic") == 0)
+            {
+                omp_set_schedule(omp_sched_dynamic, 1);
+            }
+            else if (strcmp(kind, "guided") == 0)
+            {
+                omp_set_schedule(omp_sched_guided, 1);
+            }
+            else if (strcmp(kind, "steal") == 0)
+            {
+                opts.workStealing = true;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown schedule: %s\n", kind);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+        {
+            SimdLevel requested;
+            if (!parseSimdLevel(argv[++i], requested))
+            {
+                fprintf(stderr, "Unknown SIMD level: %s\n", argv[i]);
+                return 1;
+            }
+            if (requested > simd)
+            {
+                fprintf(stderr, "SIMD level %s not supported by this CPU, using %s\n", argv[i], simdLevelName(simd));
+            }
+            else
+            {
+                simd = requested;
+            }
+        }
+        else if (strcmp(argv[i], "--no-interior-check") == 0)
+        {
+            opts.interiorCheck = false;
+        }
+        else if (strcmp(argv[i], "--no-periodicity-check") == 0)
+        {
+            opts.periodicityCheck = false;
+        }
+        else if (strcmp(argv[i], "--periodicity-tolerance") == 0 && i + 1 < argc)
+        {
+            opts.periodicityTolerance = atof(argv[++i]);
+            if (opts.periodicityTolerance < 0.0)
+            {
+                fprintf(stderr, "Invalid periodicity tolerance: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--mariani-silver") == 0)
+        {
+            opts.marianiSilver = true;
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc)
+        {
+            if (!parsePrecision(argv[++i], opts.precision))
+            {
+                fprintf(stderr, "Unknown precision: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--no-bla") == 0)
+        {
+            opts.bla = false;
+        }
+        else if (strcmp(argv[i], "--no-pan-cache") == 0)
+        {
+            opts.panCache = false;
+        }
+        else if (strcmp(argv[i], "--no-interval-tiles") == 0)
+        {
+            opts.intervalTiles = false;
+        }
+        else if (strcmp(argv[i], "--tile-cache") == 0 && i + 1 < argc)
+        {
+            tileCacheMb = atoi(argv[++i]);
+            if (tileCacheMb < 0)
+            {
+                fprintf(stderr, "Invalid tile cache size: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--tile-cache-dir") == 0 && i + 1 < argc)
+        {
+            tileCacheDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc)
+        {
+            tileSize = atoi(argv[++i]);
+            if (tileSize < 16)
+            {
+                fprintf(stderr, "Invalid tile size: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--protocol") == 0 && i + 1 < argc)
+        {
+            const char *kind = argv[++i];
+            if (strcmp(kind, "text") == 0)
+            {
+                textProtocol = true;
+            }
+            else if (strcmp(kind, "binary") == 0)
+            {
+                textProtocol = false;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown protocol: %s\n", kind);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--no-coalesce") == 0)
+        {
+            coalesce = false;
+        }
+        else if (strcmp(argv[i], "--palette") == 0 && i + 1 < argc)
+        {
+            palettePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--zoom-video") == 0 && i + 1 < argc)
+        {
+            videoFrames = atoi(argv[++i]);
+            if (videoFrames < 2)
+            {
+                fprintf(stderr, "Invalid frame count: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--shared-memory") == 0 && i + 1 < argc)
+        {
+            sharedPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--verify-simd") == 0)
+        {
+            verifySimd = true;
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmark = true;
+        }
+        else if (strcmp(argv[i], "--benchmark-scale") == 0 && i + 1 < argc)
+        {
+            benchmarkScale = atof(argv[++i]);
+            if (!(benchmarkScale > 0.0) || benchmarkScale > 1.0e3)
+            {
+                fprintf(stderr, "Invalid benchmark scale: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // Slot und Sequenz kann nur der Kopf des Binärprotokolls melden
+    if (sharedPath != NULL && (textProtocol || outputPath != NULL))
+    {
+        fprintf(stderr, "--shared-memory needs the binary protocol and no --output\n");
+        return 1;
+    }
+    if (videoFrames > 0 && outputPath == NULL)
+    {
+        fprintf(stderr, "--zoom-video needs --output\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Fälle aus docs/cuda measurments (Textprotokoll), ohne 20000 x 20000, das mit den Iterationen 2,8 GB bräuchte
+static const char *BENCHMARK_CASES[] = {
+    "1.0 0.0 0.0 10000 10000",
+    "100.0 0.5 0.5 500 500",
+    "100.0 0.5 0.5 10000 10000",
+    "6.884310827443782E9 -1.484610808411835 -4.721191790807227E-10 1000 1000",
+    "6.884310827443782E9 -1.484610808411835 -4.721191790807227E-10 10000 10000",
+};
+
+/**
+ * @brief Misst die Skalierung von renderFrame() mit 1, 2, 4, ... bis maxThreads Threads für jeden
+ * Schedule (dynamic, guided, steal) auf BENCHMARK_CASES und gibt die Tabelle auf stderr aus. Ein
+ * ungemessenes Bild vorab wärmt die Puffer an; mit ihm wird jedes gemessene verglichen, alle
+ * Schedules müssen dieselben Pixel liefern.
+ *
+ * @param opts
+ * @param simd
+ * @param scale Faktor für Breite und Höhe der Fälle
+ * @return false bei fehlendem Speicher oder abweichenden Pixeln
+ */
+static bool runBenchmark(const RenderOptions &opts, SimdLevel simd, double scale)
+{
+    int maxThreads = omp_get_max_threads();
+    const char *scheduleNames[] = {"dynamic", "guided", "steal"};
+    ReferenceOrbit orbit = {NULL, NULL, 0, 0};
+    BlaTable bla = {NULL, 0, 0, {0}};
+    bool ok = true;
+    Palette palette;
+    buildPalette(palette, ColorOptions(), NULL);
+
+    fprintf(stderr, "%-4s %-8s %7s %11s %8s %10s\n", "case", "schedule", "threads", "ms", "speedup", "efficiency");
+    for (size_t c = 0; c < sizeof(BENCHMARK_CASES) / sizeof(BENCHMARK_CASES[0]) && ok; c++)
+    {
+        FrameRequest req;
+        parseTextRequest(BENCHMARK_CASES[c], req);
+        req.colors.palette = &palette;
+        req.WIDTH = (int)(req.WIDTH * scale) > 16 ? (int)(req.WIDTH * scale) : 16;
+        req.HEIGHT = (int)(req.HEIGHT * scale) > 16 ? (int)(req.HEIGHT * scale) : 16;
+
+        size_t pixels = (size_t)req.WIDTH * req.HEIGHT;
+        uint8_t *image = (uint8_t *)malloc(pixels * 3);
+        uint8_t *reference = (uint8_t *)malloc(pixels * 3);
+        int *iterations = (int *)malloc(sizeof(int) * pixels);
+        FrameParams frame;
+        if (image == NULL || reference == NULL || iterations == NULL || !prepareFrame(frame, req, opts, orbit, bla))
+        {
+            fprintf(stderr, "Cannot prepare benchmark case %zu\n", c + 1);
+            ok = false;
+        }
+        else
+        {
+            fprintf(stderr, "Case %zu: %s at %d x %d, %s\n", c + 1, BENCHMARK_CASES[c], req.WIDTH, req.HEIGHT, precisionName(frame.precision));
+            renderFrame(reference, iterations, frame, opts, req.colors, simd, NULL);
+        }
+
+        for (int schedule = 0; schedule < 3 && ok; schedule++)
+        {
+            RenderOptions caseOpts = opts;
+            caseOpts.workStealing = schedule == 2;
+            omp_set_schedule(schedule == 1 ? omp_sched_guided : omp_sched_dynamic, 1);
+            double single = 0.0;
+            for (int threads = 1; threads <= maxThreads && ok; threads = threads * 2 > maxThreads && threads < maxThreads ? maxThreads : threads * 2)
+            {
+                omp_set_num_threads(threads);
+                double start = omp_get_wtime();
+                renderFrame(image, iterations, frame, caseOpts, req.colors, simd, NULL);
+                double ms = (omp_get_wtime() - start) * 1000.0;
+                if (threads == 1)
+                    single = ms;
+                if (memcmp(image, reference, pixels * 3) != 0)
+                {
+                    fprintf(stderr, "Benchmark case %zu: schedule %s with %d threads differs\n", c + 1, scheduleNames[schedule], threads);
+                    ok = false;
+                }
+                fprintf(stderr, "%-4zu %-8s %7d %11.3f %7.2fx %9.1f%%\n", c + 1, scheduleNames[schedule], threads, ms, single / ms,
+                        100.0 * single / ms / threads);
+                fflush(stderr);
+            }
+        }
+        free(image);
+        free(reference);
+        free(iterations);
+    }
+    omp_set_num_threads(maxThreads);
+    freeReferenceOrbit(orbit);
+    freeBlaTable(bla);
+    return ok;
+}
+
+/**
+ * @brief Schreibt ein Zoomvideo als videoFrames aneinandergehängte PPMs nach out (lesbar z. B. mit
+ * ffmpeg -f image2pipe -c:v ppm). Statt jedes Bild zu rechnen, wird einmal die Exponentialkarte
+ * vom flachsten bis zum tiefsten Zoom gerechnet und jedes Bild daraus abgetastet. Die Zooms wachsen
+ * von Bild zu Bild um denselben Faktor.
+ *
+ * @param out
+ * @param req Zentrum, Bildformat und Zoom des letzten Bildes; das erste hat Zoom 1 (oder req.zoom, falls kleiner)
+ * @param videoFrames
+ * @param opts
+ * @param simd
+ * @param orbit
+ * @param bla
+ * @param precision Ergebnis: Rechenverfahren des tiefsten Bildes
+ * @return false bei fehlendem Speicher, ungültigem Zentrum oder Schreibfehler
+ */
+static bool renderZoomVideo(FILE *out, const FrameRequest &req, int videoFrames, const RenderOptions &opts, SimdLevel simd,
+                            ReferenceOrbit &orbit, BlaTable &bla, Precision &precision)
+{
+    double zoomFrom = req.zoom < 1.0 ? req.zoom : 1.0;
+    double start = omp_get_wtime();
+
+    ExpMap map;
+    if (!renderExpMap(map, req, zoomFrom, opts, simd, orbit, bla))
+        return false;
+    precision = map.precision;
+    fprintf(stderr, "Exponential map: %d x %d cells in %.3f ms\n", map.columns, map.rows, (omp_get_wtime() - start) * 1000.0);
+    fflush(stderr);
+
+    size_t imageSize = (size_t)req.WIDTH * req.HEIGHT * 3;
+    uint8_t *image = (uint8_t *)malloc(imageSize);
+    bool ok = image != NULL;
+    double resampleStart = omp_get_wtime();
+    for (int i = 0; i < videoFrames && ok; i++)
+    {
+        double zoom = zoomFrom * pow(req.zoom / zoomFrom, (double)i / (videoFrames - 1));
+        expMapFrame(map, zoom, req.colors, image);
+        ok = fprintf(out, "P6\n%d %d\n255\n", req.WIDTH, req.HEIGHT) > 0 && fwrite(image, 1, imageSize, out) == imageSize;
+    }
+    fprintf(stderr, "Zoom video: %d frames, %.3f ms per frame from the map\n", videoFrames, (omp_get_wtime() - resampleStart) * 1000.0 / videoFrames);
+    fflush(stderr);
+
+    free(image);
+    freeExpMap(map);
+    return ok && fflush(out) == 0;
+}
+
+/**
+ * @brief Die Vorschau-Durchläufe von REQUEST_FLAG_PROGRESSIVE: nach jedem Durchlauf mit Schrittweite
+ * PROGRESSIVE_FIRST_STEP bis 2 geht eine verkleinerte Vorschau an die GUI. Danach rechnet der letzte
+ * Durchlauf die übrigen Pixel; färben und senden muss das Bild der Aufrufer.
+ *
+ * @param iterations Iterationspuffer des Bildes, Ergebnis
+ * @param preview Puffer für die Vorschau ohne --shared-memory, mindestens so groß wie das Bild
+ * @param frame
+ * @param req
+ * @param res Antwortkopf des Bildes, Vorlage für die Vorschauen
+ * @param opts
+ * @param simd
+ * @param stats Zähler der Störungsrechnung, wird aufsummiert
+ * @param cancel
+ * @param shared wenn nicht NULL: Vorschauen in die gemeinsame Datei
+ * @param start Startzeit des Bildes für renderMs
+ * @return false, wenn eine neuere Anfrage wartet
+ */
+static bool renderProgressive(int *iterations, uint8_t *preview, const FrameParams &frame, const FrameRequest &req, const FrameResponse &res,
+                              const RenderOptions &opts, SimdLevel simd, RenderStats &stats, const std::atomic<bool> &cancel,
+                              SharedFrames *shared, double start)
+{
+    // Ohne Slot für eine Vorschau fehlen nur die Vorschauen, gerechnet wird trotzdem
+    bool previews = true;
+    int pass = 0;
+    for (int step = PROGRESSIVE_FIRST_STEP; step > 1; step /= 2, pass++)
+    {
+        if (!renderPass(iterations, step, step == PROGRESSIVE_FIRST_STEP, frame, opts, simd, &stats, &cancel))
+            return false;
+        if (!previews)
+            continue;
+
+        FrameResponse passRes = res;
+        passRes.WIDTH = (frame.WIDTH + step - 1) / step;
+        passRes.HEIGHT = (frame.HEIGHT + step - 1) / step;
+        passRes.byteLength = (size_t)passRes.WIDTH * passRes.HEIGHT * 3;
+        passRes.pass = pass;
+        passRes.passes = PROGRESSIVE_PASSES;
+
+        int slot = -1;
+        uint8_t *image = preview;
+        if (shared != NULL)
+        {
+            image = beginSharedFrame(*shared, passRes.byteLength, slot);
+            if (image == NULL)
+            {
+                previews = false;
+                continue;
+            }
+        }
+        colorizePass(image, iterations, frame.WIDTH, frame.HEIGHT, step, frame.MAX_ITER, req.colors);
+        passRes.renderMs = (omp_get_wtime() - start) * 1000.0;
+        if (shared != NULL)
+            publishSharedFrame(*shared, slot, passRes);
+        writeResponseHeader(stdout, passRes);
+        if (shared == NULL)
+            fwrite(image, 1, passRes.byteLength, stdout);
+        fflush(stdout);
+
+        fprintf(stderr, "Pass %d: 1/%d resolution after %.3f ms\n", pass, step, passRes.renderMs);
+        fflush(stderr);
+    }
+    return renderPass(iterations, 1, false, frame, opts, simd, &stats, &cancel);
+}
+
+int main(int argc, char **argv)
+{
+    if (answerProtocolVersion(argc, argv))
+        return 0;
+
+#ifdef _WIN32
+    // Sonst wandelt die C-Laufzeit 0x0A im Bild und in Binäranfragen in \r\n um
+    _setmode(_fileno(stdout), _O_BINARY);
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+    RenderOptions opts;
+    SimdLevel simd = detectSimdLevel();
+    bool verifySimd = false;
+    int tileSize = 0;
+    const char *outputPath = NULL;
+    bool textProtocol = false;
+    bool coalesce = true;
+    const char *sharedPath = NULL;
+    const char *palettePath = NULL;
+    int videoFrames = 0;
+    int tileCacheMb = TILE_CACHE_DEFAULT_MB;
+    const char *tileCacheDir = NULL;
+    bool benchmark = false;
+    double benchmarkScale = 1.0;
+
+    if (parseArguments(argc, argv, opts, simd, verifySimd, tileSize, outputPath, textProtocol, coalesce, sharedPath, palettePath, videoFrames,
+                       tileCacheMb, tileCacheDir, benchmark, benchmarkScale) != 0)
+    {
+        return 1;
+    }
+
+    if (verifySimd)
+    {
+        return verifySimdKernels() ? 0 : 1;
+    }
+    if (benchmark)
+    {
+        return runBenchmark(opts, simd, benchmarkScale) ? 0 : 1;
+    }
+
+    // Farbtabelle, neu gebaut, wenn eine Anfrage andere Farben bringt
+    Gradient gradient;
+    PaletteCache palettes = {};
+    if (palettePath != NULL)
+    {
+        if (!loadGradient(palettePath, gradient))
+            return 1;
+        palettes.gradient = &gradient;
+    }
+
+    fprintf(stderr, "OpenMP Backend started (%d threads, %s)\n", omp_get_max_threads(), simdLevelName(simd));
+    fflush(stderr);
+
+    uint8_t *h_image = NULL;
+    size_t currentImageSize = 0;
+    // Iterationen des letzten ungekachelten Bildes, zum Neufärben und Verschieben ohne Rechnen
+    int *h_iters = NULL;
+    size_t iterationPixels = 0;
+    // Glatte Iterationsanzahlen, erst mit der ersten Anfrage mit COLOR_FLAG_SMOOTH angelegt
+    float *h_smooth = NULL;
+    size_t smoothPixels = 0;
+    FrameCache cache = {};
+    ReferenceOrbit orbit = {NULL, NULL, 0, 0};
+    BlaTable bla = {NULL, 0, 0, {0}};
+
+    SharedFrames shared = {};
+    if (sharedPath != NULL && !openSharedFrames(shared, sharedPath))
+    {
+        fprintf(stderr, "Cannot create shared frame file %s\n", sharedPath);
+        return 1;
+    }
+    TileCache tiles;
+    if (!openTileCache(tiles, tileCacheMb, tileCacheDir, opts, "openmp"))
+        fprintf(stderr, "Out of memory for a %d MB tile cache, running without\n", tileCacheMb);
+
+    RequestQueue queue;
+    startRequestReader(queue, textProtocol, coalesce);
+
+    while (true)
+    {
+        FrameRequest req;
+        long long dropped;
+        RequestResult result = nextRequest(queue, req, dropped);
+        if (dropped > 0)
+        {
+            fprintf(stderr, "Skipped %lld stale requests\n", dropped);
+            fflush(stderr);
+        }
+        if (result == REQUEST_END)
+            break;
+
+        FrameResponse res = {req.requestId, req.pixelFormat, req.WIDTH, req.HEIGHT, PRECISION_AUTO, RESPONSE_INVALID_REQUEST, 0.0, 0, -1, 0, 0, 0, 1};
+        if (result == REQUEST_INVALID)
+        {
+            // Im Textprotokoll gibt es keine Antwort ohne Bild
+            if (!textProtocol)
+            {
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+            continue;
+        }
+
+        updatePalette(palettes, req.colors);
+        req.colors.palette = &palettes.palette;
+
+        bool recolor = (req.flags & REQUEST_FLAG_RECOLOR) != 0;
+        if (recolor)
+        {
+            if (!cache.valid)
+            {
+                fprintf(stderr, "Received #%u: recolor, but there is no frame to recolor\n", req.requestId);
+                fflush(stderr);
+                res.status = RESPONSE_FAILED;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+                continue;
+            }
+            // Format der Antwort ist das des gespeicherten Bildes
+            req.WIDTH = res.WIDTH = cache.frame.WIDTH;
+            req.HEIGHT = res.HEIGHT = cache.frame.HEIGHT;
+        }
+
+        size_t pixels = (size_t)req.WIDTH * req.HEIGHT;
+        size_t newImageSize = pixels * 3;
+        bool tiled = !recolor && (tileSize > 0 || (long long)newImageSize > TILE_FRAME_LIMIT);
+        if (tiled)
+            dropTiledColorFlags(req);
+        // Gestreamte Kacheln gehen weiter durch die Pipe
+        bool useShared = sharedPath != NULL && !tiled;
+
+        FILE *out = stdout;
+        if (outputPath != NULL)
+        {
+            out = fopen(outputPath, "wb");
+            if (out == NULL)
+            {
+                fprintf(stderr, "Cannot open output file %s\n", outputPath);
+                fflush(stderr);
+                if (!textProtocol)
+                {
+                    res.status = RESPONSE_FAILED;
+                    writeResponseHeader(stdout, res);
+                    fflush(stdout);
+                }
+                continue;
+            }
+        }
+
+        if (videoFrames > 0)
+        {
+            fprintf(stderr, "Received #%u: zoom video to zoom=%g, centerX=%.2f, centerY=%.2f, WIDTH=%d, HEIGHT=%d\n", req.requestId, req.zoom, req.centerX, req.centerY, req.WIDTH, req.HEIGHT);
+            fflush(stderr);
+            double start = omp_get_wtime();
+            Precision precision = PRECISION_AUTO;
+            bool ok = renderZoomVideo(out, req, videoFrames, opts, simd, orbit, bla, precision);
+            fclose(out);
+
+            res.precision = precision;
+            res.status = ok ? RESPONSE_OK : RESPONSE_FAILED;
+            res.renderMs = (omp_get_wtime() - start) * 1000.0;
+            if (!textProtocol)
+            {
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+            fprintf(stderr, "Zoom video time: %.3f ms\n", res.renderMs);
+            fflush(stderr);
+            cache.valid = false;
+            continue;
+        }
+
+        // Speicher nur neu zuweisen, wenn die Größe sich ändert; mit --shared-memory wird in einen Slot gerechnet
+        uint8_t *image = h_image;
+        int sharedSlot = -1;
+        if (!useShared && !tiled && newImageSize != currentImageSize)
+        {
+            free(h_image);
+            h_image = (uint8_t *)malloc(newImageSize);
+
+            if (h_image == NULL)
+            {
+                fprintf(stderr, "Out of memory for %d x %d frame\n", req.WIDTH, req.HEIGHT);
+                return 1;
+            }
+            currentImageSize = newImageSize;
+            image = h_image;
+        }
+        if (!tiled && pixels != iterationPixels)
+        {
+            free(h_iters);
+            h_iters = (int *)malloc(sizeof(int) * pixels);
+            if (h_iters == NULL)
+            {
+                fprintf(stderr, "Out of memory for %d x %d iteration buffer\n", req.WIDTH, req.HEIGHT);
+                return 1;
+            }
+            iterationPixels = pixels;
+        }
+        bool smooth = !recolor && !tiled && req.colors.smooth;
+        if (smooth && pixels != smoothPixels)
+        {
+            free(h_smooth);
+            h_smooth = (float *)malloc(sizeof(float) * pixels);
+            if (h_smooth == NULL)
+            {
+                fprintf(stderr, "Out of memory for %d x %d smooth iteration buffer\n", req.WIDTH, req.HEIGHT);
+                return 1;
+            }
+            smoothPixels = pixels;
+        }
+
+        if (recolor)
+            fprintf(stderr, "Received #%u: recolor, hue=%g, saturation=%g, brightness=%g, exponent=%g\n", req.requestId,
+                    req.colors.hueOffset, req.colors.saturation, req.colors.brightness, req.colors.exponent);
+        else
+            fprintf(stderr, "Received #%u: zoom=%.2f, centerX=%.2f, centerY=%.2f, WIDTH=%d, HEIGHT=%d\n", req.requestId, req.zoom, req.centerX, req.centerY, req.WIDTH, req.HEIGHT);
+        fflush(stderr);
+
+        // Timing START
+        double start = omp_get_wtime();
+
+        FrameParams frame = cache.frame;
+        RenderStats stats = {0, 0};
+        bool ready = recolor || prepareFrame(frame, req, opts, orbit, bla);
+        // Bilder auf dem Raster des Kachelcaches übernehmen, was er von ihnen hat, und füllen ihn
+        int64_t originX = 0, originY = 0;
+        bool onGrid = ready && !recolor && !tiled && tiles.capacity > 0 && tileOrigin(frame, originX, originY);
+        TileCacheStats tileStats = {0, 0, 0};
+
+        res.precision = frame.precision;
+        res.status = ready ? RESPONSE_OK : RESPONSE_FAILED;
+        // Das Bild geht mit --output in die Datei, über stdout kommt dann nur der Kopf
+        res.byteLength = outputPath != NULL ? 0 : newImageSize;
+
+        if (tiled)
+        {
+            // Kacheln gehen schon während der Berechnung hinaus, die Zeit enthält das Schreiben;
+            // der Kopf muss vorher raus und kennt sie noch nicht
+            if (!textProtocol)
+            {
+                res.renderMs = -1.0;
+                writeResponseHeader(stdout, res);
+            }
+            TileWriter writer;
+            int size = tileSize > 0 ? tileSize : TILE_SIZE_DEFAULT;
+            bool ok = openTileWriter(writer, out, outputPath != NULL, req.WIDTH, req.HEIGHT, size);
+            if (ok)
+                ok = ready ? renderFrameTiled(writer, frame, opts, req.colors, simd, &stats) : writeBlackTiles(writer);
+            if (!closeTileWriter(writer) || !ok)
+            {
+                fprintf(stderr, "Tiled output failed for %d x %d frame\n", req.WIDTH, req.HEIGHT);
+                return 1;
+            }
+            fprintf(stderr, "Tiled: %d x %d tiles of %d px\n", (req.WIDTH + size - 1) / size, (req.HEIGHT + size - 1) / size, size);
+            cache.valid = false;
+        }
+        else
+        {
+            // Beim Ziehen mit gleichem Zoom stehen die meisten Pixel schon im Puffer. Verschobene Bilder,
+            // Kacheln aus dem Cache und Vorschauen haben keine glatten Iterationsanzahlen, daher mit
+            // smooth alles neu; gespeichert wird trotzdem
+            int shiftX = 0, shiftY = 0;
+            bool panned = ready && !recolor && !smooth && opts.panCache && panShift(cache, frame, req, shiftX, shiftY);
+            if (onGrid && !panned && !smooth)
+                fetchTiles(tiles, frame, originX, originY, h_iters, tileStats);
+            bool cached = tileStats.hits > 0;
+            // Vorschauen nur, wenn die GUI sie sieht; ein verschobenes oder aus Kacheln gesetztes Bild ist ohnehin schnell fertig
+            bool progressive = ready && !recolor && !smooth && !panned && !cached && (req.flags & REQUEST_FLAG_PROGRESSIVE) &&
+                               !textProtocol && outputPath == NULL;
+            if (!recolor)
+                cache.valid = false;
+
+            bool complete = !progressive ||
+                            renderProgressive(h_iters, h_image, frame, req, res, opts, simd, stats, queue.cancel, useShared ? &shared : NULL, start);
+            if (useShared && complete)
+            {
+                image = beginSharedFrame(shared, newImageSize, sharedSlot);
+                if (image == NULL)
+                {
+                    fprintf(stderr, "Cannot grow shared frame file to %d x %d\n", req.WIDTH, req.HEIGHT);
+                    return 1;
+                }
+            }
+
+            if (!ready)
+                memset(image, 0, newImageSize);
+            else if (recolor)
+            {
+                if (!colorizeFrame(image, h_iters, pixels, frame.MAX_ITER, req.colors, cache.smooth ? h_smooth : NULL))
+                {
+                    memset(image, 0, newImageSize);
+                    res.status = RESPONSE_FAILED;
+                }
+            }
+            else if (progressive)
+            {
+                complete = complete && colorizeFrame(image, h_iters, pixels, frame.MAX_ITER, req.colors);
+                res.pass = PROGRESSIVE_PASSES - 1;
+                res.passes = PROGRESSIVE_PASSES;
+            }
+            else if (cached)
+                complete = renderFrameRemaining(image, h_iters, frame, opts, req.colors, simd, &stats, &queue.cancel);
+            else if (panned)
+                complete = renderFramePanned(image, h_iters, shiftX, shiftY, frame, opts, req.colors, simd, &stats, &queue.cancel);
+            else
+                complete = renderFrame(image, h_iters, frame, opts, req.colors, simd, &stats, &queue.cancel, smooth ? h_smooth : NULL);
+            if (panned && complete)
+                fprintf(stderr, "Panned by %d x %d px, reused %.1f%% of the pixels\n", shiftX, shiftY,
+                        100.0 * (req.WIDTH - abs(shiftX)) * (req.HEIGHT - abs(shiftY)) / pixels);
+
+            if (!complete)
+            {
+                // Eine neuere Anfrage wartet schon; das halbe Bild geht nicht mehr hinaus
+                fprintf(stderr, "Frame #%u cancelled after %.3f ms\n", req.requestId, (omp_get_wtime() - start) * 1000.0);
+                fflush(stderr);
+                if (sharedSlot >= 0)
+                    abortSharedFrame(shared, sharedSlot);
+                if (out != stdout)
+                    fclose(out);
+                continue;
+            }
+            if (ready && !recolor)
+                keepFrame(cache, frame, req);
+        }
+
+        // Timing STOP
+        double milliseconds = (omp_get_wtime() - start) * 1000.0;
+
+        if (useShared)
+        {
+            // Das Bild liegt schon im Slot, über die Pipe geht nur der Kopf
+            publishSharedFrame(shared, sharedSlot, res);
+            res.renderMs = milliseconds;
+            writeResponseHeader(stdout, res);
+            fflush(stdout);
+        }
+        else if (!tiled)
+        {
+            if (!textProtocol)
+            {
+                res.renderMs = milliseconds;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+            if (outputPath != NULL)
+                fprintf(out, "P6\n%d %d\n255\n", req.WIDTH, req.HEIGHT);
+            fwrite(image, 1, newImageSize, out);
+            fflush(out);
+        }
+        if (out != stdout)
+            fclose(out);
+        // Erst nach dem Senden, die GUI wartet nicht darauf
+        if (onGrid)
+            storeTiles(tiles, frame, originX, originY, h_iters);
+
+        if (tileStats.hits + tileStats.misses > 0)
+            fprintf(stderr, "Tile cache: %d hits (%d from disk), %d misses\n", tileStats.hits, tileStats.diskHits, tileStats.misses);
+        if (stats.steps > 0)
+        {
+            fprintf(stderr, "Perturbation: %lld iterations in %lld steps (%.1fx, %d BLA levels)\n",
+                    stats.iterations, stats.steps, (double)stats.iterations / stats.steps, frame.blaLevels);
+        }
+        if (recolor)
+            fprintf(stderr, "Recolor time: %.3f ms\n", milliseconds);
+        else
+            fprintf(stderr, "Frame render time: %.3f ms (%s)\n", milliseconds, precisionName(frame.precision));
+        fflush(stderr);
+    }
+    if (tiles.hits + tiles.misses > 0)
+        fprintf(stderr, "Tile cache: %lld hits, %lld misses in total\n", tiles.hits, tiles.misses);
+    closeTileCache(tiles);
+    freeReferenceOrbit(orbit);
+    freeBlaTable(bla);
+    free(h_image);
+    free(h_iters);
+    free(h_smooth);
+    if (sharedPath != NULL)
+        closeSharedFrames(shared);
+
+    fprintf(stderr, "OpenMP Backend clean exit\n");
+    fflush(stderr);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+/*
+ * Deque für Work-Stealing nach Chase und Lev, mit den Speicherordnungen aus Lê, Pop, Cohen, Zappa Nardelli:
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013). Nur der Besitzer legt
+ * unten ab und nimmt unten weg (LIFO, die zuletzt abgespaltene und damit noch im Cache liegende
+ * Arbeit zuerst), alle anderen Threads stehlen oben (die ältesten, meist größten Aufgaben).
+ *
+ * Die Kapazität ist fest; der Renderer legt höchstens seine Startkacheln und eine Hälfte einer
+ * geteilten Aufgabe ab (siehe renderFrameStealing() in CpuRenderer.cpp). Ist sie voll, schlägt
+ * pushTask() fehl und der Besitzer rechnet die Aufgabe selbst.
+ */
+
+/**
+ * @brief Rechteck des Bildes, das noch zu rechnen ist.
+ */
+struct StealTask
+{
+    int x0, y0, w, h;
+};
+
+struct StealDeque
+{
+    std::atomic<long long> top;
+    std::atomic<long long> bottom;
+    // Felder einzeln atomar, da ein Dieb einen Eintrag lesen kann, während der Besitzer ihn neu schreibt;
+    // gültig ist der gelesene Wert nur, wenn danach das CAS auf top gelingt
+    std::atomic<int> *slots;
+    long long mask;
+};
+
+/**
+ * @brief Legt eine leere Deque für mindestens capacity Aufgaben an.
+ *
+ * @return false bei fehlendem Speicher
+ */
+inline bool initStealDeque(StealDeque &deque, long long capacity)
+{
+    long long size = 1;
+    while (size < capacity)
+        size *= 2;
+    deque.slots = (std::atomic<int> *)malloc(sizeof(std::atomic<int>) * 4 * size);
+    if (deque.slots == NULL)
+        return false;
+    for (long long i = 0; i < 4 * size; i++)
+        new (&deque.slots[i]) std::atomic<int>(0);
+    deque.mask = size - 1;
+    deque.top.store(0, std::memory_order_relaxed);
+    deque.bottom.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+inline void freeStealDeque(StealDeque &deque)
+{
+    free(deque.slots);
+    deque.slots = NULL;
+}
+
+inline void writeSlot(StealDeque &deque, long long index, const StealTask &task)
+{
+    std::atomic<int> *slot = deque.slots + 4 * (index & deque.mask);
+    slot[0].store(task.x0, std::memory_order_relaxed);
+    slot[1].store(task.y0, std::memory_order_relaxed);
+    slot[2].store(task.w, std::memory_order_relaxed);
+    slot[3].store(task.h, std::memory_order_relaxed);
+}
+
+inline StealTask readSlot(const StealDeque &deque, long long index)
+{
+    const std::atomic<int> *slot = deque.slots + 4 * (index & deque.mask);
+    StealTask task = {slot[0].load(std::memory_order_relaxed), slot[1].load(std::memory_order_relaxed),
+                      slot[2].load(std::memory_order_relaxed), slot[3].load(std::memory_order_relaxed)};
+    return task;
+}
+
+/**
+ * @brief Legt eine Aufgabe unten ab. Nur vom Besitzer.
+ *
+ * @return false, wenn die Deque voll ist
+ */
+inline bool pushTask(StealDeque &deque, const StealTask &task)
+{
+    long long b = deque.bottom.load(std::memory_order_relaxed);
+    long long t = deque.top.load(std::memory_order_acquire);
+    if (b - t > deque.mask)
+        return false;
+    writeSlot(deque, b, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    deque.bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Nimmt die unterste Aufgabe. Nur vom Besitzer.
+ *
+ * @return false, wenn die Deque leer ist oder ein Dieb die letzte Aufgabe bekommen hat
+ */
+inline bool popTask(StealDeque &deque, StealTask &task)
+{
+    long long b = deque.bottom.load(std::memory_order_relaxed) - 1;
+    deque.bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long t = deque.top.load(std::memory_order_relaxed);
+    if (t > b)
+    {
+        deque.bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    task = readSlot(deque, b);
+    if (t == b)
+    {
+        // Letzte Aufgabe: gegen Diebe um sie wetteifern
+        bool won = deque.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        deque.bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+/**
+ * @brief Stiehlt die oberste Aufgabe. Von jedem Thread.
+ *
+ * @return false, wenn die Deque leer ist oder ein anderer Thread schneller war
+ */
+inline bool stealTask(StealDeque &deque, StealTask &task)
+{
+    long long t = deque.top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long b = deque.bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return false;
+
+    task = readSlot(deque, t);
+    return deque.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+/**
+ * @brief true, wenn die Deque leer aussieht. Ungenau, nur für die Entscheidung, ob sich Teilen lohnt.
+ */
+inline bool stealDequeEmpty(const StealDeque &deque)
+{
+    return deque.bottom.load(std::memory_order_relaxed) <= deque.top.load(std::memory_order_relaxed);
+}
+
+#endif
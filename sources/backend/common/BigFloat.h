@@ -0,0 +1,307 @@
+#ifndef BIG_FLOAT_H
+#define BIG_FLOAT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Festkomma-Zahl beliebiger Genauigkeit für den Referenzorbit der Störungsrechnung.
+ * Nur Host-Code, kommt ohne externe Bibliothek (MPFR, GMP) aus.
+ *
+ * d[0] ist der ganzzahlige Anteil, d[1..limbs-1] die Nachkommastellen in 32-Bit-Worten:
+ *   |x| = d[0] + d[1] * 2^-32 + d[2] * 2^-64 + ...
+ * Das Vorzeichen steht getrennt in negative. Für die Mandelbrot-Iteration reicht der
+ * ganzzahlige Anteil bis 2^32 bei weitem, Überläufe darüber werden nicht behandelt.
+ */
+#define BIGFLOAT_MAX_LIMBS 40
+
+struct BigFloat
+{
+    bool negative;
+    int limbs;
+    uint32_t d[BIGFLOAT_MAX_LIMBS];
+};
+
+/**
+ * @brief Anzahl Worte für eine Zahl, die Abstände von scale noch mit guardBits Bits Reserve auflöst.
+ *
+ * @param scale kleinste aufzulösende Größe (Pixelabstand)
+ * @param guardBits
+ * @return Anzahl der 32-Bit-Worte inklusive ganzzahligem Anteil, höchstens BIGFLOAT_MAX_LIMBS
+ */
+inline int bigFloatLimbsFor(double scale, int guardBits)
+{
+    int bits = (int)ceil(-log2(scale)) + guardBits;
+    int limbs = 1 + (bits + 31) / 32;
+    if (limbs < 3)
+        limbs = 3;
+    if (limbs > BIGFLOAT_MAX_LIMBS)
+        limbs = BIGFLOAT_MAX_LIMBS;
+    return limbs;
+}
+
+inline void bigFloatZero(BigFloat &a, int limbs)
+{
+    a.negative = false;
+    a.limbs = limbs;
+    memset(a.d, 0, sizeof(a.d));
+}
+
+inline bool bigFloatIsZero(const BigFloat &a)
+{
+    for (int i = 0; i < a.limbs; i++)
+    {
+        if (a.d[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Vergleicht die Beträge zweier Zahlen gleicher Genauigkeit.
+ *
+ * @return -1, 0 oder 1 wie bei strcmp
+ */
+inline int bigFloatCompareMagnitude(const BigFloat &a, const BigFloat &b)
+{
+    for (int i = 0; i < a.limbs; i++)
+    {
+        if (a.d[i] != b.d[i])
+            return a.d[i] < b.d[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// |r| = |a| + |b|
+inline void bigFloatAddMagnitude(BigFloat &r, const BigFloat &a, const BigFloat &b)
+{
+    uint64_t carry = 0;
+    for (int i = a.limbs - 1; i >= 0; i--)
+    {
+        uint64_t sum = (uint64_t)a.d[i] + b.d[i] + carry;
+        r.d[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+}
+
+// |r| = |a| - |b|, setzt |a| >= |b| voraus
+inline void bigFloatSubMagnitude(BigFloat &r, const BigFloat &a, const BigFloat &b)
+{
+    int64_t borrow = 0;
+    for (int i = a.limbs - 1; i >= 0; i--)
+    {
+        int64_t diff = (int64_t)a.d[i] - b.d[i] - borrow;
+        borrow = diff < 0 ? 1 : 0;
+        r.d[i] = (uint32_t)(diff + (borrow << 32));
+    }
+}
+
+/**
+ * @brief r = a + b. r darf a oder b sein.
+ */
+inline void bigFloatAdd(BigFloat &r, const BigFloat &a, const BigFloat &b)
+{
+    BigFloat result;
+    result.limbs = a.limbs;
+
+    if (a.negative == b.negative)
+    {
+        bigFloatAddMagnitude(result, a, b);
+        result.negative = a.negative;
+    }
+    else if (bigFloatCompareMagnitude(a, b) >= 0)
+    {
+        bigFloatSubMagnitude(result, a, b);
+        result.negative = a.negative;
+    }
+    else
+    {
+        bigFloatSubMagnitude(result, b, a);
+        result.negative = b.negative;
+    }
+
+    if (bigFloatIsZero(result))
+        result.negative = false;
+    r = result;
+}
+
+/**
+ * @brief r = a - b. r darf a oder b sein.
+ */
+inline void bigFloatSub(BigFloat &r, const BigFloat &a, const BigFloat &b)
+{
+    BigFloat negB = b;
+    negB.negative = !b.negative;
+    bigFloatAdd(r, a, negB);
+}
+
+/**
+ * @brief r = a * b, auf die Genauigkeit von a abgeschnitten. r darf a oder b sein.
+ * Schulbuch-Multiplikation in O(limbs^2).
+ */
+inline void bigFloatMul(BigFloat &r, const BigFloat &a, const BigFloat &b)
+{
+    int n = a.limbs;
+
+    // Als ganze Zahlen in Little-Endian-Reihenfolge multiplizieren, dann um n-1 Worte zurückschieben
+    uint32_t product[2 * BIGFLOAT_MAX_LIMBS];
+    memset(product, 0, sizeof(uint32_t) * 2 * n);
+
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t ai = a.d[n - 1 - i];
+        if (ai == 0)
+            continue;
+
+        uint64_t carry = 0;
+        for (int j = 0; j < n; j++)
+        {
+            uint64_t cur = product[i + j] + ai * b.d[n - 1 - j] + carry;
+            product[i + j] = (uint32_t)cur;
+            carry = cur >> 32;
+        }
+        product[i + n] = (uint32_t)carry;
+    }
+
+    BigFloat result;
+    result.limbs = n;
+    for (int k = 0; k < n; k++)
+    {
+        result.d[k] = product[2 * n - 2 - k];
+    }
+    result.negative = (a.negative != b.negative) && !bigFloatIsZero(result);
+    r = result;
+}
+
+/**
+ * @brief Teilt den Betrag durch eine kleine ganze Zahl (für das Einlesen von Dezimalzahlen).
+ */
+inline void bigFloatDivSmall(BigFloat &a, uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (int i = 0; i < a.limbs; i++)
+    {
+        uint64_t cur = (remainder << 32) | a.d[i];
+        a.d[i] = (uint32_t)(cur / divisor);
+        remainder = cur % divisor;
+    }
+}
+
+inline void bigFloatFromDouble(BigFloat &a, double v, int limbs)
+{
+    bigFloatZero(a, limbs);
+    a.negative = v < 0.0;
+    v = fabs(v);
+
+    double integral = floor(v);
+    a.d[0] = (uint32_t)integral;
+    v -= integral;
+
+    // Ein double hat höchstens 53 signifikante Bits, nach wenigen Worten ist der Rest 0
+    for (int i = 1; i < limbs && v > 0.0; i++)
+    {
+        v *= 4294967296.0;
+        double part = floor(v);
+        a.d[i] = (uint32_t)part;
+        v -= part;
+    }
+}
+
+inline double bigFloatToDouble(const BigFloat &a)
+{
+    double v = 0.0;
+    double weight = 1.0;
+    for (int i = 0; i < a.limbs && i < 4; i++)
+    {
+        v += a.d[i] * weight;
+        weight *= 1.0 / 4294967296.0;
+    }
+    return a.negative ? -v : v;
+}
+
+/**
+ * @brief Liest eine Dezimalzahl wie "-1.484610808411835" oder "-4.721191790807227E-10" exakt auf
+ * die gewünschte Genauigkeit ein, ohne den Umweg über double.
+ *
+ * @param a Ergebnis
+ * @param text
+ * @param limbs
+ * @return false bei ungültiger Eingabe oder zu großem ganzzahligem Anteil
+ */
+inline bool bigFloatFromString(BigFloat &a, const char *text, int limbs)
+{
+    bigFloatZero(a, limbs);
+
+    const char *p = text;
+    bool negative = false;
+    if (*p == '+' || *p == '-')
+        negative = *p++ == '-';
+
+    // Ziffern ohne Punkt sammeln und merken, wie viele vor dem Punkt stehen
+    char digits[512];
+    int count = 0;
+    int pointPos = -1;
+    for (; *p != '\0'; p++)
+    {
+        if (*p >= '0' && *p <= '9')
+        {
+            if (count >= (int)sizeof(digits))
+                return false;
+            digits[count++] = *p;
+        }
+        else if (*p == '.' && pointPos < 0)
+        {
+            pointPos = count;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (count == 0)
+        return false;
+    if (pointPos < 0)
+        pointPos = count;
+
+    if (*p == 'e' || *p == 'E')
+    {
+        char *end;
+        long exponent = strtol(p + 1, &end, 10);
+        if (end == p + 1 || *end != '\0' || exponent < -400 || exponent > 400)
+            return false;
+        pointPos += (int)exponent;
+    }
+    else if (*p != '\0')
+    {
+        return false;
+    }
+
+    // Ganzzahliger Anteil: Ziffern vor dem Punkt (Horner)
+    uint64_t integral = 0;
+    for (int i = 0; i < pointPos; i++)
+    {
+        integral = integral * 10 + (i < count ? digits[i] - '0' : 0);
+        if (integral > 0xFFFFFFFFull)
+            return false;
+    }
+
+    // Nachkommastellen von hinten: x = (d1 + (d2 + (d3 + ...) / 10) / 10) / 10
+    for (int i = count - 1; i >= 0 && i >= pointPos; i--)
+    {
+        a.d[0] += digits[i] - '0';
+        bigFloatDivSmall(a, 10);
+    }
+    // Führende Nullen bei Exponenten wie E-10 (Punkt links der ersten Ziffer)
+    for (int i = pointPos; i < 0; i++)
+    {
+        bigFloatDivSmall(a, 10);
+    }
+
+    a.d[0] = (uint32_t)integral;
+    a.negative = negative && !bigFloatIsZero(a);
+    return true;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef DOUBLE_DOUBLE_H
+#define DOUBLE_DOUBLE_H
+
+#include <math.h>
+
+/*
+ * Double-Double-Arithmetik: eine Zahl ist die unausgewertete Summe hi + lo zweier doubles mit
+ * |lo| <= ulp(hi) / 2, zusammen etwa 106 Bit Mantisse. Reicht für Zooms bis etwa 1e26, wo
+ * double bei etwa 1e12 aufhört. Wird nur über FractalCore.h eingebunden (FRACTAL_HD).
+ *
+ * Die Fehlerterme der Produkte werden auf dem Host nach Dekker über das Aufspalten in halbe
+ * Mantissen berechnet, auf der GPU per fma(). Beide sind exakt und liefern dasselbe Ergebnis;
+ * die SIMD-Kernel in FractalSimdKernel.h rechnen dieselbe Operationsfolge wie hier.
+ * Wie beim double-Pfad darf der Compiler nichts zu FMA zusammenziehen (-ffp-contract=off).
+ */
+
+// 2^27 + 1: zerlegt ein double in zwei Hälften mit je höchstens 26 signifikanten Bits
+#define DD_SPLITTER 134217729.0
+
+struct DoubleDouble
+{
+    double hi, lo;
+
+    FRACTAL_HD DoubleDouble() : hi(0.0), lo(0.0) {}
+    FRACTAL_HD DoubleDouble(double v) : hi(v), lo(0.0) {}
+    FRACTAL_HD DoubleDouble(double h, double l) : hi(h), lo(l) {}
+};
+
+// s + e == a + b exakt
+FRACTAL_HD inline void ddTwoSum(double a, double b, double &s, double &e)
+{
+    s = a + b;
+    double bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+}
+
+// Wie ddTwoSum(), setzt |a| >= |b| voraus
+FRACTAL_HD inline void ddQuickTwoSum(double a, double b, double &s, double &e)
+{
+    s = a + b;
+    e = b - (s - a);
+}
+
+// p + e == a * b exakt
+FRACTAL_HD inline void ddTwoProd(double a, double b, double &p, double &e)
+{
+    p = a * b;
+#ifdef __CUDA_ARCH__
+    e = fma(a, b, -p);
+#else
+    double t = DD_SPLITTER * a;
+    double ah = t - (t - a);
+    double al = a - ah;
+    t = DD_SPLITTER * b;
+    double bh = t - (t - b);
+    double bl = b - bh;
+    e = (((ah * bh - p) + ah * bl) + al * bh) + al * bl;
+#endif
+}
+
+FRACTAL_HD inline DoubleDouble operator+(const DoubleDouble &a, const DoubleDouble &b)
+{
+    double s, e;
+    ddTwoSum(a.hi, b.hi, s, e);
+    e = e + (a.lo + b.lo);
+    DoubleDouble r;
+    ddQuickTwoSum(s, e, r.hi, r.lo);
+    return r;
+}
+
+FRACTAL_HD inline DoubleDouble operator-(const DoubleDouble &a, const DoubleDouble &b)
+{
+    return a + DoubleDouble(-b.hi, -b.lo);
+}
+
+FRACTAL_HD inline DoubleDouble operator*(const DoubleDouble &a, const DoubleDouble &b)
+{
+    double p, e;
+    ddTwoProd(a.hi, b.hi, p, e);
+    e = e + (a.hi * b.lo + a.lo * b.hi);
+    DoubleDouble r;
+    ddQuickTwoSum(p, e, r.hi, r.lo);
+    return r;
+}
+
+FRACTAL_HD inline double toDouble(const DoubleDouble &v)
+{
+    return v.hi;
+}
+
+// Typ, in dem mandelbrot() Betrag und Periodizität vergleicht: float und double bleiben, wie sie sind
+// (die float-Stufe soll auf der GPU keine double-Befehle ausführen), Double-Double nur mit hi
+template <typename Real>
+struct ScalarType
+{
+    typedef Real type;
+};
+
+template <>
+struct ScalarType<DoubleDouble>
+{
+    typedef double type;
+};
+
+FRACTAL_HD inline float toScalar(float v)
+{
+    return v;
+}
+
+FRACTAL_HD inline double toScalar(double v)
+{
+    return v;
+}
+
+FRACTAL_HD inline double toScalar(const DoubleDouble &v)
+{
+    return toDouble(v);
+}
+
+// 2 v, für float, double und Double-Double exakt
+FRACTAL_HD inline float twice(float v)
+{
+    return 2.0f * v;
+}
+
+FRACTAL_HD inline double twice(double v)
+{
+    return 2.0 * v;
+}
+
+FRACTAL_HD inline DoubleDouble twice(const DoubleDouble &v)
+{
+    return DoubleDouble(2.0 * v.hi, 2.0 * v.lo);
+}
+
+#endif
@@ -0,0 +1,722 @@
+#ifndef FRACTAL_CORE_H
+#define FRACTAL_CORE_H
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+ * Gemeinsame Mandelbrot-Mathematik aller Backends. Unter nvcc werden die
+ * Funktionen für Host und Device übersetzt, in den C++-Backends sind es
+ * normale Inline-Funktionen. So rechnen CUDA- und CPU-Backend dieselbe Formel.
+ * Dieselben Iterationen ergeben sich nur, wenn kein Compiler zu FMA zusammenzieht
+ * (nvcc -fmad=false, g++ -ffp-contract=off, siehe docs/makescript); glatte Farben
+ * gehen zusätzlich durch log2() der jeweiligen Mathematikbibliothek und können
+ * in der letzten Stelle abweichen.
+ */
+#ifdef __CUDACC__
+#define FRACTAL_HD __host__ __device__
+#else
+#define FRACTAL_HD
+#endif
+
+#include "DoubleDouble.h"
+
+/**
+ * @brief Rechenverfahren für ein Bild. PRECISION_AUTO wählt anhand der Pixelgröße, siehe selectPrecision().
+ */
+enum Precision
+{
+    PRECISION_AUTO = -1,
+    // Einfache Genauigkeit für flache Zooms: auf GPUs ein Vielfaches, auf der CPU doppelt so viele Lanes
+    PRECISION_FLOAT = 0,
+    PRECISION_DOUBLE = 1,
+    // Jedes Pixel in Double-Double (etwa 106 Bit), siehe DoubleDouble.h
+    PRECISION_DOUBLE_DOUBLE = 2,
+    // Referenzorbit in hoher Genauigkeit auf dem Host, pro Pixel nur die Abweichung in double
+    PRECISION_PERTURBATION = 3
+};
+
+/**
+ * @brief Schalter für die Berechnung, die beide Backends gleich verstehen.
+ * Wird per Wert an die Kernel übergeben.
+ */
+struct RenderOptions
+{
+    // Punkte in der Hauptkardioide und der Periode-2-Knospe sofort als innen werten.
+    // Zum Validieren abschaltbar (--no-interior-check).
+    bool interiorCheck = true;
+
+    // Periodische Orbits (Brent) erkennen und als innen werten. Die Toleranz ist relativ
+    // zur Pixelgröße scale, siehe periodTolerance(). Abschaltbar mit --no-periodicity-check;
+    // das CUDA-Backend startet ohne und schaltet sie mit --periodicity-check ein.
+    bool periodicityCheck = true;
+    double periodicityTolerance = 1e-3;
+
+    // Mariani-Silver: Kachelränder rechnen und Kacheln mit einheitlichem Rand füllen
+    // statt jedes Pixel zu iterieren (--mariani-silver). Heuristik, daher standardmäßig aus.
+    bool marianiSilver = false;
+
+    // Rechenverfahren erzwingen (--precision), sonst automatisch
+    Precision precision = PRECISION_AUTO;
+
+    // Bei Störungsrechnung Iterationen per bilinearer Näherung überspringen (--no-bla zum Validieren)
+    bool bla = true;
+
+    // Beim Verschieben ohne Zoomänderung die Iterationen des vorigen Bildes weiterverwenden, siehe
+    // FrameCache.h (--no-pan-cache zum Validieren). Nur auf dem Host ausgewertet.
+    bool panCache = true;
+
+    // Bildkacheln per Work-Stealing statt Zeilen per OpenMP-Schedule verteilen (--schedule steal).
+    // Nur auf dem Host ausgewertet, ändert keine Pixel.
+    bool workStealing = false;
+
+    // In float und double zuerst ganze Kacheln per Intervallarithmetik als innen oder einheitlich
+    // entkommen erkennen und füllen, siehe IntervalTiles.h (--no-interval-tiles zum Validieren).
+    // Nur auf dem Host ausgewertet, ändert keine Pixel.
+    bool intervalTiles = true;
+};
+
+// Einträge der Farbtabelle pro Einheit des Farbwerts (0-255). Ganzzahlige Farbwerte aus iterToColor()
+// treffen so genau einen Eintrag, glatte liegen höchstens 1/32 daneben
+#define PALETTE_SCALE 16
+#define PALETTE_SIZE (255 * PALETTE_SCALE + 1)
+
+/**
+ * @brief Farbtabelle: RGB für jeden Farbwert in Schritten von 1 / PALETTE_SCALE, Eintrag 0 (Farbwert 0,
+ * Punkte der Menge) ist schwarz. Ersetzt die HSV-Umrechnung pro Pixel durch ein Nachschlagen, siehe
+ * Palette.h für Aufbau und Verläufe aus Dateien.
+ */
+struct Palette
+{
+    uint8_t rgb[3 * PALETTE_SIZE];
+    // Dieselben Farbwerte über den ganzen Farbkreis statt bis 255 Grad, für die glatte Färbung (wheelToRGB())
+    uint8_t wheel[3 * PALETTE_SIZE];
+};
+
+/**
+ * @brief Farbabbildung eines Bildes, kommt mit jeder Anfrage. Die Standardwerte ergeben die bisherigen
+ * Farben; ein Wechsel braucht nur einen neuen Färbedurchlauf über die gespeicherten Iterationen.
+ */
+struct ColorOptions
+{
+    // Verschiebung des Farbtons in Grad
+    double hueOffset = 0.0;
+    // Sättigung und Helligkeit im HSV-Modell, 0 bis 1
+    double saturation = 0.8;
+    double brightness = 1.0;
+    // Exponent der Abbildung iter / MAX_ITER -> Farbwert; kleiner hebt niedrige Iterationen an
+    double exponent = 0.5;
+    // Farbwert stufenlos aus der normierten Iterationsanzahl (smoothIterations()) statt aus der
+    // ganzzahligen; braucht beim Rechnen |z| beim Entkommen, siehe COLOR_FLAG_SMOOTH
+    bool smooth = false;
+    // Farbwert aus der Verteilung der Iterationen im Bild (Histogrammausgleich) statt aus iter / MAX_ITER,
+    // jede Farbe deckt etwa gleich viele Pixel ab; exponent wirkt dann nicht. Braucht das ganze Bild,
+    // gekachelt gestreamte Bilder bekommen die gewohnten Farben, siehe COLOR_FLAG_HISTOGRAM
+    bool histogram = false;
+    // Farbtabelle zu Farbton, Sättigung und Helligkeit (Palette.h), auf der GPU im Gerätespeicher.
+    // Gehört nicht zur Anfrage, das Backend setzt sie vor dem Färben; NULL rechnet valueToRGB() pro Pixel
+    const Palette *palette = NULL;
+};
+
+// Höchste Stufe der BLA-Tabelle; Stufe l überspringt 2^l Iterationen
+#define BLA_MAX_LEVELS 24
+// Abstand der Suchversuche nach einer ungültigen Näherung, Zweierpotenz
+#define BLA_RETRY 8
+
+/**
+ * @brief Bilineare Näherung (BLA) für 2^l Iterationen ab Referenzindex m:
+ * dz_{m+2^l} = A dz_m + B dc, gültig solange |dz_m|^2 < r2.
+ */
+struct BlaStep
+{
+    double Ar, Ai;
+    double Br, Bi;
+    double r2;
+};
+
+/**
+ * @brief Alles, was ein Kernel über das aktuelle Bild wissen muss. Wird per Wert übergeben;
+ * die Zeiger des Referenzorbits zeigen je nach Backend in Host- oder Device-Speicher.
+ */
+struct FrameParams
+{
+    double scale, centerX, centerY;
+    int WIDTH, HEIGHT;
+    int MAX_ITER;
+    Precision precision;
+
+    // Nur PRECISION_DOUBLE_DOUBLE: Rest des Zentrums, der nicht in centerX/centerY passt
+    double centerXLo, centerYLo;
+
+    // Nur PRECISION_PERTURBATION: Referenzorbit Z_0..Z_{refLength-1} um (centerX, centerY)
+    const double *refReal;
+    const double *refImag;
+    int refLength;
+
+    // BLA-Tabelle zum Referenzorbit, blaLevels == 0 ohne. Stufe l liegt bei
+    // bla[blaOffset[l] .. blaOffset[l + 1] - 1], Eintrag j beginnt bei Referenzindex 1 + j * 2^l.
+    const BlaStep *bla;
+    int blaLevels;
+    int blaOffset[BLA_MAX_LEVELS + 1];
+};
+
+/**
+ * @brief Absolute Toleranz für die Periodizitätsprüfung in mandelbrot() bei gegebener Pixelgröße.
+ *
+ * @param opts
+ * @param scale
+ * @return Toleranz, negativ wenn die Prüfung abgeschaltet ist
+ */
+FRACTAL_HD inline double periodTolerance(const RenderOptions &opts, double scale)
+{
+    return opts.periodicityCheck ? opts.periodicityTolerance * scale : -1.0;
+}
+
+/**
+ * @brief Bestimmt die maximale Iterationsanzahl für die aktuelle Pixelgröße.
+ * Je tiefer gezoomt wird, desto mehr Iterationen sind nötig, um den Rand der Menge aufzulösen.
+ *
+ * @param scale Abstand zweier Pixel in der komplexen Ebene
+ * @param WIDTH Bildbreite in Pixeln
+ * @return maximale Iterationsanzahl (100 bis 8192)
+ */
+FRACTAL_HD inline int computeMaxIter(double scale, int WIDTH)
+{
+    const double INITIAL_SCALE_AT_ZOOM_1 = 4.0 / WIDTH;
+
+    int MAX_ITER = 256;
+    if (scale > 0)
+    {
+
+        MAX_ITER += (int)(log(INITIAL_SCALE_AT_ZOOM_1 / scale) * 50.0);
+
+        if (MAX_ITER < 100)
+            MAX_ITER = 100;
+        if (MAX_ITER > 8192)
+            MAX_ITER = 8192;
+    }
+    return MAX_ITER;
+}
+
+// Iterationen nach dem Entkommen, bevor |z|^2 für smoothIterations() genommen wird. |z| wächst dabei
+// von über 2 auf etwa 2^8; die Glättung ist so genau wie mit Fluchtradius 2^8, ohne dass sich die
+// ganzzahligen Iterationsanzahlen ändern
+#define SMOOTH_EXTRA_ITER 3
+
+/**
+ * @brief |z|^2 für smoothIterations(): rechnet von einem entkommenen z aus SMOOTH_EXTRA_ITER weitere
+ * Iterationen, in derselben Operationsfolge wie mandelbrot(). Real ist float, double oder DoubleDouble.
+ */
+template <typename Real>
+FRACTAL_HD inline float escapeNorm(Real z_real, Real z_imag, Real real, Real imag)
+{
+    for (int k = 0; k < SMOOTH_EXTRA_ITER; k++)
+    {
+        Real temp = z_real * z_real - z_imag * z_imag + real;
+        z_imag = twice(z_real) * z_imag + imag;
+        z_real = temp;
+    }
+    return (float)toScalar(z_real * z_real + z_imag * z_imag);
+}
+
+/**
+ * @brief  Berechnet die Anzahl der Iterationen für einen Punkt im Mandelbrot
+ * Mit tolerance >= 0 wird der Orbit nach Brent auf Periodizität geprüft: der Punkt wird zu
+ * Iteration 1, 2, 4, 8, ... gemerkt und jeder folgende Orbitpunkt damit verglichen. Kommt der
+ * Orbit einem gemerkten Punkt näher als tolerance, ist er in einen Zyklus gelaufen, entkommt
+ * nie und bekommt sofort max_iter, statt das ganze Budget zu verbrauchen.
+ * Real ist float, double oder DoubleDouble.
+ *
+ * @param real
+ * @param imag
+ * @param max_iter
+ * @param tolerance siehe periodTolerance(), negativ schaltet die Prüfung ab
+ * @param norm wenn nicht NULL: Ergebnis, escapeNorm() für smoothIterations(); bleibt unverändert,
+ * wenn der Punkt nicht entkommt
+ * @return anzahl der Iterationen
+ */
+template <typename Real>
+FRACTAL_HD inline int mandelbrot(Real real, Real imag, int max_iter, typename ScalarType<Real>::type tolerance = -1, float *norm = NULL)
+{
+    typedef typename ScalarType<Real>::type Scalar;
+    Real z_real = 0.0, z_imag = 0.0;
+    Real saved_real = 0.0, saved_imag = 0.0;
+    int check = 0, checkLimit = 1;
+    int iter = 0;
+    while (iter < max_iter)
+    {
+        Scalar mag = toScalar(z_real * z_real + z_imag * z_imag);
+        if (!(mag <= Scalar(4)))
+        {
+            if (norm != NULL)
+                *norm = escapeNorm(z_real, z_imag, real, imag);
+            break;
+        }
+
+        Real temp = z_real * z_real - z_imag * z_imag + real;
+        z_imag = twice(z_real) * z_imag + imag;
+        z_real = temp;
+        iter++;
+
+        if (tolerance >= Scalar(0))
+        {
+            // |d| <= tolerance ohne fabs(), das für float nicht überall eine float-Überladung hat
+            Scalar dr = toScalar(z_real - saved_real);
+            Scalar di = toScalar(z_imag - saved_imag);
+            if (dr <= tolerance && -dr <= tolerance && di <= tolerance && -di <= tolerance)
+                return max_iter;
+
+            if (++check == checkLimit)
+            {
+                saved_real = z_real;
+                saved_imag = z_imag;
+                check = 0;
+                checkLimit *= 2;
+            }
+        }
+    }
+    return iter;
+}
+
+/**
+ * @brief Prüft analytisch, ob ein Punkt in der Hauptkardioide oder der Periode-2-Knospe liegt.
+ * Diese Punkte entkommen nie und würden sonst alle max_iter Iterationen durchlaufen.
+ *
+ * @param real
+ * @param imag
+ * @return true, wenn der Punkt sicher in der Menge liegt
+ */
+template <typename Real>
+FRACTAL_HD inline bool isInMainCardioidOrBulb(Real real, Real imag)
+{
+    Real xm = real - Real(0.25);
+    Real y2 = imag * imag;
+    Real q = xm * xm + y2;
+    if (q * (q + xm) <= Real(0.25) * y2)
+        return true;
+
+    Real xp = real + Real(1.0);
+    return xp * xp + y2 <= Real(0.0625);
+}
+
+/**
+ * @brief Wie isInMainCardioidOrBulb() für float und double, in Double-Double. Bei tiefen Zooms an der
+ * Kardioide (Seepferdchental) würde das auf double gerundete c Pixel falsch einordnen.
+ */
+FRACTAL_HD inline bool isInMainCardioidOrBulb(const DoubleDouble &real, const DoubleDouble &imag)
+{
+    DoubleDouble xm = real - 0.25;
+    DoubleDouble y2 = imag * imag;
+    DoubleDouble q = xm * xm + y2;
+    if (toDouble(q * (q + xm) - 0.25 * y2) <= 0.0)
+        return true;
+
+    DoubleDouble xp = real + 1.0;
+    return toDouble(xp * xp + y2 - 0.0625) <= 0.0;
+}
+
+/**
+ * @brief Iterationen für einen Punkt mit allen Abkürzungen aus opts, so wie render() sie rechnet.
+ *
+ * @param real
+ * @param imag
+ * @param max_iter
+ * @param opts
+ * @param tolerance Ergebnis von periodTolerance() für das aktuelle Bild, für float auf float gerundet
+ * @param norm wie bei mandelbrot()
+ * @return anzahl der Iterationen
+ */
+template <typename Real>
+FRACTAL_HD inline int computeIterations(Real real, Real imag, int max_iter, const RenderOptions &opts,
+                                        typename ScalarType<Real>::type tolerance, float *norm = NULL)
+{
+    if (opts.interiorCheck && isInMainCardioidOrBulb(real, imag))
+        return max_iter;
+    return mandelbrot(real, imag, max_iter, tolerance, norm);
+}
+
+/**
+ * @brief Iterationen für einen Punkt per Störungsrechnung. Statt z wird nur die Abweichung dz vom
+ * Referenzorbit Z iteriert: dz' = 2 Z dz + dz^2 + dc. Dafür reicht double auch dort, wo c selbst
+ * in double nicht mehr darstellbar ist.
+ * Glitches entstehen, wenn |Z + dz| kleiner als |dz| wird: dann ist dz nicht mehr klein gegen den
+ * Orbit und verliert seine Genauigkeit. In diesem Fall (und am Ende eines entkommenen Referenzorbits)
+ * wird auf den Anfang des Referenzorbits umgesetzt (dz = Z + dz, Index 0), so dass ein einziger
+ * Referenzorbit für das ganze Bild reicht.
+ * Mit BLA-Tabelle wird vor jedem Schritt die längste gültige Näherung ab dem aktuellen Index gesucht
+ * und damit 2^l Iterationen auf einmal gerechnet.
+ *
+ * @param f Bildparameter mit Referenzorbit und BLA-Tabelle
+ * @param dcr Abstand des Punktes vom Referenzpunkt, Realteil
+ * @param dci Abstand des Punktes vom Referenzpunkt, Imaginärteil
+ * @param steps wenn nicht NULL: Ergebnis, tatsächlich gerechnete Schritte
+ * @param norm wie bei mandelbrot()
+ * @return anzahl der Iterationen
+ */
+FRACTAL_HD inline int mandelbrotPerturbed(const FrameParams &f, double dcr, double dci, int *steps = NULL, float *norm = NULL)
+{
+    const double *refReal = f.refReal;
+    const double *refImag = f.refImag;
+    int max_iter = f.MAX_ITER;
+    double dzr = 0.0, dzi = 0.0;
+    int m = 0;
+    int iter = 0;
+    int done = 0;
+    // Nach einer erfolglosen Suche nur noch bei jedem BLA_RETRY-ten Index suchen, dz wächst fast immer
+    int blaMask = 0;
+    while (iter < max_iter)
+    {
+        double zr = refReal[m] + dzr;
+        double zi = refImag[m] + dzi;
+        double mag = zr * zr + zi * zi;
+        if (mag > 4.0)
+        {
+            // c selbst ist in double nur gerundet, für die paar Schritte hinter dem Fluchtradius reicht das
+            if (norm != NULL)
+                *norm = escapeNorm(zr, zi, f.centerX + dcr, f.centerY + dci);
+            break;
+        }
+
+        double dz2 = dzr * dzr + dzi * dzi;
+        if (mag < dz2 || m == f.refLength - 1)
+        {
+            dzr = zr;
+            dzi = zi;
+            dz2 = mag;
+            m = 0;
+            blaMask = 0;
+        }
+        done++;
+
+        if (m > 0 && f.blaLevels > 1 && ((m - 1) & blaMask) == 0)
+        {
+            // Die Gültigkeitsradien schrumpfen mit der Stufe: aufsteigen, solange die nächste Stufe
+            // bei m beginnt und gültig ist
+            int l = 0;
+            while (l + 1 < f.blaLevels && ((m - 1) & ((2 << l) - 1)) == 0)
+            {
+                int index = f.blaOffset[l + 1] + ((m - 1) >> (l + 1));
+                if (index >= f.blaOffset[l + 2] || iter + (2 << l) > max_iter || dz2 >= f.bla[index].r2)
+                    break;
+                l++;
+            }
+
+            if (l >= 1)
+            {
+                const BlaStep &b = f.bla[f.blaOffset[l] + ((m - 1) >> l)];
+                double nr = b.Ar * dzr - b.Ai * dzi + b.Br * dcr - b.Bi * dci;
+                dzi = b.Ar * dzi + b.Ai * dzr + b.Br * dci + b.Bi * dcr;
+                dzr = nr;
+                m += 1 << l;
+                iter += 1 << l;
+                blaMask = 0;
+                continue;
+            }
+            blaMask = BLA_RETRY - 1;
+        }
+
+        // dz' = (2 Z + dz) dz + dc
+        double ar = 2.0 * refReal[m] + dzr;
+        double ai = 2.0 * refImag[m] + dzi;
+        double nr = ar * dzr - ai * dzi + dcr;
+        dzi = ar * dzi + ai * dzr + dci;
+        dzr = nr;
+        m++;
+        iter++;
+    }
+    if (steps != NULL)
+        *steps = done;
+    return iter;
+}
+
+/**
+ * @brief Iterationen für Pixel (x, y) eines Bildes mit dem dort gewählten Rechenverfahren.
+ *
+ * @param f
+ * @param opts
+ * @param x
+ * @param y
+ * @param steps wenn nicht NULL: Ergebnis, tatsächlich gerechnete Schritte (nur Störungsrechnung)
+ * @param norm wie bei mandelbrot()
+ * @return anzahl der Iterationen
+ */
+FRACTAL_HD inline int pixelIterations(const FrameParams &f, const RenderOptions &opts, int x, int y, int *steps = NULL, float *norm = NULL)
+{
+    if (f.precision == PRECISION_PERTURBATION)
+    {
+        double dcr = (x - f.WIDTH / 2.0) * f.scale;
+        double dci = (f.HEIGHT / 2.0 - y) * f.scale;
+        return mandelbrotPerturbed(f, dcr, dci, steps, norm);
+    }
+
+    if (f.precision == PRECISION_FLOAT)
+    {
+        // Toleranz auf float gerundet, damit der Vergleich mit den SIMD-Kerneln übereinstimmt
+        float real = (float)((x - f.WIDTH / 2.0) * f.scale + f.centerX);
+        float imag = (float)((f.HEIGHT / 2.0 - y) * f.scale + f.centerY);
+        return computeIterations(real, imag, f.MAX_ITER, opts, (float)periodTolerance(opts, f.scale), norm);
+    }
+
+    if (f.precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        DoubleDouble real = DoubleDouble(f.centerX, f.centerXLo) + (x - f.WIDTH / 2.0) * f.scale;
+        DoubleDouble imag = DoubleDouble(f.centerY, f.centerYLo) + (f.HEIGHT / 2.0 - y) * f.scale;
+        return computeIterations(real, imag, f.MAX_ITER, opts, periodTolerance(opts, f.scale), norm);
+    }
+
+    double real = (x - f.WIDTH / 2.0) * f.scale + f.centerX;
+    double imag = (f.HEIGHT / 2.0 - y) * f.scale + f.centerY;
+    return computeIterations(real, imag, f.MAX_ITER, opts, periodTolerance(opts, f.scale), norm);
+}
+
+/**
+ * @brief Wählt das billigste Rechenverfahren, das für das Bild noch genau genug ist. float und double
+ * reichen, solange ein Pixel noch mindestens 2^9 Einheiten der letzten Stelle von c umfasst; darunter
+ * verschmelzen benachbarte Pixel zu Blöcken (float etwa ab Zoom 100, double etwa ab Zoom 1e12).
+ * Double-Double hätte 2^52 mal mehr Reserve, aber die Rundungsfehler der Iteration wachsen mit
+ * der Ableitung des Orbits, und ab etwa Zoom 1e19 ist Störungsrechnung mit BLA schneller und
+ * genauer. Double-Double deckt deshalb nur Pixel bis herab zu 2^-20 double-Einheiten ab.
+ *
+ * @param opts
+ * @param scale
+ * @param centerX
+ * @param centerY
+ * @return Precision
+ */
+inline Precision selectPrecision(const RenderOptions &opts, double scale, double centerX, double centerY)
+{
+    if (opts.precision != PRECISION_AUTO)
+        return opts.precision;
+
+    double magnitude = fmax(1.0, fmax(fabs(centerX), fabs(centerY)));
+    if (scale / (magnitude * 1.1920928955078125e-7) >= 512.0)
+        return PRECISION_FLOAT;
+
+    double ulpsPerPixel = scale / (magnitude * 2.220446049250313e-16);
+    if (ulpsPerPixel >= 512.0)
+        return PRECISION_DOUBLE;
+    if (ulpsPerPixel >= 1.0 / 1048576.0)
+        return PRECISION_DOUBLE_DOUBLE;
+    return PRECISION_PERTURBATION;
+}
+
+/**
+ * @brief Bildet eine Iterationsanzahl auf einen Farbwert (0-255) ab. Punkte in der Menge werden schwarz.
+ *
+ * @param iter
+ * @param MAX_ITER
+ * @param exponent siehe ColorOptions
+ * @return Farbwert für valueToRGB
+ */
+FRACTAL_HD inline uint8_t iterToColor(int iter, int MAX_ITER, double exponent = 0.5)
+{
+    uint8_t color = 0;
+
+    if (iter < MAX_ITER)
+    {
+        double normalized_iter = (double)iter / (double)MAX_ITER;
+        // sqrt für den Standard, damit die Farben bitgenau gleich bleiben
+        color = (uint8_t)((exponent == 0.5 ? sqrt(normalized_iter) : pow(normalized_iter, exponent)) * 255.0);
+    }
+    return color;
+}
+
+/**
+ * @brief Normierte Iterationsanzahl (Log-Log-Glättung) eines entkommenen Punktes:
+ * n + 1 - log2(log2 |z_n|) mit n = iter + SMOOTH_EXTRA_ITER. Die zusätzlichen Iterationen machen
+ * den Übergang an der Grenze zweier Iterationsbänder stetig, beim Fluchtradius 2 selbst bliebe dort
+ * ein sichtbarer Sprung. Punkte der Menge bleiben bei MAX_ITER.
+ *
+ * @param iter
+ * @param norm escapeNorm(), siehe mandelbrot()
+ * @param MAX_ITER
+ * @return glatte Iterationsanzahl, nicht negativ
+ */
+FRACTAL_HD inline float smoothIterations(int iter, float norm, int MAX_ITER)
+{
+    if (iter >= MAX_ITER || !(norm > 4.0f) || isinf(norm))
+        return (float)iter;
+    double smooth = iter + SMOOTH_EXTRA_ITER + 1 - log2(0.5 * log2((double)norm));
+    return smooth > 0.0 ? (float)smooth : 0.0f;
+}
+
+/**
+ * @brief Wie iterToColor() für eine glatte Iterationsanzahl, ohne Rundung auf 0-255.
+ *
+ * @param smooth Ergebnis von smoothIterations()
+ * @param MAX_ITER
+ * @param exponent siehe ColorOptions
+ * @return Farbwert für wheelToRGB()
+ */
+FRACTAL_HD inline double smoothToColor(float smooth, int MAX_ITER, double exponent = 0.5)
+{
+    if (smooth >= MAX_ITER)
+        return 0.0;
+    double normalized_iter = (double)smooth / (double)MAX_ITER;
+    return (exponent == 0.5 ? sqrt(normalized_iter) : pow(normalized_iter, exponent)) * 255.0;
+}
+
+/**
+ * @brief Farbwert beim Histogrammausgleich, zwischen zwei ganzen Iterationsanzahlen linear.
+ *
+ * @param smooth Iterationsanzahl, ganzzahlig oder aus smoothIterations()
+ * @param cdf Anteil der entkommenen Pixel des Bildes mit höchstens i Iterationen für i = 0 .. MAX_ITER,
+ *            cdf[MAX_ITER] = 1
+ * @param MAX_ITER
+ * @return Farbwert 0-255, 0 für Punkte der Menge
+ */
+FRACTAL_HD inline double histogramToColor(float smooth, const float *cdf, int MAX_ITER)
+{
+    if (!(smooth >= 0.0f && smooth < MAX_ITER))
+        return 0.0;
+    int i = (int)smooth;
+    double f = smooth - i;
+    return (cdf[i] + f * (cdf[i + 1] - cdf[i])) * 255.0;
+}
+
+/**
+ * @brief Kumuliert das Histogramm der Iterationen eines Bildes zu der Verteilung für histogramToColor().
+ * O(MAX_ITER), gegenüber dem Zählen über die Pixel vernachlässigbar.
+ *
+ * @param counts Anzahl der Pixel mit i Iterationen für i = 0 .. MAX_ITER - 1
+ * @param cdf Ergebnis, MAX_ITER + 1 Einträge
+ * @param MAX_ITER
+ */
+inline void histogramToCdf(const unsigned int *counts, float *cdf, int MAX_ITER)
+{
+    double total = 0.0;
+    for (int i = 0; i < MAX_ITER; i++)
+        total += counts[i];
+    double running = 0.0;
+    for (int i = 0; i < MAX_ITER; i++)
+    {
+        running += counts[i];
+        cdf[i] = total > 0.0 ? (float)(running / total) : 0.0f;
+    }
+    cdf[MAX_ITER] = 1.0f;
+}
+
+/**
+ * @brief Konvertiert einen Farbwert in RGB. Schreibt die RGB-Werte in die übergebenen Referenzen.
+ *
+ * @param color
+ * @param r
+ * @param g
+ * @param b
+ * @param colors Farbton, Sättigung und Helligkeit
+ * @return void
+ */
+FRACTAL_HD inline void valueToRGB(double color, uint8_t &r, uint8_t &g, uint8_t &b, const ColorOptions &colors = ColorOptions())
+{
+
+    double h = fmod(color + colors.hueOffset, 360.0) / 360.0;
+    double s = colors.saturation;
+    double v = colors.brightness;
+    if (h < 0.0)
+        h += 1.0;
+
+    if (color <= 0)
+    {
+        r = g = b = 0;
+        return;
+    }
+
+    int i = (int)(h * 6);
+    double f = h * 6 - i;
+    double p = v * (1 - s);
+    double q = v * (1 - f * s);
+    double t = v * (1 - (1 - f) * s);
+
+    switch (i % 6)
+    {
+    case 0:
+        r = (uint8_t)(v * 255);
+        g = (uint8_t)(t * 255);
+        b = (uint8_t)(p * 255);
+        break;
+    case 1:
+        r = (uint8_t)(q * 255);
+        g = (uint8_t)(v * 255);
+        b = (uint8_t)(p * 255);
+        break;
+    case 2:
+        r = (uint8_t)(p * 255);
+        g = (uint8_t)(v * 255);
+        b = (uint8_t)(t * 255);
+        break;
+    case 3:
+        r = (uint8_t)(p * 255);
+        g = (uint8_t)(q * 255);
+        b = (uint8_t)(v * 255);
+        break;
+    case 4:
+        r = (uint8_t)(t * 255);
+        g = (uint8_t)(p * 255);
+        b = (uint8_t)(v * 255);
+        break;
+    case 5:
+        r = (uint8_t)(v * 255);
+        g = (uint8_t)(p * 255);
+        b = (uint8_t)(q * 255);
+        break;
+    }
+}
+
+/**
+ * @brief Schlägt einen Farbwert in Palette::rgb oder Palette::wheel nach. Positive Farbwerte bekommen
+ * nie den schwarzen Eintrag 0.
+ */
+FRACTAL_HD inline void paletteToRGB(const uint8_t *table, double color, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    int index = 0;
+    if (color > 0.0)
+    {
+        index = (int)(color * PALETTE_SCALE + 0.5);
+        index = index < 1 ? 1 : (index > PALETTE_SIZE - 1 ? PALETTE_SIZE - 1 : index);
+    }
+    const uint8_t *rgb = table + 3 * index;
+    r = rgb[0];
+    g = rgb[1];
+    b = rgb[2];
+}
+
+/**
+ * @brief Färbt einen Farbwert über colors.palette, ohne Tabelle mit valueToRGB().
+ */
+FRACTAL_HD inline void colorToRGB(double color, const ColorOptions &colors, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    if (colors.palette != NULL)
+        paletteToRGB(colors.palette->rgb, color, r, g, b);
+    else
+        valueToRGB(color, r, g, b, colors);
+}
+
+/**
+ * @brief Wie colorToRGB(), aber der Farbwert 0-255 läuft über den ganzen Farbkreis statt nur bis 255
+ * Grad. Für die glatte Färbung; die ganzzahlige bleibt bei colorToRGB(), damit ihre Bilder gleich bleiben.
+ */
+FRACTAL_HD inline void wheelToRGB(double color, const ColorOptions &colors, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    if (colors.palette != NULL)
+        paletteToRGB(colors.palette->wheel, color, r, g, b);
+    else
+        valueToRGB(color * (360.0 / 255.0), r, g, b, colors);
+}
+
+/**
+ * @brief Färbt ein Pixel aus seiner Iterationsanzahl, iterToColor() und colorToRGB() zusammen.
+ */
+FRACTAL_HD inline void iterToRGB(int iter, int MAX_ITER, const ColorOptions &colors, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    colorToRGB(iterToColor(iter, MAX_ITER, colors.exponent), colors, r, g, b);
+}
+
+/**
+ * @brief Färbt ein Pixel aus seiner glatten Iterationsanzahl, smoothToColor() und wheelToRGB() zusammen.
+ */
+FRACTAL_HD inline void smoothToRGB(float smooth, int MAX_ITER, const ColorOptions &colors, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    wheelToRGB(smoothToColor(smooth, MAX_ITER, colors.exponent), colors, r, g, b);
+}
+
+#endif
@@ -0,0 +1,419 @@
+#ifndef FRACTAL_PROTOCOL_H
+#define FRACTAL_PROTOCOL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FractalCore.h"
+
+/*
+ * Anfragen der GUI an die Backends und deren Antworten.
+ *
+ * Binärprotokoll (Standard), alle Zahlen little-endian. Jede Anfrage ist ein fester Block:
+ *     0  u32  FRACTAL_REQUEST_MAGIC ("FRQ1")
+ *     4  u16  Version (FRACTAL_PROTOCOL_VERSION)
+ *     6  u16  Länge des Blocks in Bytes; neuere Versionen dürfen hinten Felder anhängen
+ *     8  u32  Anfrage-ID, kommt in der Antwort zurück
+ *    12  u32  Pixelformat (PIXEL_FORMAT_RGB24)
+ *    16  i32  WIDTH
+ *    20  i32  HEIGHT
+ *    24  i32  Precision, -1 = Backend entscheidet
+ *    28  u32  Flags (REQUEST_FLAG_RECOLOR, REQUEST_FLAG_PROGRESSIVE)
+ *    32  f64  zoom
+ *    40  f64  centerX
+ *    48  f64  centerY
+ *    56  char[FRACTAL_NUMBER_MAX]  centerX als Dezimaltext in voller Genauigkeit, leer = centerX
+ *   312  char[FRACTAL_NUMBER_MAX]  centerY ebenso
+ * Ab Version 2 angehängt (ColorOptions; Anfragen der Version 1 bekommen die Standardfarben):
+ *   568  f64  Farbton-Verschiebung in Grad
+ *   576  f64  Sättigung
+ *   584  f64  Helligkeit
+ *   592  f64  Exponent
+ * Ab Version 3 angehängt:
+ *   600  u32  Farb-Flags (COLOR_FLAG_SMOOTH, COLOR_FLAG_HISTOGRAM)
+ * Mit REQUEST_FLAG_RECOLOR wird nichts gerechnet: das Backend färbt das zuletzt gerechnete Bild aus
+ * seinen gespeicherten Iterationen mit den Farben der Anfrage neu; WIDTH, HEIGHT, zoom und Zentrum
+ * werden ignoriert, die Antwort trägt die des Bildes. Gibt es kein solches Bild (noch keins, oder das
+ * letzte wurde gekachelt gestreamt), ist der Status RESPONSE_FAILED.
+ * Mit REQUEST_FLAG_PROGRESSIVE kommen vor dem Bild Vorschauen in 1/8, 1/4 und 1/2 der Auflösung, jede
+ * als eigene Antwort mit derselben Anfrage-ID, verkleinertem WIDTH/HEIGHT und pass < passes - 1. Jeder
+ * Durchlauf rechnet nur die Pixel, die die vorigen nicht hatten; das fertige Bild ist dasselbe wie
+ * ohne das Flag. Gekachelte Bilder, --output und Textprotokoll liefern nur das fertige Bild.
+ * Mit COLOR_FLAG_SMOOTH wird stufenlos aus der normierten Iterationsanzahl gefärbt (siehe
+ * smoothIterations()). Ein so gerechnetes Bild lässt sich in beiden Arten neu färben; eines ohne das
+ * Flag nur ganzzahlig, ein Neufärben mit dem Flag färbt es dann ohne Glättung.
+ * Mit COLOR_FLAG_HISTOGRAM verteilen sich die Farben nach der Häufigkeit der Iterationsanzahlen im
+ * Bild (Histogrammausgleich). Das Histogramm entsteht beim Färben aus den gespeicherten Iterationen,
+ * Ein- und Ausschalten geht daher auch per Neufärben.
+ * Gekachelte Bilder ignorieren COLOR_FLAG_SMOOTH und COLOR_FLAG_HISTOGRAM und werden ganzzahlig
+ * gefärbt: ihre Kacheln gehen hinaus, bevor das ganze Bild feststeht. Der Status bleibt RESPONSE_OK,
+ * das Backend meldet es auf stderr.
+ * Jede Antwort beginnt mit einem Kopf, danach folgen byteLength Bytes Bild:
+ *     0  u32  FRACTAL_RESPONSE_MAGIC ("FRS1")
+ *     4  u16  Version
+ *     6  u16  Länge des Kopfes in Bytes
+ *     8  u32  Anfrage-ID
+ *    12  u32  Pixelformat
+ *    16  i32  WIDTH
+ *    20  i32  HEIGHT
+ *    24  i32  tatsächlich verwendete Precision
+ *    28  u32  Status (RESPONSE_OK, RESPONSE_INVALID_REQUEST, RESPONSE_FAILED)
+ *    32  f64  Renderzeit in ms, negativ wenn das Bild schon während des Rechnens gestreamt wird
+ *    40  u64  byteLength
+ *    48  i32  Slot in der gemeinsamen Datei (--shared-memory, siehe SharedFrames.h), -1 = Bild folgt
+ *             in der Pipe; sonst folgen keine Bytes und das Bild liegt im Slot
+ *    52  u32  Sequenz des Slots nach dem Schreiben
+ *    56  u64  Position des Bildes in der gemeinsamen Datei
+ *    64  u32  Durchlauf, 0 = gröbste Vorschau, passes - 1 = fertiges Bild
+ *    68  u32  Anzahl der Durchläufe (passes), 1 ohne REQUEST_FLAG_PROGRESSIVE
+ *
+ * Textprotokoll (--protocol text), eine Zeile pro Bild, Antwort ist das rohe RGB-Bild ohne Kopf:
+ *   zoom centerX centerY WIDTH HEIGHT
+ * Es kennt weder Farben noch Neufärben.
+ *
+ * In beiden Fällen darf das Zentrum mehr Stellen haben als ein double fasst (z. B. aus einem
+ * BigDecimal); der Text wird für den Referenzorbit der Störungsrechnung aufbewahrt.
+ */
+
+// Längste Anfragezeile inklusive Zeilenende
+#define FRACTAL_LINE_MAX 1024
+// Längste Zahl für ein Zentrum inklusive Nullterminator
+#define FRACTAL_NUMBER_MAX 256
+
+#define FRACTAL_REQUEST_MAGIC 0x31515246u
+#define FRACTAL_RESPONSE_MAGIC 0x31535246u
+#define FRACTAL_PROTOCOL_VERSION 3
+// Älteste Version, die die Backends noch annehmen
+#define FRACTAL_PROTOCOL_MIN_VERSION 1
+// Kleinste gültige Anfrage (Version 1)
+#define FRACTAL_REQUEST_MIN_SIZE (56 + 2 * FRACTAL_NUMBER_MAX)
+// Anfrage der Version 2, mit ColorOptions
+#define FRACTAL_REQUEST_V2_SIZE (FRACTAL_REQUEST_MIN_SIZE + 32)
+#define FRACTAL_REQUEST_SIZE (FRACTAL_REQUEST_V2_SIZE + 4)
+#define FRACTAL_RESPONSE_SIZE 72
+
+// Drei Bytes pro Pixel, zeilenweise von oben links
+#define PIXEL_FORMAT_RGB24 1
+
+// Nur neu färben, siehe oben
+#define REQUEST_FLAG_RECOLOR 1u
+// Vorschauen vor dem fertigen Bild, siehe oben
+#define REQUEST_FLAG_PROGRESSIVE 2u
+
+// Glatte Färbung und Histogrammausgleich, siehe oben
+#define COLOR_FLAG_SMOOTH 1u
+#define COLOR_FLAG_HISTOGRAM 2u
+
+// Schrittweite der ersten Vorschau (1/8 der Auflösung) und Anzahl der Durchläufe bis zum fertigen Bild
+#define PROGRESSIVE_FIRST_STEP 8
+#define PROGRESSIVE_PASSES 4
+
+#define RESPONSE_OK 0
+#define RESPONSE_INVALID_REQUEST 1
+#define RESPONSE_FAILED 2
+
+struct FrameRequest
+{
+    uint32_t requestId;
+    uint32_t pixelFormat;
+    Precision precision;
+    uint32_t flags;
+
+    double zoom;
+    double centerX, centerY;
+    int WIDTH, HEIGHT;
+
+    // Zentrum im Originaltext, volle Genauigkeit
+    char centerXText[FRACTAL_NUMBER_MAX];
+    char centerYText[FRACTAL_NUMBER_MAX];
+
+    ColorOptions colors;
+};
+
+struct FrameResponse
+{
+    uint32_t requestId;
+    uint32_t pixelFormat;
+    int WIDTH, HEIGHT;
+    Precision precision;
+    uint32_t status;
+    double renderMs;
+    uint64_t byteLength;
+    int sharedSlot;
+    uint32_t sharedSequence;
+    uint64_t sharedOffset;
+    uint32_t pass;
+    uint32_t passes;
+};
+
+/**
+ * @brief Ergebnis von readTextRequest() und readBinaryRequest().
+ */
+enum RequestResult
+{
+    // Anfrage gelesen und gültig
+    REQUEST_READ,
+    // Anfrage gelesen, aber ungültig; der Strom ist noch synchron
+    REQUEST_INVALID,
+    // Ende der Eingabe oder nicht mehr synchron, das Backend beendet sich
+    REQUEST_END
+};
+
+inline uint32_t protocolGetU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline uint64_t protocolGetU64(const uint8_t *p)
+{
+    return (uint64_t)protocolGetU32(p) | (uint64_t)protocolGetU32(p + 4) << 32;
+}
+
+inline double protocolGetF64(const uint8_t *p)
+{
+    uint64_t bits = protocolGetU64(p);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+inline void protocolPutU16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void protocolPutU32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+inline void protocolPutU64(uint8_t *p, uint64_t v)
+{
+    protocolPutU32(p, (uint32_t)v);
+    protocolPutU32(p + 4, (uint32_t)(v >> 32));
+}
+
+inline void protocolPutF64(uint8_t *p, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    protocolPutU64(p, bits);
+}
+
+/**
+ * @brief Prüft die Werte einer gelesenen Anfrage.
+ */
+inline bool validateRequest(const FrameRequest &req)
+{
+    const ColorOptions &c = req.colors;
+    if (!isfinite(c.hueOffset) || !(c.saturation >= 0.0 && c.saturation <= 1.0) || !(c.brightness >= 0.0 && c.brightness <= 1.0) ||
+        !(c.exponent > 0.0 && c.exponent <= 16.0))
+        return false;
+    if (req.flags & REQUEST_FLAG_RECOLOR)
+        return req.pixelFormat == PIXEL_FORMAT_RGB24;
+    if (req.WIDTH <= 0 || req.HEIGHT <= 0 || !(req.zoom > 0.0))
+        return false;
+    if (req.precision < PRECISION_AUTO || req.precision > PRECISION_PERTURBATION)
+        return false;
+    return req.pixelFormat == PIXEL_FORMAT_RGB24;
+}
+
+/**
+ * @brief Liest eine Anfragezeile.
+ *
+ * @param line
+ * @param req Ergebnis
+ * @return false bei ungültiger Zeile
+ */
+inline bool parseTextRequest(const char *line, FrameRequest &req)
+{
+    req.requestId = 0;
+    req.pixelFormat = PIXEL_FORMAT_RGB24;
+    req.precision = PRECISION_AUTO;
+    req.flags = 0;
+    req.colors = ColorOptions();
+
+    if (sscanf(line, "%lf %255s %255s %d %d", &req.zoom, req.centerXText, req.centerYText, &req.WIDTH, &req.HEIGHT) != 5)
+        return false;
+    if (!validateRequest(req))
+        return false;
+
+    char *end;
+    req.centerX = strtod(req.centerXText, &end);
+    if (end == req.centerXText || *end != '\0')
+        return false;
+    req.centerY = strtod(req.centerYText, &end);
+    if (end == req.centerYText || *end != '\0')
+        return false;
+    return true;
+}
+
+/**
+ * @brief Liest die nächste Zeile des Textprotokolls. Ungültige Zeilen werden auf stderr gemeldet.
+ *
+ * @param in
+ * @param req Ergebnis
+ * @return RequestResult
+ */
+inline RequestResult readTextRequest(FILE *in, FrameRequest &req)
+{
+    char line[FRACTAL_LINE_MAX];
+    if (!fgets(line, sizeof(line), in))
+        return REQUEST_END;
+
+    if (!parseTextRequest(line, req))
+    {
+        fprintf(stderr, "Invalid input: %s", line);
+        fflush(stderr);
+        return REQUEST_INVALID;
+    }
+    return REQUEST_READ;
+}
+
+/**
+ * @brief Liest die nächste Anfrage des Binärprotokolls. Fehlt der Dezimaltext des Zentrums, wird
+ * er aus dem double erzeugt.
+ *
+ * @param in
+ * @param req Ergebnis; bei REQUEST_INVALID sind requestId und pixelFormat für die Antwort gesetzt
+ * @return RequestResult
+ */
+inline RequestResult readBinaryRequest(FILE *in, FrameRequest &req)
+{
+    uint8_t block[FRACTAL_REQUEST_SIZE];
+    if (fread(block, 1, 8, in) != 8)
+        return REQUEST_END;
+
+    uint32_t magic = protocolGetU32(block);
+    int version = block[4] | block[5] << 8;
+    int size = block[6] | block[7] << 8;
+    if (magic != FRACTAL_REQUEST_MAGIC || size < FRACTAL_REQUEST_MIN_SIZE)
+    {
+        fprintf(stderr, "Invalid request header (magic %08x, size %d), closing\n", magic, size);
+        fflush(stderr);
+        return REQUEST_END;
+    }
+
+    // Angehängte Felder neuerer Versionen überspringen
+    int known = size < FRACTAL_REQUEST_SIZE ? size : FRACTAL_REQUEST_SIZE;
+    if (fread(block + 8, 1, known - 8, in) != (size_t)(known - 8))
+        return REQUEST_END;
+    for (int i = FRACTAL_REQUEST_SIZE; i < size; i++)
+    {
+        if (fgetc(in) == EOF)
+            return REQUEST_END;
+    }
+
+    req.requestId = protocolGetU32(block + 8);
+    req.pixelFormat = protocolGetU32(block + 12);
+    req.WIDTH = (int32_t)protocolGetU32(block + 16);
+    req.HEIGHT = (int32_t)protocolGetU32(block + 20);
+    req.precision = (Precision)(int32_t)protocolGetU32(block + 24);
+    req.flags = protocolGetU32(block + 28);
+    req.zoom = protocolGetF64(block + 32);
+    req.centerX = protocolGetF64(block + 40);
+    req.centerY = protocolGetF64(block + 48);
+
+    memcpy(req.centerXText, block + 56, FRACTAL_NUMBER_MAX);
+    memcpy(req.centerYText, block + 56 + FRACTAL_NUMBER_MAX, FRACTAL_NUMBER_MAX);
+    req.centerXText[FRACTAL_NUMBER_MAX - 1] = '\0';
+    req.centerYText[FRACTAL_NUMBER_MAX - 1] = '\0';
+    if (req.centerXText[0] == '\0')
+        snprintf(req.centerXText, FRACTAL_NUMBER_MAX, "%.17g", req.centerX);
+    if (req.centerYText[0] == '\0')
+        snprintf(req.centerYText, FRACTAL_NUMBER_MAX, "%.17g", req.centerY);
+
+    req.colors = ColorOptions();
+    if (version >= 2 && known >= FRACTAL_REQUEST_V2_SIZE)
+    {
+        req.colors.hueOffset = protocolGetF64(block + 568);
+        req.colors.saturation = protocolGetF64(block + 576);
+        req.colors.brightness = protocolGetF64(block + 584);
+        req.colors.exponent = protocolGetF64(block + 592);
+    }
+    if (version >= 3 && known >= FRACTAL_REQUEST_SIZE)
+    {
+        uint32_t colorFlags = protocolGetU32(block + 600);
+        req.colors.smooth = (colorFlags & COLOR_FLAG_SMOOTH) != 0;
+        req.colors.histogram = (colorFlags & COLOR_FLAG_HISTOGRAM) != 0;
+    }
+
+    if (version < FRACTAL_PROTOCOL_MIN_VERSION || !validateRequest(req))
+    {
+        fprintf(stderr, "Invalid request %u: version %d, %d x %d, zoom %g, precision %d, format %u, colors %g %g %g %g\n",
+                req.requestId, version, req.WIDTH, req.HEIGHT, req.zoom, (int)req.precision, req.pixelFormat,
+                req.colors.hueOffset, req.colors.saturation, req.colors.brightness, req.colors.exponent);
+        fflush(stderr);
+        return REQUEST_INVALID;
+    }
+    return REQUEST_READ;
+}
+
+/**
+ * @brief Entfernt die Farb-Flags, die ein gekacheltes Bild nicht kann (siehe oben), und meldet es auf stderr.
+ */
+inline void dropTiledColorFlags(FrameRequest &req)
+{
+    if (!req.colors.smooth && !req.colors.histogram)
+        return;
+    fprintf(stderr, "Received #%u: tiled frames ignore%s%s, using plain colors\n", req.requestId,
+            req.colors.smooth ? " COLOR_FLAG_SMOOTH" : "", req.colors.histogram ? " COLOR_FLAG_HISTOGRAM" : "");
+    req.colors.smooth = false;
+    req.colors.histogram = false;
+}
+
+/**
+ * @brief Schreibt den Antwortkopf des Binärprotokolls. Das Bild folgt mit eigenem fwrite().
+ *
+ * @param out
+ * @param res
+ * @return false bei Schreibfehler
+ */
+inline bool writeResponseHeader(FILE *out, const FrameResponse &res)
+{
+    uint8_t block[FRACTAL_RESPONSE_SIZE];
+    protocolPutU32(block, FRACTAL_RESPONSE_MAGIC);
+    protocolPutU16(block + 4, FRACTAL_PROTOCOL_VERSION);
+    protocolPutU16(block + 6, FRACTAL_RESPONSE_SIZE);
+    protocolPutU32(block + 8, res.requestId);
+    protocolPutU32(block + 12, res.pixelFormat);
+    protocolPutU32(block + 16, (uint32_t)res.WIDTH);
+    protocolPutU32(block + 20, (uint32_t)res.HEIGHT);
+    protocolPutU32(block + 24, (uint32_t)res.precision);
+    protocolPutU32(block + 28, res.status);
+    protocolPutF64(block + 32, res.renderMs);
+    protocolPutU64(block + 40, res.byteLength);
+    protocolPutU32(block + 48, (uint32_t)res.sharedSlot);
+    protocolPutU32(block + 52, res.sharedSequence);
+    protocolPutU64(block + 56, res.sharedOffset);
+    protocolPutU32(block + 64, res.pass);
+    protocolPutU32(block + 68, res.passes);
+    return fwrite(block, 1, sizeof(block), out) == sizeof(block);
+}
+
+/**
+ * @brief Beantwortet --protocol-version mit FRACTAL_PROTOCOL_VERSION als Textzeile auf stdout. Die GUI
+ * fragt so, ob ein Build das Binärprotokoll spricht; ältere Builds ignorieren das Argument, lesen
+ * Textzeilen bis zum Ende von stdin und schreiben nichts auf stdout.
+ *
+ * @return true, wenn das Argument da war und das Backend gleich enden soll
+ */
+inline bool answerProtocolVersion(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--protocol-version") == 0)
+        {
+            printf("%d\n", FRACTAL_PROTOCOL_VERSION);
+            fflush(stdout);
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <math.h>
+#include <string.h>
+
+#include "BigFloat.h"
+#include "FractalCore.h"
+#include "FractalProtocol.h"
+#include "Perturbation.h"
+
+/*
+ * Beschreibung des Bildes, dessen Iterationen ein Backend noch im Puffer hat. Damit lässt sich das
+ * Bild neu färben (REQUEST_FLAG_RECOLOR) und beim Ziehen wiederverwenden: ist die neue Anfrage
+ * dasselbe Bild um ganze Pixel verschoben, werden die Iterationen nur verschoben und allein die neu
+ * sichtbaren Streifen gerechnet.
+ */
+
+// Größte Abweichung der Verschiebung von einer ganzen Pixelzahl, die noch als Verschieben gilt, in Pixeln.
+// Die wiederverwendeten Pixel liegen höchstens so weit neben ihrer exakten Lage.
+#define PAN_TOLERANCE 1e-3
+
+struct FrameCache
+{
+    // false, solange der Iterationspuffer kein vollständiges Bild enthält
+    bool valid;
+    // true, wenn zum Bild auch die glatten Iterationsanzahlen im Puffer stehen (COLOR_FLAG_SMOOTH)
+    bool smooth;
+    // Parameter des Bildes; die Zeiger auf Referenzorbit und BLA-Tabelle sind nicht mehr gültig
+    FrameParams frame;
+    // Zentrum im Originaltext
+    char centerXText[FRACTAL_NUMBER_MAX];
+    char centerYText[FRACTAL_NUMBER_MAX];
+};
+
+/**
+ * @brief Merkt sich ein fertig gerechnetes Bild, dessen Iterationen jetzt im Puffer stehen.
+ */
+inline void keepFrame(FrameCache &cache, const FrameParams &frame, const FrameRequest &req)
+{
+    cache.valid = true;
+    cache.smooth = req.colors.smooth;
+    cache.frame = frame;
+    memcpy(cache.centerXText, req.centerXText, FRACTAL_NUMBER_MAX);
+    memcpy(cache.centerYText, req.centerYText, FRACTAL_NUMBER_MAX);
+}
+
+/**
+ * @brief Prüft, ob frame das gespeicherte Bild um ganze Pixel verschoben zeigt: gleiche Größe,
+ * Pixelgröße, Iterationsgrenze und Rechenverfahren. Der Abstand der Zentren wird aus ihren
+ * Dezimaltexten in BigFloat gerechnet und reicht so für jede Zoomtiefe.
+ *
+ * @param cache
+ * @param frame Ergebnis von prepareFrame() für die neue Anfrage
+ * @param req neue Anfrage
+ * @param shiftX Ergebnis: Pixel (x, y) des neuen Bildes ist Pixel (x + shiftX, y + shiftY) des alten
+ * @param shiftY
+ * @return false, wenn nichts wiederverwendet werden kann
+ */
+inline bool panShift(const FrameCache &cache, const FrameParams &frame, const FrameRequest &req, int &shiftX, int &shiftY)
+{
+    const FrameParams &last = cache.frame;
+    if (!cache.valid || frame.WIDTH != last.WIDTH || frame.HEIGHT != last.HEIGHT || frame.scale != last.scale ||
+        frame.MAX_ITER != last.MAX_ITER || frame.precision != last.precision)
+        return false;
+
+    int limbs = bigFloatLimbsFor(frame.scale, REFERENCE_GUARD_BITS);
+    BigFloat a, b;
+    if (!bigFloatFromString(a, req.centerXText, limbs) || !bigFloatFromString(b, cache.centerXText, limbs))
+        return false;
+    bigFloatSub(a, a, b);
+    double dx = bigFloatToDouble(a) / frame.scale;
+    if (!bigFloatFromString(a, req.centerYText, limbs) || !bigFloatFromString(b, cache.centerYText, limbs))
+        return false;
+    bigFloatSub(a, a, b);
+    // Bildzeilen laufen nach unten, der Imaginärteil nach oben
+    double dy = -bigFloatToDouble(a) / frame.scale;
+
+    if (!(fabs(dx) < frame.WIDTH && fabs(dy) < frame.HEIGHT))
+        return false;
+    if (fabs(dx - round(dx)) > PAN_TOLERANCE || fabs(dy - round(dy)) > PAN_TOLERANCE)
+        return false;
+    shiftX = (int)round(dx);
+    shiftY = (int)round(dy);
+    return true;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FractalCore.h"
+
+/*
+ * Aufbau der Farbtabelle (struct Palette in FractalCore.h). Ohne Verlauf enthält sie den HSV-Farbkreis
+ * aus ColorOptions, Eintrag für Eintrag mit valueToRGB() gerechnet, für die glatte Färbung zusätzlich
+ * über den ganzen Farbkreis (wheelToRGB()); die Bilder sind dieselben wie ohne Tabelle. Ein Backend baut sie nur neu, wenn sich Farbton, Sättigung oder Helligkeit ändern, und
+ * lädt sie dann einmal hoch (CUDA); das Färben selbst ist danach ein Nachschlagen pro Pixel.
+ *
+ * Verlaufsdatei (--palette FILE), eine Stützstelle pro Zeile, leere Zeilen und # Kommentare erlaubt:
+ *   position r g b
+ * position von 0 bis 1 aufsteigend, r g b von 0 bis 255. Der Farbwert 0 bis 255 läuft einmal über
+ * den Verlauf, zwischen den Stützstellen wird linear gemischt, hinter der letzten zurück zur ersten
+ * (der Verlauf ist zyklisch). Der Farbton verschiebt den Verlauf um hueOffset / 360, die Helligkeit
+ * skaliert ihn, die Sättigung gilt nur für den HSV-Farbkreis. Punkte der Menge bleiben schwarz.
+ */
+
+#define GRADIENT_MAX_STOPS 256
+#define GRADIENT_LINE_MAX 256
+
+struct Gradient
+{
+    int count;
+    double position[GRADIENT_MAX_STOPS];
+    double rgb[3 * GRADIENT_MAX_STOPS];
+};
+
+/**
+ * @brief Liest eine Verlaufsdatei. Fehler gehen mit Zeilennummer auf stderr.
+ *
+ * @param path
+ * @param gradient Ergebnis, mindestens eine Stützstelle
+ * @return false, wenn die Datei fehlt oder nicht dem Format entspricht
+ */
+inline bool loadGradient(const char *path, Gradient &gradient)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Cannot open palette %s\n", path);
+        return false;
+    }
+
+    gradient.count = 0;
+    char line[GRADIENT_LINE_MAX];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+            *comment = '\0';
+
+        double position, r, g, b;
+        char rest;
+        int fields = sscanf(line, "%lf %lf %lf %lf %c", &position, &r, &g, &b, &rest);
+        if (fields <= 0)
+            continue;
+        double previous = gradient.count > 0 ? gradient.position[gradient.count - 1] : 0.0;
+        if (fields != 4 || !(position >= previous && position <= 1.0) || !(r >= 0.0 && r <= 255.0) ||
+            !(g >= 0.0 && g <= 255.0) || !(b >= 0.0 && b <= 255.0))
+        {
+            fprintf(stderr, "Palette %s, line %d: expected \"position r g b\" with ascending position in 0..1 and colors in 0..255\n",
+                    path, lineNumber);
+            ok = false;
+        }
+        else if (gradient.count == GRADIENT_MAX_STOPS)
+        {
+            fprintf(stderr, "Palette %s: more than %d stops\n", path, GRADIENT_MAX_STOPS);
+            ok = false;
+        }
+        else
+        {
+            gradient.position[gradient.count] = position;
+            gradient.rgb[3 * gradient.count + 0] = r;
+            gradient.rgb[3 * gradient.count + 1] = g;
+            gradient.rgb[3 * gradient.count + 2] = b;
+            gradient.count++;
+        }
+    }
+    fclose(file);
+
+    if (ok && gradient.count == 0)
+    {
+        fprintf(stderr, "Palette %s has no stops\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Farbe des zyklischen Verlaufs an der Stelle t (0 bis 1).
+ */
+inline void gradientColor(const Gradient &gradient, double t, double rgb[3])
+{
+    int n = gradient.count;
+    // Erste Stützstelle hinter t; davor liegt die letzte, um 1 nach links versetzt
+    int next = 0;
+    while (next < n && gradient.position[next] <= t)
+        next++;
+    int prev = next - 1;
+    double p0 = prev >= 0 ? gradient.position[prev] : gradient.position[n - 1] - 1.0;
+    double p1 = next < n ? gradient.position[next] : gradient.position[0] + 1.0;
+    prev = (prev + n) % n;
+    next %= n;
+
+    double f = p1 > p0 ? (t - p0) / (p1 - p0) : 0.0;
+    for (int c = 0; c < 3; c++)
+        rgb[c] = gradient.rgb[3 * prev + c] + f * (gradient.rgb[3 * next + c] - gradient.rgb[3 * prev + c]);
+}
+
+/**
+ * @brief Füllt die Farbtabelle für colors, aus dem HSV-Farbkreis oder einem Verlauf.
+ *
+ * @param palette Ergebnis
+ * @param colors Farbton, Sättigung und Helligkeit; exponent wirkt erst beim Nachschlagen
+ * @param gradient NULL für den HSV-Farbkreis
+ */
+inline void buildPalette(Palette &palette, const ColorOptions &colors, const Gradient *gradient)
+{
+    ColorOptions hsv = colors;
+    hsv.palette = NULL;
+    palette.rgb[0] = palette.rgb[1] = palette.rgb[2] = 0;
+    palette.wheel[0] = palette.wheel[1] = palette.wheel[2] = 0;
+    for (int i = 1; i < PALETTE_SIZE; i++)
+    {
+        uint8_t *rgb = palette.rgb + 3 * i;
+        uint8_t *wheel = palette.wheel + 3 * i;
+        if (gradient == NULL)
+        {
+            valueToRGB((double)i / PALETTE_SCALE, rgb[0], rgb[1], rgb[2], hsv);
+            wheelToRGB((double)i / PALETTE_SCALE, hsv, wheel[0], wheel[1], wheel[2]);
+            continue;
+        }
+
+        double t = (double)i / (PALETTE_SIZE - 1) + colors.hueOffset / 360.0;
+        t -= floor(t);
+        double color[3];
+        gradientColor(*gradient, t, color);
+        for (int c = 0; c < 3; c++)
+        {
+            double v = color[c] * colors.brightness;
+            rgb[c] = (uint8_t)(v < 0.0 ? 0.0 : (v > 255.0 ? 255.0 : v + 0.5));
+            // Der Verlauf läuft schon über den ganzen Farbwert einmal herum
+            wheel[c] = rgb[c];
+        }
+    }
+}
+
+/**
+ * @brief Farbtabelle eines Backends samt den Farben, für die sie gebaut ist.
+ */
+struct PaletteCache
+{
+    Palette palette;
+    // NULL für den HSV-Farbkreis
+    const Gradient *gradient;
+    bool valid;
+    double hueOffset;
+    double saturation;
+    double brightness;
+};
+
+/**
+ * @brief Baut die Farbtabelle neu, falls colors andere Farben verlangt als beim letzten Mal.
+ *
+ * @return true, wenn die Tabelle neu ist (und z. B. neu auf die GPU muss)
+ */
+inline bool updatePalette(PaletteCache &cache, const ColorOptions &colors)
+{
+    if (cache.valid && cache.hueOffset == colors.hueOffset && cache.saturation == colors.saturation &&
+        cache.brightness == colors.brightness)
+        return false;
+    buildPalette(cache.palette, colors, cache.gradient);
+    cache.valid = true;
+    cache.hueOffset = colors.hueOffset;
+    cache.saturation = colors.saturation;
+    cache.brightness = colors.brightness;
+    return true;
+}
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef PERTURBATION_H
+#define PERTURBATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BigFloat.h"
+#include "FractalCore.h"
+#include "FractalProtocol.h"
+
+/*
+ * Host-Teil der Störungsrechnung: Referenzorbit in BigFloat-Genauigkeit um das Bildzentrum,
+ * gespeichert als double (die Orbitpunkte selbst liegen in |Z| <= 2 und brauchen keine
+ * höhere Genauigkeit, nur ihre Berechnung).
+ */
+
+// Reserve in Bit unter der Pixelgröße für die Orbitberechnung
+#define REFERENCE_GUARD_BITS 64
+
+// Zulässiger relativer Fehler eines BLA-Schritts: |dz|^2 wird gegen |2 Z dz| vernachlässigt,
+// solange |dz| < BLA_EPSILON * |2 Z|
+#define BLA_EPSILON 1e-12
+
+struct ReferenceOrbit
+{
+    double *real;
+    double *imag;
+    int length;
+    int capacity;
+};
+
+struct BlaTable
+{
+    BlaStep *steps;
+    int capacity;
+    int levels;
+    int offset[BLA_MAX_LEVELS + 1];
+};
+
+inline const char *precisionName(Precision precision)
+{
+    switch (precision)
+    {
+    case PRECISION_FLOAT:
+        return "float";
+    case PRECISION_DOUBLE:
+        return "double";
+    case PRECISION_DOUBLE_DOUBLE:
+        return "double-double";
+    case PRECISION_PERTURBATION:
+        return "perturbation";
+    default:
+        return "auto";
+    }
+}
+
+inline bool parsePrecision(const char *name, Precision &precision)
+{
+    for (int i = PRECISION_AUTO; i <= PRECISION_PERTURBATION; i++)
+    {
+        if (strcmp(name, precisionName((Precision)i)) == 0)
+        {
+            precision = (Precision)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void freeReferenceOrbit(ReferenceOrbit &orbit)
+{
+    free(orbit.real);
+    free(orbit.imag);
+    orbit.real = NULL;
+    orbit.imag = NULL;
+    orbit.length = 0;
+    orbit.capacity = 0;
+}
+
+/**
+ * @brief Iteriert Z_{n+1} = Z_n^2 + C für das Zentrum C bis zum Entkommen oder max_iter und legt
+ * Z_0 = 0 bis einschließlich des ersten entkommenen Punktes ab.
+ *
+ * @param orbit Ergebnis; der Speicher wird bei Bedarf vergrößert und über Bilder hinweg wiederverwendet
+ * @param centerXText Realteil des Zentrums als Dezimaltext
+ * @param centerYText Imaginärteil des Zentrums als Dezimaltext
+ * @param scale Pixelgröße, bestimmt die nötige Genauigkeit
+ * @param max_iter
+ * @param limbs Ergebnis: verwendete Anzahl 32-Bit-Worte
+ * @return false bei ungültigem Zentrum oder fehlendem Speicher
+ */
+inline bool computeReferenceOrbit(ReferenceOrbit &orbit, const char *centerXText, const char *centerYText, double scale, int max_iter, int &limbs)
+{
+    limbs = bigFloatLimbsFor(scale, REFERENCE_GUARD_BITS);
+
+    BigFloat cr, ci;
+    if (!bigFloatFromString(cr, centerXText, limbs) || !bigFloatFromString(ci, centerYText, limbs))
+        return false;
+
+    if (orbit.capacity < max_iter + 1)
+    {
+        freeReferenceOrbit(orbit);
+        orbit.real = (double *)malloc(sizeof(double) * (max_iter + 1));
+        orbit.imag = (double *)malloc(sizeof(double) * (max_iter + 1));
+        if (orbit.real == NULL || orbit.imag == NULL)
+        {
+            freeReferenceOrbit(orbit);
+            return false;
+        }
+        orbit.capacity = max_iter + 1;
+    }
+
+    BigFloat zr, zi, zr2, zi2, t;
+    bigFloatZero(zr, limbs);
+    bigFloatZero(zi, limbs);
+
+    orbit.length = 0;
+    for (int n = 0; n <= max_iter; n++)
+    {
+        double r = bigFloatToDouble(zr);
+        double i = bigFloatToDouble(zi);
+        orbit.real[n] = r;
+        orbit.imag[n] = i;
+        orbit.length = n + 1;
+
+        if (r * r + i * i > 4.0)
+            break;
+
+        // zi = 2 zr zi + ci, zr = zr^2 - zi^2 + cr
+        bigFloatMul(zr2, zr, zr);
+        bigFloatMul(zi2, zi, zi);
+        bigFloatMul(t, zr, zi);
+        bigFloatAdd(t, t, t);
+        bigFloatAdd(zi, t, ci);
+        bigFloatSub(zr, zr2, zi2);
+        bigFloatAdd(zr, zr, cr);
+    }
+    return true;
+}
+
+/**
+ * @brief Rest einer Dezimalzahl, der beim Runden auf value verloren ging, als double.
+ * Zusammen ergeben value und der Rest die Zahl als Double-Double.
+ *
+ * @param text Dezimaltext der Zahl
+ * @param value auf double gerundete Zahl (strtod)
+ * @return text - value
+ */
+inline double decimalRemainder(const char *text, double value)
+{
+    // 4 Nachkommaworte = 128 Bit, mehr als die 106 Bit eines Double-Double
+    BigFloat exact, rounded;
+    if (!bigFloatFromString(exact, text, 5))
+        return 0.0;
+    bigFloatFromDouble(rounded, value, 5);
+    bigFloatSub(exact, exact, rounded);
+    return bigFloatToDouble(exact);
+}
+
+inline void freeBlaTable(BlaTable &table)
+{
+    free(table.steps);
+    table.steps = NULL;
+    table.capacity = 0;
+    table.levels = 0;
+}
+
+/**
+ * @brief Baut die BLA-Tabelle zu einem Referenzorbit. Stufe 0 ist ein einzelner Schritt
+ * dz' = 2 Z_m dz + dc (A = 2 Z_m, B = 1), gültig für |dz| < BLA_EPSILON * |A|. Jede höhere Stufe
+ * fasst zwei benachbarte Einträge x, y der Stufe darunter zusammen:
+ *   A = Ay Ax,  B = Ay Bx + By,  r = min(rx, (ry - |Bx| dcMax) / |Ax|)
+ * Über dcMax, den größten Abstand eines Pixels vom Zentrum, hängt die Fehlerschranke von scale ab.
+ *
+ * @param table Ergebnis; der Speicher wird über Bilder hinweg wiederverwendet
+ * @param orbit
+ * @param dcMax
+ * @return false bei fehlendem Speicher
+ */
+inline bool computeBlaTable(BlaTable &table, const ReferenceOrbit &orbit, double dcMax)
+{
+    // Schritte von Index m = 1 .. length - 2 (Z_0 = 0 lässt sich nicht linearisieren)
+    int n0 = orbit.length - 2;
+    table.levels = 0;
+    if (n0 < 2)
+        return true;
+
+    int total = 0;
+    int levels = 0;
+    while (levels < BLA_MAX_LEVELS && (n0 >> levels) >= 1)
+    {
+        table.offset[levels] = total;
+        total += n0 >> levels;
+        levels++;
+    }
+    table.offset[levels] = total;
+
+    if (table.capacity < total)
+    {
+        free(table.steps);
+        table.steps = (BlaStep *)malloc(sizeof(BlaStep) * total);
+        table.capacity = table.steps == NULL ? 0 : total;
+        if (table.steps == NULL)
+            return false;
+    }
+
+    for (int j = 0; j < n0; j++)
+    {
+        BlaStep &b = table.steps[j];
+        b.Ar = 2.0 * orbit.real[1 + j];
+        b.Ai = 2.0 * orbit.imag[1 + j];
+        b.Br = 1.0;
+        b.Bi = 0.0;
+        double r = BLA_EPSILON * sqrt(b.Ar * b.Ar + b.Ai * b.Ai);
+        b.r2 = r * r;
+    }
+
+    for (int l = 1; l < levels; l++)
+    {
+        const BlaStep *lower = table.steps + table.offset[l - 1];
+        BlaStep *level = table.steps + table.offset[l];
+        int count = table.offset[l + 1] - table.offset[l];
+
+        for (int j = 0; j < count; j++)
+        {
+            const BlaStep &x = lower[2 * j];
+            const BlaStep &y = lower[2 * j + 1];
+            BlaStep &b = level[j];
+
+            b.Ar = y.Ar * x.Ar - y.Ai * x.Ai;
+            b.Ai = y.Ar * x.Ai + y.Ai * x.Ar;
+            b.Br = y.Ar * x.Br - y.Ai * x.Bi + y.Br;
+            b.Bi = y.Ar * x.Bi + y.Ai * x.Br + y.Bi;
+
+            double absAx = sqrt(x.Ar * x.Ar + x.Ai * x.Ai);
+            double absBx = sqrt(x.Br * x.Br + x.Bi * x.Bi);
+            double ry = (sqrt(y.r2) - absBx * dcMax) / absAx;
+            double r = fmin(sqrt(x.r2), ry > 0.0 ? ry : 0.0);
+            b.r2 = r * r;
+        }
+    }
+    table.levels = levels;
+    return true;
+}
+
+/**
+ * @brief Bereitet ein Bild vor: Pixelgröße, Iterationsgrenze, Rechenverfahren und bei Bedarf den
+ * Referenzorbit samt BLA-Tabelle. Die Zeiger in frame zeigen danach in Host-Speicher.
+ *
+ * @param frame Ergebnis
+ * @param req
+ * @param opts
+ * @param orbit Speicher für den Referenzorbit
+ * @param bla Speicher für die BLA-Tabelle
+ * @return false, wenn der Referenzorbit nicht berechnet werden konnte
+ */
+inline bool prepareFrame(FrameParams &frame, const FrameRequest &req, const RenderOptions &opts, ReferenceOrbit &orbit, BlaTable &bla)
+{
+    frame.scale = 4.0 / (req.WIDTH * req.zoom);
+    frame.centerX = req.centerX;
+    frame.centerY = req.centerY;
+    frame.WIDTH = req.WIDTH;
+    frame.HEIGHT = req.HEIGHT;
+    frame.MAX_ITER = computeMaxIter(frame.scale, req.WIDTH);
+    // Eine Precision in der Anfrage hat Vorrang vor --precision
+    RenderOptions frameOpts = opts;
+    if (req.precision != PRECISION_AUTO)
+        frameOpts.precision = req.precision;
+    frame.precision = selectPrecision(frameOpts, frame.scale, req.centerX, req.centerY);
+    frame.centerXLo = 0.0;
+    frame.centerYLo = 0.0;
+    frame.refReal = NULL;
+    frame.refImag = NULL;
+    frame.refLength = 0;
+    frame.bla = NULL;
+    frame.blaLevels = 0;
+
+    if (frame.precision == PRECISION_DOUBLE_DOUBLE)
+    {
+        frame.centerXLo = decimalRemainder(req.centerXText, req.centerX);
+        frame.centerYLo = decimalRemainder(req.centerYText, req.centerY);
+    }
+    if (frame.precision != PRECISION_PERTURBATION)
+        return true;
+
+    int limbs;
+    if (!computeReferenceOrbit(orbit, req.centerXText, req.centerYText, frame.scale, frame.MAX_ITER, limbs))
+    {
+        fprintf(stderr, "Reference orbit failed for center %s %s\n", req.centerXText, req.centerYText);
+        fflush(stderr);
+        return false;
+    }
+    frame.refReal = orbit.real;
+    frame.refImag = orbit.imag;
+    frame.refLength = orbit.length;
+
+    fprintf(stderr, "Reference orbit: %d iterations, %d bits\n", orbit.length - 1, 32 * limbs);
+    fflush(stderr);
+
+    if (!opts.bla)
+        return true;
+
+    double dcMax = frame.scale * sqrt(0.25 * req.WIDTH * req.WIDTH + 0.25 * req.HEIGHT * req.HEIGHT);
+    if (!computeBlaTable(bla, orbit, dcMax))
+    {
+        // Ohne Tabelle geht es auch, nur langsamer
+        fprintf(stderr, "Out of memory for BLA table, rendering without\n");
+        fflush(stderr);
+        return true;
+    }
+    frame.bla = bla.steps;
+    frame.blaLevels = bla.levels;
+    memcpy(frame.blaOffset, bla.offset, sizeof(bla.offset));
+    return true;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef REQUEST_QUEUE_H
+#define REQUEST_QUEUE_H
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "FractalProtocol.h"
+
+/*
+ * Liest Anfragen in einem eigenen Thread, damit das Backend beim Ziehen und Zoomen nicht hinter
+ * der GUI zurückfällt. Es wird immer nur die neueste noch nicht begonnene Anfrage aufbewahrt, ältere
+ * werden verworfen. Kommt eine neue Anfrage, während ein Bild gerechnet wird, wird cancel gesetzt;
+ * die Renderer prüfen das pro Zeile bzw. Kachel (CPU) oder pro Kernel-Abschnitt (GPU) und brechen
+ * ab. So ist das neueste Bild spätestens eine Bildzeit nach der letzten Eingabe fertig.
+ *
+ * Eine Anfrage zum Neufärben bricht nichts ab, sie gilt ja dem Bild, das gerade entsteht. Wartet
+ * schon ein neues Bild, übernimmt es nur deren Farben, statt verworfen zu werden.
+ *
+ * Mit coalesce = false wird jede Anfrage der Reihe nach vollständig gerechnet (Stapelbetrieb). Im
+ * Textprotokoll gilt das immer: dort hat ein Bild keinen Kopf mit der Anfragenummer, ein Client, der
+ * pro Zeile ein Bild liest, würde nach einer verworfenen Anfrage ewig warten.
+ */
+
+struct RequestQueue
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    bool textProtocol;
+    bool coalesce;
+
+    // Nur mit mutex: wartende Anfrage, Ende der Eingabe
+    FrameRequest pending;
+    RequestResult pendingResult;
+    bool hasPending;
+    bool ended;
+    long long dropped;
+
+    // Das gerade gerechnete Bild ist veraltet
+    std::atomic<bool> cancel;
+};
+
+/**
+ * @brief Schleife des Lesethreads bis zum Ende der Eingabe.
+ */
+inline void requestReaderLoop(RequestQueue *queue)
+{
+    while (true)
+    {
+        FrameRequest req;
+        RequestResult result = queue->textProtocol ? readTextRequest(stdin, req) : readBinaryRequest(stdin, req);
+
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        if (result == REQUEST_END)
+        {
+            queue->ended = true;
+            queue->changed.notify_all();
+            return;
+        }
+
+        // Ohne Zusammenfassen wartet der Leser, bis die vorige Anfrage abgeholt ist
+        while (!queue->coalesce && queue->hasPending)
+            queue->changed.wait(lock);
+
+        bool recolor = result == REQUEST_READ && (req.flags & REQUEST_FLAG_RECOLOR);
+        if (queue->hasPending)
+        {
+            queue->dropped++;
+            if (recolor && queue->pendingResult == REQUEST_READ && !(queue->pending.flags & REQUEST_FLAG_RECOLOR))
+            {
+                queue->pending.colors = req.colors;
+                continue;
+            }
+        }
+        queue->pending = req;
+        queue->pendingResult = result;
+        queue->hasPending = true;
+        if (queue->coalesce && !recolor)
+            queue->cancel = true;
+        queue->changed.notify_all();
+    }
+}
+
+/**
+ * @brief Startet den Lesethread auf stdin. Er wird abgekoppelt, damit sich das Backend auch bei einem
+ * Fehler sofort beenden kann, während der Thread noch in fread() auf die GUI wartet.
+ *
+ * @param queue
+ * @param textProtocol true für --protocol text
+ * @param coalesce false für --no-coalesce, wirkt nur im Binärprotokoll
+ */
+inline void startRequestReader(RequestQueue &queue, bool textProtocol, bool coalesce)
+{
+    queue.textProtocol = textProtocol;
+    queue.coalesce = coalesce && !textProtocol;
+    queue.hasPending = false;
+    queue.ended = false;
+    queue.dropped = 0;
+    queue.cancel = false;
+    std::thread(requestReaderLoop, &queue).detach();
+}
+
+/**
+ * @brief Wartet auf die nächste Anfrage und setzt cancel zurück.
+ *
+ * @param queue
+ * @param req Ergebnis
+ * @param dropped Ergebnis: seit dem letzten Aufruf verworfene Anfragen
+ * @return REQUEST_END, wenn die Eingabe zu Ende ist und nichts mehr wartet
+ */
+inline RequestResult nextRequest(RequestQueue &queue, FrameRequest &req, long long &dropped)
+{
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (!queue.hasPending && !queue.ended)
+        queue.changed.wait(lock);
+
+    dropped = queue.dropped;
+    queue.dropped = 0;
+    if (!queue.hasPending)
+        return REQUEST_END;
+
+    req = queue.pending;
+    queue.hasPending = false;
+    queue.cancel = false;
+    queue.changed.notify_all();
+    return queue.pendingResult;
+}
+
+#endif
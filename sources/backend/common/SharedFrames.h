@@ -0,0 +1,235 @@
+#ifndef SHARED_FRAMES_H
+#define SHARED_FRAMES_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FractalProtocol.h"
+
+/*
+ * Übergabe der Bilder an die GUI über eine gemeinsam gemappte Datei (--shared-memory, z. B. unter
+ * /dev/shm) statt durch die Pipe. Über stdout geht dann nur noch der Antwortkopf mit Slot, Sequenz
+ * und Position des Bildes; die GUI liest die Pixel direkt aus ihrer Abbildung derselben Datei.
+ *
+ * Aufbau der Datei, Zahlen little-endian:
+ *     0  u32  SHARED_FRAMES_MAGIC ("FSM1")
+ *     4  u32  Anzahl der Slots (SHARED_FRAME_SLOTS)
+ *     8  u64  Größe eines Slots in Bytes
+ *    16  u32  Sequenz je Slot (3 x), ungerade solange das Backend hineinschreibt
+ *    28  i32  Slot, den die GUI gerade liest, -1 = keiner (schreibt nur die GUI)
+ *  4096       Slot 0, Slot 1, Slot 2
+ *
+ * Dreifachpuffer: das Backend schreibt nie in den zuletzt gemeldeten Slot und nicht in den, den die
+ * GUI gerade liest, so bleibt immer ein Slot frei. Hinkt die GUI mehr als ein Bild hinterher, kann ihr
+ * Slot trotzdem überschrieben werden; sie erkennt das an der geänderten Sequenz (Seqlock) und
+ * verwirft das Bild, ein neueres ist dann schon unterwegs.
+ *
+ * Wächst das Bild über die Slotgröße, wird die Datei vergrößert und die Slots rücken weiter
+ * auseinander; die GUI bildet die Datei neu ab, sobald eine Position hinter ihrer Abbildung liegt.
+ */
+
+#define SHARED_FRAMES_MAGIC 0x314D5346u
+#define SHARED_FRAME_SLOTS 3
+#define SHARED_DATA_OFFSET 4096
+// Slotgrößen werden auf ganze MiB aufgerundet, damit kleine Größenänderungen nicht neu abbilden
+#define SHARED_SLOT_ALIGN (1024 * 1024)
+
+struct SharedControl
+{
+    uint32_t magic;
+    uint32_t slots;
+    uint64_t slotBytes;
+    std::atomic<uint32_t> sequence[SHARED_FRAME_SLOTS];
+    std::atomic<int32_t> readerSlot;
+};
+
+static_assert(offsetof(SharedControl, sequence) == 16 && offsetof(SharedControl, readerSlot) == 28, "layout of the control block");
+
+struct SharedFrames
+{
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    uint8_t *base;
+    size_t mappedBytes;
+    uint64_t slotBytes;
+    // Zuletzt an die GUI gemeldeter Slot, -1 = noch keiner
+    int published;
+};
+
+inline SharedControl *sharedControl(SharedFrames &shared)
+{
+    return (SharedControl *)shared.base;
+}
+
+/**
+ * @brief Hebt die Abbildung auf, die Datei bleibt offen.
+ */
+inline void sharedUnmap(SharedFrames &shared)
+{
+    if (shared.base == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(shared.base);
+    CloseHandle(shared.mapping);
+    shared.mapping = NULL;
+#else
+    munmap(shared.base, shared.mappedBytes);
+#endif
+    shared.base = NULL;
+    shared.mappedBytes = 0;
+}
+
+/**
+ * @brief Vergrößert die Datei auf bytes und bildet sie ab.
+ *
+ * @return false bei Fehler, dann ist nichts abgebildet
+ */
+inline bool sharedMap(SharedFrames &shared, size_t bytes)
+{
+    sharedUnmap(shared);
+#ifdef _WIN32
+    // Das Mapping vergrößert die Datei selbst
+    shared.mapping = CreateFileMappingA(shared.file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)bytes >> 32), (DWORD)bytes, NULL);
+    if (shared.mapping == NULL)
+        return false;
+    shared.base = (uint8_t *)MapViewOfFile(shared.mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (shared.base == NULL)
+    {
+        CloseHandle(shared.mapping);
+        shared.mapping = NULL;
+        return false;
+    }
+#else
+    if (ftruncate(shared.fd, (off_t)bytes) != 0)
+        return false;
+    void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shared.fd, 0);
+    if (p == MAP_FAILED)
+        return false;
+    shared.base = (uint8_t *)p;
+#endif
+    shared.mappedBytes = bytes;
+    return true;
+}
+
+/**
+ * @brief Legt die Datei an (ein vorhandener Inhalt wird verworfen) und schreibt den Kontrollblock.
+ * Die Slots haben zunächst die Größe 0 und wachsen mit dem ersten Bild.
+ *
+ * @param shared Ergebnis
+ * @param path
+ * @return false, wenn die Datei nicht angelegt oder abgebildet werden kann
+ */
+inline bool openSharedFrames(SharedFrames &shared, const char *path)
+{
+    shared.base = NULL;
+    shared.mappedBytes = 0;
+    shared.slotBytes = 0;
+    shared.published = -1;
+#ifdef _WIN32
+    shared.mapping = NULL;
+    shared.file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+    if (shared.file == INVALID_HANDLE_VALUE)
+        return false;
+#else
+    shared.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (shared.fd < 0)
+        return false;
+#endif
+    if (!sharedMap(shared, SHARED_DATA_OFFSET))
+        return false;
+
+    SharedControl *control = sharedControl(shared);
+    control->magic = SHARED_FRAMES_MAGIC;
+    control->slots = SHARED_FRAME_SLOTS;
+    control->slotBytes = 0;
+    for (int i = 0; i < SHARED_FRAME_SLOTS; i++)
+        control->sequence[i].store(0, std::memory_order_relaxed);
+    control->readerSlot.store(-1, std::memory_order_release);
+    return true;
+}
+
+inline void closeSharedFrames(SharedFrames &shared)
+{
+    sharedUnmap(shared);
+#ifdef _WIN32
+    CloseHandle(shared.file);
+#else
+    close(shared.fd);
+#endif
+}
+
+/**
+ * @brief Sucht einen freien Slot, vergrößert bei Bedarf die Datei und markiert den Slot als
+ * beschrieben. Danach muss genau eines von publishSharedFrame() oder abortSharedFrame() folgen.
+ *
+ * @param shared
+ * @param bytes Größe des Bildes
+ * @param slot Ergebnis
+ * @return Anfang des Slots, NULL wenn die Datei nicht vergrößert werden konnte
+ */
+inline uint8_t *beginSharedFrame(SharedFrames &shared, size_t bytes, int &slot)
+{
+    if (bytes > shared.slotBytes)
+    {
+        uint64_t slotBytes = (bytes + SHARED_SLOT_ALIGN - 1) / SHARED_SLOT_ALIGN * SHARED_SLOT_ALIGN;
+        if (!sharedMap(shared, SHARED_DATA_OFFSET + SHARED_FRAME_SLOTS * slotBytes))
+            return NULL;
+        shared.slotBytes = slotBytes;
+
+        // Alle Slots haben sich verschoben; noch nicht gelesene Bilder sind damit ungültig
+        SharedControl *control = sharedControl(shared);
+        control->slotBytes = slotBytes;
+        for (int i = 0; i < SHARED_FRAME_SLOTS; i++)
+            control->sequence[i].fetch_add(2, std::memory_order_release);
+        shared.published = -1;
+    }
+
+    SharedControl *control = sharedControl(shared);
+    int reading = control->readerSlot.load(std::memory_order_acquire);
+    slot = 0;
+    while (slot == shared.published || slot == reading)
+        slot++;
+
+    control->sequence[slot].fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return shared.base + SHARED_DATA_OFFSET + slot * shared.slotBytes;
+}
+
+/**
+ * @brief Gibt einen fertig beschriebenen Slot frei und trägt ihn in die Antwort ein.
+ */
+inline void publishSharedFrame(SharedFrames &shared, int slot, FrameResponse &res)
+{
+    SharedControl *control = sharedControl(shared);
+    res.sharedSlot = slot;
+    res.sharedSequence = control->sequence[slot].fetch_add(1, std::memory_order_release) + 1;
+    res.sharedOffset = SHARED_DATA_OFFSET + slot * shared.slotBytes;
+    shared.published = slot;
+}
+
+/**
+ * @brief Gibt einen Slot ohne Bild frei (abgebrochenes Bild).
+ */
+inline void abortSharedFrame(SharedFrames &shared, int slot)
+{
+    sharedControl(shared)->sequence[slot].fetch_add(1, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,471 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FractalCore.h"
+#include "FrameCache.h"
+
+/*
+ * Cache für Iterationen über Bilder hinweg, in Kacheln eines globalen Pixelrasters. Zwei Bilder mit
+ * gleicher Pixelgröße liegen auf demselben Raster, wenn ihre Zentren um ganze Pixel auseinanderliegen;
+ * Pixel (x, y) eines Bildes ist dann der globale Pixel (originX + x, originY + y), siehe tileOrigin().
+ * Das Raster ist in Kacheln von TILE_CACHE_SIZE x TILE_CACHE_SIZE Pixeln geteilt. Schlüssel einer
+ * Kachel sind die Zoomstufe (die Pixelgröße, exakt als Bitmuster, weil die GUI um beliebige Faktoren
+ * zoomt), MAX_ITER, das Rechenverfahren und die Kachelkoordinaten. Eine Kachel kann unvollständig
+ * sein, fehlende Pixel sind -1 und werden von späteren Bildern ergänzt.
+ *
+ * Kehrt die GUI zu einer schon gesehenen Ansicht zurück (Zurücksetzen auf Zoom 1, Zurückzoomen um
+ * dieselben Faktoren, Ziehen in eine schon besuchte Gegend), setzt sich das Bild aus den Kacheln
+ * zusammen und nur die Lücken werden gerechnet.
+ *
+ * Im Speicher hält der Cache höchstens capacity Kacheln und verdrängt die am längsten unbenutzte
+ * (LRU). Mit einem Verzeichnis (--tile-cache-dir) werden verdrängte Kacheln und beim Beenden alle
+ * übrigen dorthin geschrieben und bei einem Fehlgriff im Speicher von dort gelesen, auch in späteren
+ * Sitzungen. Jede Datei trägt einen Fingerabdruck des Backends und der Rechenschalter; passt er nicht,
+ * gilt sie als nicht vorhanden.
+ *
+ * Nur für Bilder in float und double; bei tieferen Zooms ist das Raster in double nicht darstellbar.
+ */
+
+// Kantenlänge einer Kachel in Pixeln
+#define TILE_CACHE_SIZE 64
+// Standardgröße des Caches im Speicher (--tile-cache MB)
+#define TILE_CACHE_DEFAULT_MB 128
+// "FTC1", Anfang jeder Kacheldatei
+#define TILE_CACHE_FILE_MAGIC 0x31435446u
+// Größter Betrag des Rasterursprungs in Pixeln, bis zu dem ganze Pixel in double sicher erkannt werden
+#define TILE_CACHE_MAX_ORIGIN 4.0e12
+#define TILE_CACHE_PATH_MAX 1024
+
+struct TileKey
+{
+    uint64_t scaleBits;
+    int32_t MAX_ITER;
+    int32_t precision;
+    int64_t tileX, tileY;
+};
+
+struct TileEntry
+{
+    TileKey key;
+    // Nachbarn in der LRU-Liste und nächster Eintrag im selben Bucket, -1 = keiner
+    int newer, older;
+    int hashNext;
+    // TILE_CACHE_SIZE * TILE_CACHE_SIZE Iterationen, zeilenweise, -1 = nicht gerechnet
+    int *iters;
+};
+
+// Zähler für ein Bild
+struct TileCacheStats
+{
+    int hits;
+    // davon aus dem Verzeichnis gelesen
+    int diskHits;
+    int misses;
+};
+
+struct TileCache
+{
+    // Höchstzahl der Kacheln im Speicher, 0 = Cache aus
+    int capacity;
+    int count;
+    TileEntry *entries;
+    // Erster Eintrag pro Bucket, -1 = leer; Anzahl ist bucketMask + 1
+    int *buckets;
+    int bucketMask;
+    // Zuletzt und am längsten nicht benutzte Kachel, -1 bei leerem Cache
+    int newest, oldest;
+    // Verzeichnis für verdrängte Kacheln, NULL ohne
+    const char *spillDir;
+    uint32_t fingerprint;
+    // Nur einmal über ein nicht beschreibbares Verzeichnis klagen
+    bool spillFailed;
+    // Eine Kachel, in die aus dem Verzeichnis gelesen wird, bevor sie einen Eintrag bekommt
+    int *scratch;
+    // Summen über alle Bilder
+    long long hits, misses;
+};
+
+inline uint32_t tileCacheHashBytes(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+/**
+ * @brief Fingerabdruck aller Schalter, die die Iterationen eines Pixels ändern können (FNV-1a).
+ *
+ * @param opts
+ * @param renderer Name des Backends; CPU und GPU teilen keine Kacheln, weil gleiche Iterationen an den
+ *        Compilerschaltern hängen (siehe FractalCore.h) und ein anders gebautes Backend fremde Kacheln läse
+ */
+inline uint32_t tileCacheFingerprint(const RenderOptions &opts, const char *renderer)
+{
+    uint32_t hash = 2166136261u;
+    hash = tileCacheHashBytes(hash, renderer, strlen(renderer));
+    uint8_t flags[4] = {opts.interiorCheck, opts.periodicityCheck, opts.marianiSilver, opts.bla};
+    hash = tileCacheHashBytes(hash, flags, sizeof(flags));
+    return tileCacheHashBytes(hash, &opts.periodicityTolerance, sizeof(opts.periodicityTolerance));
+}
+
+/**
+ * @brief Legt den Cache an.
+ *
+ * @param cache Ergebnis, mit closeTileCache() freigeben
+ * @param megabytes Größe im Speicher, 0 schaltet den Cache ab
+ * @param spillDir vorhandenes Verzeichnis für verdrängte Kacheln, NULL ohne
+ * @param opts
+ * @param renderer siehe tileCacheFingerprint()
+ * @return false bei fehlendem Speicher, der Cache ist dann aus
+ */
+inline bool openTileCache(TileCache &cache, int megabytes, const char *spillDir, const RenderOptions &opts, const char *renderer)
+{
+    memset(&cache, 0, sizeof(cache));
+    cache.newest = cache.oldest = -1;
+    cache.spillDir = spillDir;
+    cache.fingerprint = tileCacheFingerprint(opts, renderer);
+    cache.capacity = (int)((size_t)megabytes * 1024 * 1024 / (sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE));
+    if (cache.capacity == 0)
+        return true;
+
+    int buckets = 1;
+    while (buckets < 2 * cache.capacity)
+        buckets *= 2;
+    cache.bucketMask = buckets - 1;
+    cache.entries = (TileEntry *)calloc(cache.capacity, sizeof(TileEntry));
+    cache.buckets = (int *)malloc(sizeof(int) * buckets);
+    cache.scratch = (int *)malloc(sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE);
+    if (cache.entries == NULL || cache.buckets == NULL || cache.scratch == NULL)
+    {
+        free(cache.entries);
+        free(cache.buckets);
+        free(cache.scratch);
+        cache.entries = NULL;
+        cache.buckets = NULL;
+        cache.scratch = NULL;
+        cache.capacity = 0;
+        return false;
+    }
+    memset(cache.buckets, 0xFF, sizeof(int) * buckets);
+    return true;
+}
+
+inline int tileBucket(const TileCache &cache, const TileKey &key)
+{
+    uint64_t hash = key.scaleBits ^ ((uint64_t)(uint32_t)key.MAX_ITER << 32) ^ (uint32_t)key.precision;
+    hash = (hash ^ (uint64_t)key.tileX) * 0x9E3779B97F4A7C15ull;
+    hash = (hash ^ (uint64_t)key.tileY) * 0x9E3779B97F4A7C15ull;
+    return (int)((hash ^ (hash >> 32)) & (uint64_t)cache.bucketMask);
+}
+
+inline bool sameTile(const TileKey &a, const TileKey &b)
+{
+    return a.scaleBits == b.scaleBits && a.MAX_ITER == b.MAX_ITER && a.precision == b.precision && a.tileX == b.tileX &&
+           a.tileY == b.tileY;
+}
+
+/**
+ * @return Index der Kachel im Speicher, -1 wenn sie fehlt
+ */
+inline int findTile(const TileCache &cache, const TileKey &key)
+{
+    for (int i = cache.buckets[tileBucket(cache, key)]; i >= 0; i = cache.entries[i].hashNext)
+    {
+        if (sameTile(cache.entries[i].key, key))
+            return i;
+    }
+    return -1;
+}
+
+inline void unlinkTileLru(TileCache &cache, int i)
+{
+    TileEntry &e = cache.entries[i];
+    if (e.newer >= 0)
+        cache.entries[e.newer].older = e.older;
+    else
+        cache.newest = e.older;
+    if (e.older >= 0)
+        cache.entries[e.older].newer = e.newer;
+    else
+        cache.oldest = e.newer;
+}
+
+/**
+ * @brief Macht eine Kachel zur zuletzt benutzten.
+ */
+inline void touchTile(TileCache &cache, int i)
+{
+    if (cache.newest == i)
+        return;
+    unlinkTileLru(cache, i);
+    TileEntry &e = cache.entries[i];
+    e.newer = -1;
+    e.older = cache.newest;
+    cache.entries[cache.newest].newer = i;
+    cache.newest = i;
+}
+
+inline void tileFilePath(const TileCache &cache, const TileKey &key, char *path)
+{
+    snprintf(path, TILE_CACHE_PATH_MAX, "%s/%016llx_%d_%d_%lld_%lld.tile", cache.spillDir, (unsigned long long)key.scaleBits,
+             key.MAX_ITER, key.precision, (long long)key.tileX, (long long)key.tileY);
+}
+
+/**
+ * @brief Schreibt eine Kachel ins Verzeichnis; ein Fehler kostet nur den späteren Treffer.
+ */
+inline void spillTile(TileCache &cache, const TileEntry &e)
+{
+    char path[TILE_CACHE_PATH_MAX];
+    tileFilePath(cache, e.key, path);
+    FILE *file = fopen(path, "wb");
+    uint32_t header[2] = {TILE_CACHE_FILE_MAGIC, cache.fingerprint};
+    bool ok = file != NULL && fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(e.iters, sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE, 1, file) == 1;
+    if (file != NULL && fclose(file) != 0)
+        ok = false;
+    if (!ok && !cache.spillFailed)
+    {
+        fprintf(stderr, "Cannot write tile cache file %s\n", path);
+        cache.spillFailed = true;
+    }
+}
+
+/**
+ * @brief Liest eine Kachel aus dem Verzeichnis.
+ *
+ * @return false, wenn es sie nicht gibt oder sie von anderen Rechenschaltern stammt
+ */
+inline bool loadTile(const TileCache &cache, const TileKey &key, int *iters)
+{
+    char path[TILE_CACHE_PATH_MAX];
+    tileFilePath(cache, key, path);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+    uint32_t header[2];
+    bool ok = fread(header, sizeof(header), 1, file) == 1 && header[0] == TILE_CACHE_FILE_MAGIC && header[1] == cache.fingerprint &&
+              fread(iters, sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE, 1, file) == 1;
+    fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Nimmt einen Eintrag für key, ist der Cache voll, den der am längsten unbenutzten Kachel. Die
+ * Iterationen des Eintrags sind danach undefiniert.
+ *
+ * @return Index, -1 bei fehlendem Speicher
+ */
+inline int allocTile(TileCache &cache, const TileKey &key)
+{
+    int i;
+    if (cache.count < cache.capacity)
+    {
+        i = cache.count;
+        cache.entries[i].iters = (int *)malloc(sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE);
+        if (cache.entries[i].iters == NULL)
+            return -1;
+        cache.count++;
+    }
+    else
+    {
+        i = cache.oldest;
+        if (cache.spillDir != NULL)
+            spillTile(cache, cache.entries[i]);
+        unlinkTileLru(cache, i);
+        int *link = &cache.buckets[tileBucket(cache, cache.entries[i].key)];
+        while (*link != i)
+            link = &cache.entries[*link].hashNext;
+        *link = cache.entries[i].hashNext;
+    }
+
+    TileEntry &e = cache.entries[i];
+    e.key = key;
+    int bucket = tileBucket(cache, key);
+    e.hashNext = cache.buckets[bucket];
+    cache.buckets[bucket] = i;
+    e.newer = -1;
+    e.older = cache.newest;
+    if (cache.newest >= 0)
+        cache.entries[cache.newest].newer = i;
+    cache.newest = i;
+    if (cache.oldest < 0)
+        cache.oldest = i;
+    return i;
+}
+
+/**
+ * @brief Prüft, ob ein Bild auf dem Kachelraster liegt, und liefert die globale Lage seines Pixels (0, 0).
+ *
+ * @param frame
+ * @param originX Ergebnis: globale Spalte von Pixel 0, centerX / scale - WIDTH / 2
+ * @param originY Ergebnis: globale Zeile von Pixel 0, -centerY / scale - HEIGHT / 2
+ * @return false, wenn das Zentrum nicht auf ganzen Pixeln liegt oder das Rechenverfahren nicht passt
+ */
+inline bool tileOrigin(const FrameParams &frame, int64_t &originX, int64_t &originY)
+{
+    if (frame.precision != PRECISION_FLOAT && frame.precision != PRECISION_DOUBLE)
+        return false;
+    double x = frame.centerX / frame.scale - frame.WIDTH / 2.0;
+    double y = -frame.centerY / frame.scale - frame.HEIGHT / 2.0;
+    if (!(fabs(x) < TILE_CACHE_MAX_ORIGIN && fabs(y) < TILE_CACHE_MAX_ORIGIN))
+        return false;
+    if (fabs(x - round(x)) > PAN_TOLERANCE || fabs(y - round(y)) > PAN_TOLERANCE)
+        return false;
+    originX = (int64_t)round(x);
+    originY = (int64_t)round(y);
+    return true;
+}
+
+inline int64_t tileIndex(int64_t pixel)
+{
+    return pixel >= 0 ? pixel / TILE_CACHE_SIZE : -((-pixel + TILE_CACHE_SIZE - 1) / TILE_CACHE_SIZE);
+}
+
+inline TileKey frameTileKey(const FrameParams &frame)
+{
+    TileKey key;
+    memcpy(&key.scaleBits, &frame.scale, sizeof(key.scaleBits));
+    key.MAX_ITER = frame.MAX_ITER;
+    key.precision = (int32_t)frame.precision;
+    key.tileX = key.tileY = 0;
+    return key;
+}
+
+/**
+ * @brief Kopiert die Überdeckung einer Kachel mit dem Bild, in die eine oder andere Richtung.
+ *
+ * @param tile Iterationen der Kachel
+ * @param iterations Iterationen des Bildes
+ * @param x0 Bildspalte, ab der die Kachel liegt (auch negativ)
+ * @param y0 Bildzeile, ab der die Kachel liegt
+ * @param WIDTH
+ * @param HEIGHT
+ * @param toFrame true: Kachel ins Bild, false: Bild in die Kachel
+ */
+inline void copyTileOverlap(int *tile, int *iterations, int x0, int y0, int WIDTH, int HEIGHT, bool toFrame)
+{
+    int xs = x0 > 0 ? x0 : 0;
+    int xe = x0 + TILE_CACHE_SIZE < WIDTH ? x0 + TILE_CACHE_SIZE : WIDTH;
+    int ys = y0 > 0 ? y0 : 0;
+    int ye = y0 + TILE_CACHE_SIZE < HEIGHT ? y0 + TILE_CACHE_SIZE : HEIGHT;
+    for (int y = ys; y < ye; y++)
+    {
+        int *frameRow = iterations + (size_t)y * WIDTH + xs;
+        int *tileRow = tile + (y - y0) * TILE_CACHE_SIZE + (xs - x0);
+        if (toFrame)
+            memcpy(frameRow, tileRow, sizeof(int) * (xe - xs));
+        else
+            memcpy(tileRow, frameRow, sizeof(int) * (xe - xs));
+    }
+}
+
+/**
+ * @brief Setzt die Iterationen eines Bildes aus den vorhandenen Kacheln zusammen, alle übrigen Pixel
+ * werden -1. Fehlt eine Kachel im Speicher, wird sie im Verzeichnis gesucht.
+ *
+ * @param cache
+ * @param frame
+ * @param originX Ergebnis von tileOrigin()
+ * @param originY
+ * @param iterations WIDTH * HEIGHT Einträge, Ergebnis
+ * @param stats Ergebnis: Treffer und Fehlgriffe dieses Bildes
+ */
+inline void fetchTiles(TileCache &cache, const FrameParams &frame, int64_t originX, int64_t originY, int *iterations, TileCacheStats &stats)
+{
+    stats.hits = stats.diskHits = stats.misses = 0;
+    memset(iterations, 0xFF, sizeof(int) * frame.WIDTH * (size_t)frame.HEIGHT);
+
+    TileKey key = frameTileKey(frame);
+    for (key.tileY = tileIndex(originY); key.tileY <= tileIndex(originY + frame.HEIGHT - 1); key.tileY++)
+    {
+        for (key.tileX = tileIndex(originX); key.tileX <= tileIndex(originX + frame.WIDTH - 1); key.tileX++)
+        {
+            int i = findTile(cache, key);
+            // Ein Eintrag wird erst verdrängt, wenn die Datei da ist
+            if (i < 0 && cache.spillDir != NULL && loadTile(cache, key, cache.scratch))
+            {
+                i = allocTile(cache, key);
+                if (i >= 0)
+                {
+                    memcpy(cache.entries[i].iters, cache.scratch, sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE);
+                    stats.diskHits++;
+                }
+            }
+            if (i < 0)
+            {
+                stats.misses++;
+                continue;
+            }
+            stats.hits++;
+            touchTile(cache, i);
+            copyTileOverlap(cache.entries[i].iters, iterations, (int)(key.tileX * TILE_CACHE_SIZE - originX),
+                            (int)(key.tileY * TILE_CACHE_SIZE - originY), frame.WIDTH, frame.HEIGHT, true);
+        }
+    }
+    cache.hits += stats.hits;
+    cache.misses += stats.misses;
+}
+
+/**
+ * @brief Übernimmt die Iterationen eines fertigen Bildes in die Kacheln, die es überdeckt. Kacheln am
+ * Bildrand bleiben außerhalb des Bildes, wie sie waren (-1 bei neuen).
+ *
+ * @param cache
+ * @param frame
+ * @param originX Ergebnis von tileOrigin()
+ * @param originY
+ * @param iterations vollständig gerechnet
+ */
+inline void storeTiles(TileCache &cache, const FrameParams &frame, int64_t originX, int64_t originY, const int *iterations)
+{
+    TileKey key = frameTileKey(frame);
+    for (key.tileY = tileIndex(originY); key.tileY <= tileIndex(originY + frame.HEIGHT - 1); key.tileY++)
+    {
+        for (key.tileX = tileIndex(originX); key.tileX <= tileIndex(originX + frame.WIDTH - 1); key.tileX++)
+        {
+            int i = findTile(cache, key);
+            if (i < 0)
+            {
+                // Eine Kachel im Verzeichnis wird ergänzt, nicht später mit einer Teilkachel überschrieben
+                i = allocTile(cache, key);
+                if (i < 0)
+                    return;
+                if (cache.spillDir == NULL || !loadTile(cache, key, cache.entries[i].iters))
+                    memset(cache.entries[i].iters, 0xFF, sizeof(int) * TILE_CACHE_SIZE * TILE_CACHE_SIZE);
+            }
+            touchTile(cache, i);
+            copyTileOverlap(cache.entries[i].iters, (int *)iterations, (int)(key.tileX * TILE_CACHE_SIZE - originX),
+                            (int)(key.tileY * TILE_CACHE_SIZE - originY), frame.WIDTH, frame.HEIGHT, false);
+        }
+    }
+}
+
+/**
+ * @brief Schreibt mit Verzeichnis alle Kacheln dorthin und gibt den Speicher frei.
+ */
+inline void closeTileCache(TileCache &cache)
+{
+    for (int i = 0; i < cache.count; i++)
+    {
+        if (cache.spillDir != NULL)
+            spillTile(cache, cache.entries[i]);
+        free(cache.entries[i].iters);
+    }
+    free(cache.entries);
+    free(cache.buckets);
+    free(cache.scratch);
+    cache.entries = NULL;
+    cache.buckets = NULL;
+    cache.scratch = NULL;
+    cache.count = cache.capacity = 0;
+}
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef TILE_WRITER_H
+#define TILE_WRITER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Ausgabe eines Bildes in Kacheln, ohne das ganze Bild im Speicher zu halten (ein RGB-Bild mit
+ * 100000 x 100000 Pixeln hat 30 GB). Kacheln kommen Kachelzeile für Kachelzeile von oben nach unten,
+ * innerhalb einer Kachelzeile in beliebiger Reihenfolge.
+ *
+ * Ist die Ausgabe eine Datei, wird jede Kachel sofort an ihre Stelle geschrieben; im Speicher liegen
+ * nur die Kacheln, die gerade gerechnet werden. In eine Pipe (stdout an die GUI) kann nur der Reihe
+ * nach geschrieben werden: dort sammeln zwei Streifenpuffer je eine Kachelzeile, damit die nächste
+ * Kachelzeile schon gerechnet werden kann, während die vorige noch geschrieben wird.
+ */
+
+// Kantenlänge der Kacheln, wenn nichts anderes angegeben ist
+#define TILE_SIZE_DEFAULT 256
+// Bilder mit mehr RGB-Bytes werden automatisch in Kacheln gerechnet (1 GiB)
+#define TILE_FRAME_LIMIT (1024LL * 1024 * 1024)
+
+#ifdef _WIN32
+#define tileSeek _fseeki64
+#define tileTell _ftelli64
+#else
+#define tileSeek fseeko
+#define tileTell ftello
+#endif
+
+struct TileWriter
+{
+    FILE *file;
+    bool seekable;
+    // Position des ersten Pixels in der Datei (hinter dem PPM-Kopf bzw. vorigen Bildern)
+    long long dataOffset;
+    int WIDTH, HEIGHT;
+    int tileSize;
+    // Nur ohne Seek: zwei Streifen von WIDTH x tileSize Pixeln, abwechselnd pro Kachelzeile
+    uint8_t *strip[2];
+};
+
+/**
+ * @brief Bereitet die Ausgabe eines Bildes vor und schreibt bei Bedarf den PPM-Kopf.
+ *
+ * @param writer Ergebnis
+ * @param file Ziel, Datei oder Pipe
+ * @param ppmHeader true: binäres PPM (P6), sonst rohe RGB-Bytes wie im Protokoll zur GUI
+ * @param WIDTH
+ * @param HEIGHT
+ * @param tileSize
+ * @return false bei Schreibfehler oder fehlendem Speicher für die Streifen
+ */
+inline bool openTileWriter(TileWriter &writer, FILE *file, bool ppmHeader, int WIDTH, int HEIGHT, int tileSize)
+{
+    writer.file = file;
+    writer.WIDTH = WIDTH;
+    writer.HEIGHT = HEIGHT;
+    writer.tileSize = tileSize;
+    writer.strip[0] = NULL;
+    writer.strip[1] = NULL;
+
+    if (ppmHeader && fprintf(file, "P6\n%d %d\n255\n", WIDTH, HEIGHT) < 0)
+        return false;
+    if (fflush(file) != 0)
+        return false;
+
+    // Pipes und Terminals lassen sich nicht positionieren
+    writer.dataOffset = tileTell(file);
+    writer.seekable = writer.dataOffset >= 0 && tileSeek(file, writer.dataOffset, SEEK_SET) == 0;
+    if (writer.seekable)
+        return true;
+
+    size_t stripBytes = (size_t)WIDTH * tileSize * 3;
+    writer.strip[0] = (uint8_t *)malloc(stripBytes);
+    writer.strip[1] = (uint8_t *)malloc(stripBytes);
+    if (writer.strip[0] == NULL || writer.strip[1] == NULL)
+    {
+        free(writer.strip[0]);
+        free(writer.strip[1]);
+        writer.strip[0] = NULL;
+        writer.strip[1] = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Übernimmt eine fertige Kachel. Nicht threadsicher: gleichzeitige Aufrufe muss der
+ * Aufrufer serialisieren.
+ *
+ * @param writer
+ * @param rgb Kachel, tileW x tileH Pixel ohne Zeilenabstand
+ * @param tileX linke Bildspalte der Kachel
+ * @param tileY obere Bildzeile der Kachel, Vielfaches von tileSize
+ * @param tileW
+ * @param tileH
+ * @return false bei Schreibfehler
+ */
+inline bool writeTile(TileWriter &writer, const uint8_t *rgb, int tileX, int tileY, int tileW, int tileH)
+{
+    size_t rowBytes = (size_t)tileW * 3;
+
+    if (!writer.seekable)
+    {
+        uint8_t *strip = writer.strip[(tileY / writer.tileSize) % 2];
+        for (int y = 0; y < tileH; y++)
+            memcpy(strip + ((size_t)y * writer.WIDTH + tileX) * 3, rgb + y * rowBytes, rowBytes);
+        return true;
+    }
+
+    for (int y = 0; y < tileH; y++)
+    {
+        long long offset = writer.dataOffset + ((long long)(tileY + y) * writer.WIDTH + tileX) * 3;
+        if (tileSeek(writer.file, offset, SEEK_SET) != 0 || fwrite(rgb + y * rowBytes, 1, rowBytes, writer.file) != rowBytes)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Schließt eine Kachelzeile ab, nachdem alle ihre Kacheln an writeTile() gegangen sind.
+ * Ohne Seek wird jetzt ihr Streifen geschrieben; das darf parallel zu writeTile() für die
+ * folgende Kachelzeile laufen, aber nicht für die übernächste.
+ *
+ * @param writer
+ * @param tileY obere Bildzeile der Kachelzeile
+ * @return false bei Schreibfehler
+ */
+inline bool finishTileRow(TileWriter &writer, int tileY)
+{
+    if (writer.seekable)
+        return true;
+
+    int rows = writer.HEIGHT - tileY < writer.tileSize ? writer.HEIGHT - tileY : writer.tileSize;
+    size_t bytes = (size_t)writer.WIDTH * rows * 3;
+    return fwrite(writer.strip[(tileY / writer.tileSize) % 2], 1, bytes, writer.file) == bytes;
+}
+
+/**
+ * @brief Gekachelte Ausgabe eines schwarzen Bildes, wenn der Referenzorbit fehlt.
+ *
+ * @return false bei Schreibfehler oder fehlendem Speicher
+ */
+inline bool writeBlackTiles(TileWriter &out)
+{
+    uint8_t *black = (uint8_t *)calloc((size_t)out.tileSize * out.tileSize, 3);
+    if (black == NULL)
+        return false;
+
+    bool ok = true;
+    for (int tileY = 0; tileY < out.HEIGHT && ok; tileY += out.tileSize)
+    {
+        int h = out.HEIGHT - tileY < out.tileSize ? out.HEIGHT - tileY : out.tileSize;
+        for (int tileX = 0; tileX < out.WIDTH && ok; tileX += out.tileSize)
+        {
+            int w = out.WIDTH - tileX < out.tileSize ? out.WIDTH - tileX : out.tileSize;
+            ok = writeTile(out, black, tileX, tileY, w, h);
+        }
+        ok = ok && finishTileRow(out, tileY);
+    }
+    free(black);
+    return ok;
+}
+
+/**
+ * @brief Gibt die Streifen frei und lässt die Ausgabe hinter dem letzten Pixel stehen, so dass ein
+ * folgendes Bild dort anschließt. Schließt die Datei nicht.
+ *
+ * @return false, wenn Positionieren oder Leeren fehlschlägt
+ */
+inline bool closeTileWriter(TileWriter &writer)
+{
+    free(writer.strip[0]);
+    free(writer.strip[1]);
+    writer.strip[0] = NULL;
+    writer.strip[1] = NULL;
+
+    if (writer.seekable && tileSeek(writer.file, writer.dataOffset + (long long)writer.WIDTH * writer.HEIGHT * 3, SEEK_SET) != 0)
+        return false;
+    return fflush(writer.file) == 0;
+}
+
+#endif
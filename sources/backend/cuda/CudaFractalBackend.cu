@@ -1,156 +1,820 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <cuda_runtime.h>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "../common/FractalCore.h"
+#include "../common/FractalProtocol.h"
+#include "../common/FrameCache.h"
+#include "../common/Palette.h"
+#include "../common/Perturbation.h"
+#include "../common/RequestQueue.h"
+#include "../common/SharedFrames.h"
+#include "../common/TileCache.h"
+#include "../common/TileWriter.h"
+
 /**
- * @brief  Berechnet die Anzahl der Iterationen für einen Punkt im Mandelbrot
+ * @brief Render-Funktion für das Mandelbrot. Diese Funktion wird auf der GPU ausgeführt daher __global__.
+ * Die Funktion berechnet die Mandelbrot-Menge für jeden Pixel im Bild und speichert die RGB-Werte in das Bild-Array.
+ * 
+ * Mit x0, y0, w, h wird nur ein Ausschnitt des Bildes berechnet (gekachelter Modus), das ganze Bild ist 0, 0, WIDTH, HEIGHT.
  * 
- * @param real 
- * @param imag 
- * @param max_iter 
- * @return anzahl der Iterationen
+ * @param image Ausgabe, w x h Pixel
+ * @param iters wenn nicht NULL: Ausgabe der Iterationen, w x h Einträge, zum späteren Neufärben
+ * @param smooth wenn nicht NULL: Ausgabe der glatten Iterationsanzahlen (smoothIterations()), w x h Einträge
+ * @param f Bildparameter, Referenzorbit im Device-Speicher
+ * @param opts 
+ * @param colors mit colors.smooth wird stufenlos gefärbt
+ * @param x0 linke Bildspalte des Ausschnitts
+ * @param y0 obere Bildzeile des Ausschnitts
+ * @param w
+ * @param h
+ * @return void
+ */
+__global__ void render(uint8_t *image, int *iters, float *smooth, FrameParams f, RenderOptions opts, ColorOptions colors, int x0, int y0,
+                       int w, int h)
+{
+    int tx = blockIdx.x * blockDim.x + threadIdx.x;
+    int ty = blockIdx.y * blockDim.y + threadIdx.y;
+    if (tx >= w || ty >= h)
+        return;
+
+    float norm = 0.0f;
+    int iter = pixelIterations(f, opts, x0 + tx, y0 + ty, NULL, &norm);
+    float value = smooth != NULL || colors.smooth ? smoothIterations(iter, norm, f.MAX_ITER) : 0.0f;
+    int idx = 3 * (ty * w + tx);
+    if (iters != NULL)
+        iters[ty * w + tx] = iter;
+    if (smooth != NULL)
+        smooth[ty * w + tx] = value;
+
+    uint8_t r, g, b;
+    if (colors.smooth)
+        smoothToRGB(value, f.MAX_ITER, colors, r, g, b);
+    else
+        iterToRGB(iter, f.MAX_ITER, colors, r, g, b);
+
+    image[idx + 0] = r;
+    image[idx + 1] = g;
+    image[idx + 2] = b;
+
+}
+
+// Pixel pro Kernel-Aufruf, zwischen zwei Aufrufen wird auf eine neuere Anfrage geprüft
+#define CANCEL_SLICE_PIXELS (1 << 20)
+
+/**
+ * @brief render() für das ganze Bild in Abschnitten von etwa CANCEL_SLICE_PIXELS Pixeln. Vor jedem
+ * Abschnitt wird cancel geprüft. Es ist immer höchstens ein Abschnitt im Voraus in der Warteschlange,
+ * so bleibt die GPU beschäftigt und ein Abbruch wirkt nach spätestens zwei Abschnitten.
+ *
+ * @param d_image RGB-Ausgabe auf der GPU, WIDTH x HEIGHT Pixel
+ * @param d_iters Ausgabe der Iterationen auf der GPU, WIDTH x HEIGHT Einträge
+ * @param d_smooth NULL oder Ausgabe der glatten Iterationsanzahlen auf der GPU, WIDTH x HEIGHT Einträge
+ * @param f
+ * @param opts
+ * @param colors
+ * @param block
+ * @param cancel
+ * @return false, wenn das Bild wegen cancel unvollständig ist
+ */
+bool renderSliced(uint8_t *d_image, int *d_iters, float *d_smooth, const FrameParams &f, RenderOptions opts, ColorOptions colors,
+                  dim3 block, const std::atomic<bool> &cancel)
+{
+    int rows = max(1, CANCEL_SLICE_PIXELS / f.WIDTH);
+    cudaEvent_t done[2];
+    cudaEventCreate(&done[0]);
+    cudaEventCreate(&done[1]);
+
+    bool complete = true;
+    int slice = 0;
+    for (int y0 = 0; y0 < f.HEIGHT; y0 += rows, slice++) {
+        if (cancel) {
+            complete = false;
+            break;
+        }
+        int h = min(rows, f.HEIGHT - y0);
+        dim3 grid((f.WIDTH + block.x - 1) / block.x, (h + block.y - 1) / block.y);
+        render<<<grid, block>>>(d_image + (size_t)3 * y0 * f.WIDTH, d_iters + (size_t)y0 * f.WIDTH,
+                                d_smooth != NULL ? d_smooth + (size_t)y0 * f.WIDTH : NULL, f, opts, colors, 0, y0, f.WIDTH, h);
+        cudaEventRecord(done[slice % 2]);
+
+        // Auf den vorigen Abschnitt warten, der aktuelle läuft derweil
+        if (slice > 0)
+            cudaEventSynchronize(done[(slice - 1) % 2]);
+    }
+
+    cudaDeviceSynchronize();
+    cudaEventDestroy(done[0]);
+    cudaEventDestroy(done[1]);
+    return complete;
+}
+
+// Mariani-Silver auf der GPU: Kantenlänge der Kacheln im ersten Durchlauf, kleinste Kachel,
+// Threads pro Kachel-Block
+#define MS_TILE 128
+#define MS_MIN_TILE 8
+#define MS_THREADS 256
+
+/**
+ * @brief Liefert das i-te Randpixel einer w x h Kachel (oben, unten, links, rechts).
  */
-__device__ int mandelbrot(double real, double imag, int max_iter)
+__device__ void msBorderPixel(int i, int w, int h, int &px, int &py)
 {
-    double z_real = 0.0, z_imag = 0.0;
-    int iter = 0;
-    while (z_real * z_real + z_imag * z_imag <= 4.0 && iter < max_iter)
+    if (i < w)
+    {
+        px = i;
+        py = 0;
+    }
+    else if (i < 2 * w)
+    {
+        px = i - w;
+        py = h - 1;
+    }
+    else if (i < 2 * w + h - 2)
     {
-        double temp = z_real * z_real - z_imag * z_imag + real;
-        z_imag = 2.0 * z_real * z_imag + imag;
-        z_real = temp;
-        iter++;
+        px = 0;
+        py = 1 + i - 2 * w;
+    }
+    else
+    {
+        px = w - 1;
+        py = 1 + i - (2 * w + h - 2);
     }
-    return iter;
 }
 
 /**
- * @brief Konvertiert einen Farbwert in RGB. Schreibt die RGB-Werte in die übergebenen Referenzen.
- * 
- * @param color 
- * @param r 
- * @param g 
- * @param b 
+ * @brief Ein Mariani-Silver-Durchlauf. Ein Block pro Kachel der Kantenlänge tileSize; nur Kacheln mit
+ * pending != 0 arbeiten. Der Block rechnet die noch unbekannten (-1) Randpixel. Ist der Rand einheitlich,
+ * wird das Innere gefüllt, sonst werden die vier Teilkacheln für den nächsten Durchlauf markiert. Was
+ * nach dem letzten Durchlauf noch -1 ist, rechnet renderRemaining() pro Pixel.
+ *
+ * @param iters Iterationen pro Pixel, -1 für noch nicht berechnet
+ * @param pending Markierung pro Kachel dieses Durchlaufs
+ * @param pendingNext Markierung pro Kachel des nächsten Durchlaufs (halbe Kantenlänge)
+ * @param tileSize
+ * @param tilesX Kacheln pro Zeile in diesem Durchlauf
+ * @param lastPass true im Durchlauf mit der kleinsten Kachel
+ * @param f
+ * @param opts
  * @return void
  */
-__device__ void valueToRGB(int color, uint8_t &r, uint8_t &g, uint8_t &b)
+__global__ void msTilePass(int *iters, const uint8_t *pending, uint8_t *pendingNext, int tileSize, int tilesX, bool lastPass,
+                           FrameParams f, RenderOptions opts)
 {
+    int WIDTH = f.WIDTH;
+    int HEIGHT = f.HEIGHT;
+
+    int tile = blockIdx.x;
+    if (!pending[tile])
+        return;
 
-    double h = (color % 360) / 360.0;
-    double s = 0.8;
-    double v = 1.0;
+    int tx = tile % tilesX;
+    int ty = tile / tilesX;
+    int x0 = tx * tileSize;
+    int y0 = ty * tileSize;
+    int w = min(tileSize, WIDTH - x0);
+    int h = min(tileSize, HEIGHT - y0);
+    int perimeter = (w < 2 || h < 2) ? w * h : 2 * w + 2 * (h - 2);
 
-    if (color <= 0)
+    __shared__ int minIter, maxIter;
+    if (threadIdx.x == 0)
     {
-        r = g = b = 0;
-        return;
+        minIter = INT_MAX;
+        maxIter = -1;
     }
+    __syncthreads();
+
+    for (int i = threadIdx.x; i < perimeter; i += blockDim.x)
+    {
+        int px, py;
+        msBorderPixel(i, w, h, px, py);
+        int x = x0 + px;
+        int y = y0 + py;
+        int idx = y * WIDTH + x;
 
-    int i = (int)(h * 6);
-    double f = h * 6 - i;
-    double p = v * (1 - s);
-    double q = v * (1 - f * s);
-    double t = v * (1 - (1 - f) * s);
+        int iter = iters[idx];
+        if (iter < 0)
+        {
+            iter = pixelIterations(f, opts, x, y);
+            iters[idx] = iter;
+        }
+        atomicMin(&minIter, iter);
+        atomicMax(&maxIter, iter);
+    }
+    __syncthreads();
 
-    switch (i % 6)
+    if (minIter == maxIter)
     {
-    case 0:
-        r = (uint8_t)(v * 255);
-        g = (uint8_t)(t * 255);
-        b = (uint8_t)(p * 255);
-        break;
-    case 1:
-        r = (uint8_t)(q * 255);
-        g = (uint8_t)(v * 255);
-        b = (uint8_t)(p * 255);
-        break;
-    case 2:
-        r = (uint8_t)(p * 255);
-        g = (uint8_t)(v * 255);
-        b = (uint8_t)(t * 255);
-        break;
-    case 3:
-        r = (uint8_t)(p * 255);
-        g = (uint8_t)(q * 255);
-        b = (uint8_t)(v * 255);
-        break;
-    case 4:
-        r = (uint8_t)(t * 255);
-        g = (uint8_t)(p * 255);
-        b = (uint8_t)(v * 255);
-        break;
-    case 5:
-        r = (uint8_t)(v * 255);
-        g = (uint8_t)(p * 255);
-        b = (uint8_t)(q * 255);
-        break;
+        int innerW = w - 2;
+        int innerH = h - 2;
+        for (int i = threadIdx.x; i < innerW * innerH; i += blockDim.x)
+        {
+            int x = x0 + 1 + i % innerW;
+            int y = y0 + 1 + i / innerW;
+            iters[y * WIDTH + x] = minIter;
+        }
+    }
+    else if (!lastPass && threadIdx.x < 4)
+    {
+        int half = tileSize / 2;
+        int tilesXNext = (WIDTH + half - 1) / half;
+        int cx = 2 * tx + (threadIdx.x & 1);
+        int cy = 2 * ty + (threadIdx.x >> 1);
+        if (cx * half < WIDTH && cy * half < HEIGHT)
+            pendingNext[cy * tilesXNext + cx] = 1;
     }
 }
 
 /**
- * @brief Render-Funktion für das Mandelbrot. Diese Funktion wird auf der GPU ausgeführt daher __global__.
- * Die Funktion berechnet die Mandelbrot-Menge für jeden Pixel im Bild und speichert die RGB-Werte in das Bild-Array.
- * 
- * @param image 
- * @param scale 
- * @param centerX 
- * @param centerY 
- * @param WIDTH 
- * @param HEIGHT 
- * @return void
+ * @brief Rechnet alle Pixel, die nach den Mariani-Silver-Durchläufen noch -1 sind.
+ */
+__global__ void renderRemaining(int *iters, FrameParams f, RenderOptions opts)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= f.WIDTH || y >= f.HEIGHT)
+        return;
+
+    int idx = y * f.WIDTH + x;
+    if (iters[idx] >= 0)
+        return;
+
+    iters[idx] = pixelIterations(f, opts, x, y);
+}
+
+/**
+ * @brief Färbt ein Bild anhand seiner Iterationen ein, wie render() es pro Pixel tut. Dient auch zum
+ * Neufärben eines fertigen Bildes mit anderen Farben; mit smooth und colors.smooth stufenlos, mit cdf
+ * (histogramCdf()) nach dem Histogrammausgleich.
  */
-__global__ void render(uint8_t *image, double scale, double centerX, double centerY, int WIDTH, int HEIGHT)
+__global__ void colorize(uint8_t *image, const int *iters, const float *smooth, int WIDTH, int HEIGHT, int MAX_ITER, ColorOptions colors,
+                         const float *cdf)
 {
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     if (x >= WIDTH || y >= HEIGHT)
         return;
 
-    double real = (x - WIDTH / 2.0) * scale + centerX;
-    double imag = (HEIGHT / 2.0 - y) * scale + centerY;
+    int idx = y * WIDTH + x;
+    uint8_t r, g, b;
+    if (cdf != NULL)
+        colorToRGB(histogramToColor(smooth != NULL && colors.smooth ? smooth[idx] : (float)iters[idx], cdf, MAX_ITER), colors, r, g, b);
+    else if (smooth != NULL && colors.smooth)
+        smoothToRGB(smooth[idx], MAX_ITER, colors, r, g, b);
+    else
+        iterToRGB(iters[idx], MAX_ITER, colors, r, g, b);
 
-    const double INITIAL_SCALE_AT_ZOOM_1 = 4.0 / WIDTH;
+    image[3 * idx + 0] = r;
+    image[3 * idx + 1] = g;
+    image[3 * idx + 2] = b;
+}
 
-    int MAX_ITER = 256;
-    if (scale > 0)
+/**
+ * @brief Verschiebt die Iterationen eines Bildes: dst(x, y) = src(x + shiftX, y + shiftY), Pixel ohne
+ * Quelle werden -1 und danach von renderRemaining() gerechnet.
+ */
+__global__ void shiftIterations(int *dst, const int *src, int WIDTH, int HEIGHT, int shiftX, int shiftY)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= WIDTH || y >= HEIGHT)
+        return;
+
+    int sx = x + shiftX;
+    int sy = y + shiftY;
+    bool inside = sx >= 0 && sx < WIDTH && sy >= 0 && sy < HEIGHT;
+    dst[y * WIDTH + x] = inside ? src[sy * WIDTH + sx] : -1;
+}
+
+/**
+ * @brief Ein Durchlauf des progressiven Renderns: rechnet die Pixel, deren Koordinaten Vielfache von
+ * step sind. Außer im ersten Durchlauf liegen die Vielfachen von 2 * step schon aus dem vorigen vor.
+ * Ein Thread pro Pixel des ceil(WIDTH / step) x ceil(HEIGHT / step) großen Rasters.
+ */
+__global__ void renderPass(int *iters, FrameParams f, RenderOptions opts, int step, bool first)
+{
+    int x = (blockIdx.x * blockDim.x + threadIdx.x) * step;
+    int y = (blockIdx.y * blockDim.y + threadIdx.y) * step;
+    if (x >= f.WIDTH || y >= f.HEIGHT)
+        return;
+    if (!first && x % (2 * step) == 0 && y % (2 * step) == 0)
+        return;
+
+    iters[y * f.WIDTH + x] = pixelIterations(f, opts, x, y);
+}
+
+/**
+ * @brief Färbt die Pixel eines Durchlaufs von renderPass() als Vorschaubild ein, ein Pixel pro
+ * Vielfachem von step; image hat ceil(WIDTH / step) x ceil(HEIGHT / step) Pixel. cdf wie bei colorize().
+ */
+__global__ void colorizePass(uint8_t *image, const int *iters, int WIDTH, int HEIGHT, int step, int MAX_ITER, ColorOptions colors,
+                             const float *cdf)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int w = (WIDTH + step - 1) / step;
+    if (x >= w || y * step >= HEIGHT)
+        return;
+
+    int idx = y * w + x;
+    int iter = iters[y * step * WIDTH + x * step];
+    uint8_t r, g, b;
+    if (cdf != NULL)
+        colorToRGB(histogramToColor((float)iter, cdf, MAX_ITER), colors, r, g, b);
+    else
+        iterToRGB(iter, MAX_ITER, colors, r, g, b);
+
+    image[3 * idx + 0] = r;
+    image[3 * idx + 1] = g;
+    image[3 * idx + 2] = b;
+}
+
+// Threads pro Block und höchstens so viele Blöcke für histogramKernel()
+#define HISTOGRAM_THREADS 256
+#define HISTOGRAM_BLOCKS 256
+
+/**
+ * @brief Erster Durchlauf des Histogrammausgleichs: jeder Block zählt seinen Teil der Pixel in ein
+ * eigenes Histogramm im Shared Memory (MAX_ITER Bins, höchstens 32 KB) und addiert es zum Schluss auf
+ * counts. Die atomaren Additionen pro Pixel bleiben so im Shared Memory, im globalen Speicher kommt nur
+ * eine pro Bin und Block an. Gezählt werden die Pixel j * step, i * step eines WIDTH breiten Bildes,
+ * w x h Stück.
+ */
+__global__ void histogramKernel(unsigned int *counts, const int *iters, int WIDTH, int w, int h, int step, int MAX_ITER)
+{
+    extern __shared__ unsigned int local[];
+    for (int i = threadIdx.x; i < MAX_ITER; i += blockDim.x)
+        local[i] = 0;
+    __syncthreads();
+
+    long long count = (long long)w * h;
+    for (long long i = blockIdx.x * blockDim.x + threadIdx.x; i < count; i += (long long)gridDim.x * blockDim.x) {
+        int iter = iters[(i / w) * step * WIDTH + (i % w) * step];
+        // Punkte der Menge (MAX_ITER) bleiben schwarz und zählen nicht
+        if ((unsigned int)iter < (unsigned int)MAX_ITER)
+            atomicAdd(&local[iter], 1u);
+    }
+    __syncthreads();
+
+    for (int i = threadIdx.x; i < MAX_ITER; i += blockDim.x)
+        if (local[i] > 0)
+            atomicAdd(&counts[i], local[i]);
+}
+
+/**
+ * @brief Puffer für histogramCdf(), wachsen mit MAX_ITER.
+ */
+struct HistogramBuffers
+{
+    unsigned int *d_counts;
+    float *d_cdf;
+    unsigned int *h_counts;
+    float *h_cdf;
+    int capacity;
+};
+
+/**
+ * @brief Verteilung der Iterationen für colors.histogram: histogramKernel() zählt auf der GPU, der Host
+ * kumuliert die MAX_ITER Bins (histogramToCdf()) und lädt das Ergebnis wieder hoch. Pixel wie bei
+ * histogramKernel().
+ *
+ * @return Verteilung auf der GPU für colorize(), NULL bei fehlendem Speicher
+ */
+const float *histogramCdf(HistogramBuffers &hist, const int *d_iters, int WIDTH, int w, int h, int step, int MAX_ITER)
+{
+    if (MAX_ITER > hist.capacity) {
+        cudaFree(hist.d_counts);
+        cudaFree(hist.d_cdf);
+        free(hist.h_counts);
+        free(hist.h_cdf);
+        hist.capacity = 0;
+        hist.h_counts = (unsigned int *)malloc(sizeof(unsigned int) * MAX_ITER);
+        hist.h_cdf = (float *)malloc(sizeof(float) * (MAX_ITER + 1));
+        if (cudaMalloc(&hist.d_counts, sizeof(unsigned int) * MAX_ITER) != cudaSuccess ||
+            cudaMalloc(&hist.d_cdf, sizeof(float) * (MAX_ITER + 1)) != cudaSuccess || hist.h_counts == NULL || hist.h_cdf == NULL)
+            return NULL;
+        hist.capacity = MAX_ITER;
+    }
+
+    cudaMemset(hist.d_counts, 0, sizeof(unsigned int) * MAX_ITER);
+    long long needed = ((long long)w * h + HISTOGRAM_THREADS - 1) / HISTOGRAM_THREADS;
+    int blocks = needed < HISTOGRAM_BLOCKS ? (int)needed : HISTOGRAM_BLOCKS;
+    histogramKernel<<<blocks, HISTOGRAM_THREADS, sizeof(unsigned int) * MAX_ITER>>>(hist.d_counts, d_iters, WIDTH, w, h, step, MAX_ITER);
+    cudaMemcpy(hist.h_counts, hist.d_counts, sizeof(unsigned int) * MAX_ITER, cudaMemcpyDeviceToHost);
+    histogramToCdf(hist.h_counts, hist.h_cdf, MAX_ITER);
+    cudaMemcpy(hist.d_cdf, hist.h_cdf, sizeof(float) * (MAX_ITER + 1), cudaMemcpyHostToDevice);
+    return hist.d_cdf;
+}
+
+/**
+ * @brief Größe eines Markierungspuffers für renderMarianiSilver(): eine Markierung pro kleinster Kachel.
+ */
+size_t msPendingSize(int WIDTH, int HEIGHT)
+{
+    return (size_t)((WIDTH + MS_MIN_TILE - 1) / MS_MIN_TILE) * ((HEIGHT + MS_MIN_TILE - 1) / MS_MIN_TILE);
+}
+
+/**
+ * @brief cudaMalloc(), das bei fehlendem Speicher NULL hinterlässt. Der Fehler wird zurückgesetzt, damit
+ * er nicht an der nächsten Anfrage hängen bleibt.
+ */
+template <typename T>
+bool deviceAlloc(T **ptr, size_t bytes)
+{
+    if (cudaMalloc(ptr, bytes) == cudaSuccess)
+        return true;
+    cudaGetLastError();
+    *ptr = NULL;
+    return false;
+}
+
+/**
+ * @brief Legt die Markierungspuffer für renderMarianiSilver() beim ersten Gebrauch an.
+ *
+ * @return false bei fehlendem Speicher, das Bild wird dann ohne Mariani-Silver gerechnet
+ */
+bool allocPending(uint8_t *d_pending[2], int WIDTH, int HEIGHT)
+{
+    if (d_pending[1] != NULL)
+        return true;
+    cudaFree(d_pending[0]);
+    return deviceAlloc(&d_pending[0], msPendingSize(WIDTH, HEIGHT)) && deviceAlloc(&d_pending[1], msPendingSize(WIDTH, HEIGHT));
+}
+
+/**
+ * @brief Mariani-Silver-Variante von render(): mehrere Kachel-Durchläufe von MS_TILE bis MS_MIN_TILE,
+ * dann die restlichen Pixel einzeln und zum Schluss das Einfärben.
+ *
+ * @param d_image RGB-Ausgabe auf der GPU
+ * @param d_iters Iterationspuffer mit WIDTH * HEIGHT Einträgen
+ * @param d_pending zwei Markierungspuffer, je msPendingSize(WIDTH, HEIGHT) Bytes
+ * @param cancel wird nach jedem Durchlauf geprüft
+ * @return false, wenn das Bild wegen cancel unvollständig ist
+ */
+bool renderMarianiSilver(uint8_t *d_image, int *d_iters, uint8_t *d_pending[2], const FrameParams &f, RenderOptions opts,
+                         ColorOptions colors, dim3 grid, dim3 block, const std::atomic<bool> &cancel)
+{
+    int WIDTH = f.WIDTH;
+    int HEIGHT = f.HEIGHT;
+    int tileSize = MS_TILE;
+    int tilesX = (WIDTH + tileSize - 1) / tileSize;
+    int tilesY = (HEIGHT + tileSize - 1) / tileSize;
+
+    cudaMemset(d_iters, 0xFF, (size_t)WIDTH * HEIGHT * sizeof(int));
+    cudaMemset(d_pending[0], 1, (size_t)tilesX * tilesY);
+
+    int cur = 0;
+    while (true)
     {
+        bool lastPass = tileSize / 2 < MS_MIN_TILE;
+        int half = tileSize / 2;
+        if (!lastPass)
+            cudaMemset(d_pending[1 - cur], 0, (size_t)((WIDTH + half - 1) / half) * ((HEIGHT + half - 1) / half));
 
-        MAX_ITER += (int)(log(INITIAL_SCALE_AT_ZOOM_1 / scale) * 50.0);
+        msTilePass<<<tilesX * tilesY, MS_THREADS>>>(d_iters, d_pending[cur], d_pending[1 - cur], tileSize, tilesX, lastPass,
+                                                     f, opts);
+        if (lastPass)
+            break;
+
+        cudaDeviceSynchronize();
+        if (cancel)
+            return false;
 
-        if (MAX_ITER < 100)
-            MAX_ITER = 100;
-        if (MAX_ITER > 8192)
-            MAX_ITER = 8192;
+        cur = 1 - cur;
+        tileSize = half;
+        tilesX = (WIDTH + tileSize - 1) / tileSize;
+        tilesY = (HEIGHT + tileSize - 1) / tileSize;
     }
 
-    int iter = mandelbrot(real, imag, MAX_ITER);
-    int idx = 3 * (y * WIDTH + x);
+    cudaDeviceSynchronize();
+    if (cancel)
+        return false;
 
-    uint8_t color = 0;
+    renderRemaining<<<grid, block>>>(d_iters, f, opts);
+    colorize<<<grid, block>>>(d_image, d_iters, NULL, WIDTH, HEIGHT, f.MAX_ITER, colors, NULL);
+    return true;
+}
 
-    if (iter < MAX_ITER)
+/**
+ * @brief Progressives Rendern (REQUEST_FLAG_PROGRESSIVE): Durchläufe mit Schrittweite 8, 4 und 2, nach
+ * jedem geht ein Vorschaubild mit Kopf hinaus; der letzte Durchlauf rechnet die übrigen Pixel und färbt
+ * das ganze Bild in d_image ein, das dann wie gewohnt gesendet wird. Jeder Durchlauf übernimmt die
+ * Pixel der vorigen.
+ *
+ * @param d_image RGB-Ausgabe auf der GPU, nimmt vorher auch die Vorschaubilder auf
+ * @param d_iters Iterationspuffer mit WIDTH * HEIGHT Einträgen
+ * @param hist mit req.colors.histogram für die Vorschauen, jede nach ihren eigenen Pixeln
+ * @param h_image Hostpuffer für die Vorschaubilder, NULL mit shared
+ * @param f
+ * @param req
+ * @param res Kopf des fertigen Bildes, Vorlage für die Vorschauen
+ * @param opts
+ * @param block
+ * @param cancel wird nach jedem Durchlauf geprüft
+ * @param shared wenn nicht NULL: Vorschauen über die gemeinsame Datei
+ * @param start Ereignis am Anfang des Bildes, für die Zeit bis zur Vorschau
+ * @param stop freies Ereignis für die Zeitmessung
+ * @return false, wenn das Bild wegen cancel unvollständig ist
+ */
+bool renderProgressive(uint8_t *d_image, int *d_iters, HistogramBuffers &hist, uint8_t *h_image, const FrameParams &f, const FrameRequest &req,
+                       const FrameResponse &res, RenderOptions opts, dim3 block, const std::atomic<bool> &cancel,
+                       SharedFrames *shared, cudaEvent_t start, cudaEvent_t stop)
+{
+    // Ohne Slot für eine Vorschau fehlen nur die Vorschauen, gerechnet wird trotzdem
+    bool previews = true;
+    int pass = 0;
+    for (int step = PROGRESSIVE_FIRST_STEP; step > 1; step /= 2, pass++)
     {
-        double normalized_iter = (double)iter / (double)MAX_ITER;
-        color = (uint8_t)(sqrt(normalized_iter) * 255.0);
+        int w = (f.WIDTH + step - 1) / step;
+        int h = (f.HEIGHT + step - 1) / step;
+        dim3 grid((w + block.x - 1) / block.x, (h + block.y - 1) / block.y);
+        renderPass<<<grid, block>>>(d_iters, f, opts, step, step == PROGRESSIVE_FIRST_STEP);
+        if (!previews)
+            continue;
+        const float *cdf = req.colors.histogram ? histogramCdf(hist, d_iters, f.WIDTH, w, h, step, f.MAX_ITER) : NULL;
+        colorizePass<<<grid, block>>>(d_image, d_iters, f.WIDTH, f.HEIGHT, step, f.MAX_ITER, req.colors, cdf);
+        cudaDeviceSynchronize();
+        if (cancel)
+            return false;
+
+        FrameResponse passRes = res;
+        passRes.WIDTH = w;
+        passRes.HEIGHT = h;
+        passRes.byteLength = (size_t)w * h * 3;
+        passRes.pass = pass;
+        passRes.passes = PROGRESSIVE_PASSES;
+
+        int slot = -1;
+        uint8_t *image = h_image;
+        if (shared != NULL) {
+            image = beginSharedFrame(*shared, passRes.byteLength, slot);
+            if (image == NULL) {
+                previews = false;
+                continue;
+            }
+        }
+        cudaMemcpy(image, d_image, passRes.byteLength, cudaMemcpyDeviceToHost);
+
+        float milliseconds = 0.0f;
+        cudaEventRecord(stop);
+        cudaEventSynchronize(stop);
+        cudaEventElapsedTime(&milliseconds, start, stop);
+        passRes.renderMs = milliseconds;
+
+        if (shared != NULL)
+            publishSharedFrame(*shared, slot, passRes);
+        writeResponseHeader(stdout, passRes);
+        if (shared == NULL)
+            fwrite(image, 1, passRes.byteLength, stdout);
+        fflush(stdout);
+
+        fprintf(stderr, "Pass %d: 1/%d resolution after %.3f ms\n", pass, step, passRes.renderMs);
+        fflush(stderr);
     }
 
-    uint8_t r, g, b;
-    valueToRGB(color, r, g, b);
+    dim3 grid((f.WIDTH + block.x - 1) / block.x, (f.HEIGHT + block.y - 1) / block.y);
+    renderPass<<<grid, block>>>(d_iters, f, opts, 1, false);
+    cudaDeviceSynchronize();
+    if (cancel)
+        return false;
+    colorize<<<grid, block>>>(d_image, d_iters, NULL, f.WIDTH, f.HEIGHT, f.MAX_ITER, req.colors, NULL);
+    return true;
+}
 
-    image[idx + 0] = r;
-    image[idx + 1] = g;
-    image[idx + 2] = b;
+/**
+ * @brief Gekachelter Modus: Kachel für Kachel rendern und an out geben, ohne das ganze Bild auf GPU
+ * oder Host zu halten. Zwei Kachelpuffer und Streams wechseln sich ab: während die GPU eine Kachel
+ * rechnet, schreibt der Host die vorige.
+ *
+ * @param out aus openTileWriter()
+ * @param f Bildparameter, Referenzorbit im Device-Speicher
+ * @param opts
+ * @param colors
+ * @return false bei fehlendem Speicher oder Schreibfehler
+ */
+bool renderTiled(TileWriter &out, const FrameParams &f, RenderOptions opts, ColorOptions colors)
+{
+    int tileSize = out.tileSize;
+    size_t tileBytes = (size_t)tileSize * tileSize * 3;
+    int tilesX = (f.WIDTH + tileSize - 1) / tileSize;
+    int tilesY = (f.HEIGHT + tileSize - 1) / tileSize;
+
+    uint8_t *d_tile[2] = {NULL, NULL};
+    uint8_t *h_tile[2] = {NULL, NULL};
+    cudaStream_t streams[2];
+    cudaStreamCreate(&streams[0]);
+    cudaStreamCreate(&streams[1]);
+    for (int i = 0; i < 2; i++) {
+        cudaMalloc(&d_tile[i], tileBytes);
+        cudaMallocHost(&h_tile[i], tileBytes);
+    }
+
+    // Kachel, die gerade in Puffer i steckt, -1 für keine
+    int inFlight[2] = {-1, -1};
+    bool ok = cudaGetLastError() == cudaSuccess;
+
+    dim3 block(16, 16);
+    dim3 grid((tileSize + block.x - 1) / block.x, (tileSize + block.y - 1) / block.y);
 
+    for (int t = 0; ok && t <= tilesX * tilesY; t++) {
+        // Erst die Kachel von vor zwei Schritten abholen, die den Puffer noch belegt
+        int slot = t % 2;
+        int done = inFlight[slot];
+        if (done >= 0) {
+            cudaStreamSynchronize(streams[slot]);
+            int tileX = (done % tilesX) * tileSize;
+            int tileY = (done / tilesX) * tileSize;
+            int w = min(tileSize, f.WIDTH - tileX);
+            int h = min(tileSize, f.HEIGHT - tileY);
+            ok = writeTile(out, h_tile[slot], tileX, tileY, w, h);
+            if (ok && tileX + w == f.WIDTH)
+                ok = finishTileRow(out, tileY);
+            inFlight[slot] = -1;
+        }
+
+        if (t == tilesX * tilesY) {
+            // Letzte Runde: nur noch die Kachel im anderen Puffer abholen
+            slot = 1 - slot;
+            done = inFlight[slot];
+            if (ok && done >= 0) {
+                cudaStreamSynchronize(streams[slot]);
+                int tileX = (done % tilesX) * tileSize;
+                int tileY = (done / tilesX) * tileSize;
+                int w = min(tileSize, f.WIDTH - tileX);
+                int h = min(tileSize, f.HEIGHT - tileY);
+                ok = writeTile(out, h_tile[slot], tileX, tileY, w, h) && finishTileRow(out, tileY);
+            }
+            break;
+        }
+
+        int tileX = (t % tilesX) * tileSize;
+        int tileY = (t / tilesX) * tileSize;
+        int w = min(tileSize, f.WIDTH - tileX);
+        int h = min(tileSize, f.HEIGHT - tileY);
+        render<<<grid, block, 0, streams[slot]>>>(d_tile[slot], NULL, NULL, f, opts, colors, tileX, tileY, w, h);
+        cudaMemcpyAsync(h_tile[slot], d_tile[slot], (size_t)w * h * 3, cudaMemcpyDeviceToHost, streams[slot]);
+        inFlight[slot] = t;
+    }
+
+    cudaDeviceSynchronize();
+    for (int i = 0; i < 2; i++) {
+        cudaFree(d_tile[i]);
+        cudaFreeHost(h_tile[i]);
+        cudaStreamDestroy(streams[i]);
+    }
+    return ok && cudaGetLastError() == cudaSuccess;
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    if (answerProtocolVersion(argc, argv))
+        return 0;
+
+    RenderOptions opts;
+    // Die Zykluserkennung ist hier standardmäßig aus (--periodicity-check schaltet sie ein). Die CPU-Pfade
+    // prüfen nur nach einem Block mit innerem Pixel; auf der GPU rechnen alle Pixel eines Warps gleichzeitig,
+    // dort zahlt jeder entkommende Orbit die Vergleiche und das Register für den gemerkten Punkt
+    opts.periodicityCheck = false;
+    // Nur gekachelter Modus, siehe OpenMP-Backend
+    int tileSize = 0;
+    const char *outputPath = NULL;
+    bool textProtocol = false;
+    bool coalesce = true;
+    const char *sharedPath = NULL;
+    const char *palettePath = NULL;
+    int tileCacheMb = TILE_CACHE_DEFAULT_MB;
+    const char *tileCacheDir = NULL;
+
+#ifdef _WIN32
+    // Sonst wandelt die C-Laufzeit 0x0A im Bild und in Binäranfragen in \r\n um
+    _setmode(_fileno(stdout), _O_BINARY);
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--no-interior-check") == 0)
+        {
+            opts.interiorCheck = false;
+        }
+        else if (strcmp(argv[i], "--mariani-silver") == 0)
+        {
+            opts.marianiSilver = true;
+        }
+        else if (strcmp(argv[i], "--periodicity-check") == 0)
+        {
+            opts.periodicityCheck = true;
+        }
+        else if (strcmp(argv[i], "--no-periodicity-check") == 0)
+        {
+            opts.periodicityCheck = false;
+        }
+        else if (strcmp(argv[i], "--periodicity-tolerance") == 0 && i + 1 < argc)
+        {
+            opts.periodicityTolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--no-bla") == 0)
+        {
+            opts.bla = false;
+        }
+        else if (strcmp(argv[i], "--no-pan-cache") == 0)
+        {
+            opts.panCache = false;
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc)
+        {
+            if (!parsePrecision(argv[++i], opts.precision))
+            {
+                fprintf(stderr, "Unknown precision: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--tile-cache") == 0 && i + 1 < argc)
+        {
+            tileCacheMb = atoi(argv[++i]);
+            if (tileCacheMb < 0)
+            {
+                fprintf(stderr, "Invalid tile cache size: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--tile-cache-dir") == 0 && i + 1 < argc)
+        {
+            tileCacheDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc)
+        {
+            tileSize = atoi(argv[++i]);
+            if (tileSize < 16)
+            {
+                fprintf(stderr, "Invalid tile size: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-coalesce") == 0)
+        {
+            coalesce = false;
+        }
+        else if (strcmp(argv[i], "--shared-memory") == 0 && i + 1 < argc)
+        {
+            sharedPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--palette") == 0 && i + 1 < argc)
+        {
+            palettePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--protocol") == 0 && i + 1 < argc)
+        {
+            const char *kind = argv[++i];
+            if (strcmp(kind, "text") == 0)
+            {
+                textProtocol = true;
+            }
+            else if (strcmp(kind, "binary") == 0)
+            {
+                textProtocol = false;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown protocol: %s\n", kind);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // Slot und Sequenz kann nur der Kopf des Binärprotokolls melden
+    if (sharedPath != NULL && (textProtocol || outputPath != NULL)) {
+        fprintf(stderr, "--shared-memory needs the binary protocol and no --output\n");
+        return 1;
+    }
+    Gradient gradient;
+    PaletteCache palettes = {};
+    if (palettePath != NULL) {
+        if (!loadGradient(palettePath, gradient))
+            return 1;
+        palettes.gradient = &gradient;
+    }
+
     fprintf(stderr, "CUDA Backend started\n");
     fflush(stderr);
 
-    char line[256];
-    
     cudaEvent_t start, stop;
     cudaEventCreate(&start);
     cudaEventCreate(&stop);
@@ -159,47 +823,165 @@ int main()
     uint8_t *h_image = NULL;
     size_t currentImageSize = 0;
 
-    while (fgets(line, sizeof(line), stdin))
+    // Iterationen des letzten ungekachelten Bildes, zum Neufärben und Verschieben ohne Rechnen;
+    // beim Verschieben wird in den zweiten Puffer kopiert und getauscht
+    int *d_iters = NULL;
+    int *d_itersSpare = NULL;
+    // Glatte Iterationsanzahlen des letzten Bildes mit COLOR_FLAG_SMOOTH
+    float *d_smooth = NULL;
+    size_t smoothPixels = 0;
+    FrameCache cache = {};
+    // Kachelcache auf dem Host, siehe TileCache.h; h_iters ist der Umweg für die Iterationen
+    TileCache tiles;
+    int *h_iters = NULL;
+    // Nur im Mariani-Silver-Modus
+    uint8_t *d_pending[2] = {NULL, NULL};
+
+    // Nur bei Störungsrechnung: Referenzorbit auf Host und GPU
+    ReferenceOrbit orbit = {NULL, NULL, 0, 0};
+    double *d_refReal = NULL;
+    double *d_refImag = NULL;
+    int d_refCapacity = 0;
+    BlaTable bla = {NULL, 0, 0, {0}};
+    BlaStep *d_bla = NULL;
+    int d_blaCapacity = 0;
+
+    // Farbtabelle, nur bei neuen Farben hochgeladen. Im globalen Speicher (24 KB, bleibt im Cache)
+    // statt im Konstantenspeicher, der verschiedene Adressen innerhalb eines Warps nacheinander bedient
+    Palette *d_palette = NULL;
+    cudaMalloc(&d_palette, sizeof(Palette));
+    // Nur mit COLOR_FLAG_HISTOGRAM
+    HistogramBuffers hist = {NULL, NULL, NULL, NULL, 0};
+
+    SharedFrames shared = {};
+    if (sharedPath != NULL && !openSharedFrames(shared, sharedPath)) {
+        fprintf(stderr, "Cannot create shared frame file %s\n", sharedPath);
+        return 1;
+    }
+    if (!openTileCache(tiles, tileCacheMb, tileCacheDir, opts, "cuda"))
+        fprintf(stderr, "Out of memory for a %d MB tile cache, running without\n", tileCacheMb);
+
+    // Liest stdin in einem eigenen Thread und verwirft veraltete Anfragen, siehe RequestQueue.h
+    RequestQueue queue;
+    startRequestReader(queue, textProtocol, coalesce);
+
+    while (true)
     {
-        int WIDTH;
-        int HEIGHT;
-        double zoom, centerX, centerY;
-        
-        if (sscanf(line, "%lf %lf %lf %d %d", &zoom, &centerX, &centerY, &WIDTH, &HEIGHT) != 5)
-        {
-            fprintf(stderr, "Invalid input: %s", line);
+        FrameRequest req;
+        long long dropped;
+        RequestResult result = nextRequest(queue, req, dropped);
+        if (dropped > 0) {
+            fprintf(stderr, "Skipped %lld stale requests\n", dropped);
             fflush(stderr);
+        }
+        if (result == REQUEST_END)
+            break;
+
+        FrameResponse res = {req.requestId, req.pixelFormat, req.WIDTH, req.HEIGHT, PRECISION_AUTO, RESPONSE_INVALID_REQUEST, 0.0, 0, -1, 0, 0, 0, 1};
+        if (result == REQUEST_INVALID) {
+            // Im Textprotokoll gibt es keine Antwort ohne Bild
+            if (!textProtocol) {
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
             continue;
         }
         
+        if (updatePalette(palettes, req.colors))
+            cudaMemcpy(d_palette, &palettes.palette, sizeof(Palette), cudaMemcpyHostToDevice);
+        req.colors.palette = d_palette;
+
+        bool recolor = (req.flags & REQUEST_FLAG_RECOLOR) != 0;
+        if (recolor) {
+            if (!cache.valid) {
+                fprintf(stderr, "Received #%u: recolor, but there is no frame to recolor\n", req.requestId);
+                fflush(stderr);
+                res.status = RESPONSE_FAILED;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+                continue;
+            }
+            // Format der Antwort ist das des gespeicherten Bildes
+            req.WIDTH = res.WIDTH = cache.frame.WIDTH;
+            req.HEIGHT = res.HEIGHT = cache.frame.HEIGHT;
+        }
+
+        int WIDTH = req.WIDTH;
+        int HEIGHT = req.HEIGHT;
         size_t newImageSize = (size_t)WIDTH * HEIGHT * 3;
+        bool tiled = !recolor && (tileSize > 0 || (long long)newImageSize > TILE_FRAME_LIMIT);
+        if (tiled)
+            dropTiledColorFlags(req);
+        // Gestreamte Kacheln gehen weiter durch die Pipe
+        bool useShared = sharedPath != NULL && !tiled;
 
-        // Speicher nur neu zuweisen, wenn die Größe sich ändert
-        if (newImageSize != currentImageSize) {
-            if (d_image) {
-                cudaFree(d_image);
-                d_image = NULL;
-            }
-            if (h_image) {
-                free(h_image);
-                h_image = NULL;
-            }
-            cudaMalloc(&d_image, newImageSize);
-            h_image = (uint8_t *)malloc(newImageSize);
-            
-            if (h_image == NULL) {
-                if (d_image) cudaFree(d_image);
-                cudaEventDestroy(start);
-                cudaEventDestroy(stop);
-                return 1; 
-            }
-            if (cudaGetLastError() != cudaSuccess) {
-                if (h_image) free(h_image);
-                cudaEventDestroy(start);
-                cudaEventDestroy(stop);
-                return 1;
+        FILE *out = stdout;
+        if (outputPath != NULL) {
+            out = fopen(outputPath, "wb");
+            if (out == NULL) {
+                fprintf(stderr, "Cannot open output file %s\n", outputPath);
+                fflush(stderr);
+                if (!textProtocol) {
+                    res.status = RESPONSE_FAILED;
+                    writeResponseHeader(stdout, res);
+                    fflush(stdout);
+                }
+                continue;
             }
-            currentImageSize = newImageSize;
+        }
+
+        // Speicher nur neu zuweisen, wenn die Größe sich ändert. Was nur einzelne Anfragen brauchen (glatte
+        // Iterationen, Verschieben, Kachelcache, Mariani-Silver), kommt erst mit der ersten solchen Anfrage
+        size_t pixels = (size_t)WIDTH * HEIGHT;
+        bool allocated = true;
+        if (!tiled && newImageSize != currentImageSize) {
+            cudaFree(d_image);
+            free(h_image);
+            cudaFree(d_iters);
+            cudaFree(d_itersSpare);
+            free(h_iters);
+            cudaFree(d_pending[0]);
+            cudaFree(d_pending[1]);
+            d_image = NULL;
+            h_image = NULL;
+            d_iters = NULL;
+            d_itersSpare = NULL;
+            h_iters = NULL;
+            d_pending[0] = d_pending[1] = NULL;
+            // Die Iterationen des letzten Bildes sind mit d_iters weg
+            cache.valid = false;
+            currentImageSize = 0;
+
+            allocated = deviceAlloc(&d_image, newImageSize) && deviceAlloc(&d_iters, pixels * sizeof(int));
+            // Mit --shared-memory wird direkt in den Slot kopiert
+            if (allocated && !useShared) {
+                h_image = (uint8_t *)malloc(newImageSize);
+                allocated = h_image != NULL;
+            }
+            if (allocated)
+                currentImageSize = newImageSize;
+        }
+        // Wie h_smooth im OpenMP-Backend nur für Bilder mit COLOR_FLAG_SMOOTH
+        bool smooth = !recolor && !tiled && req.colors.smooth;
+        if (allocated && smooth && pixels != smoothPixels) {
+            cudaFree(d_smooth);
+            smoothPixels = 0;
+            allocated = deviceAlloc(&d_smooth, pixels * sizeof(float));
+            if (allocated)
+                smoothPixels = pixels;
+        }
+        if (!allocated) {
+            // Nur diese Anfrage scheitert; ein kleineres Bild kann danach wieder gehen
+            fprintf(stderr, "Out of memory for %d x %d frame\n", WIDTH, HEIGHT);
+            fflush(stderr);
+            if (!textProtocol) {
+                res.status = RESPONSE_FAILED;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+            if (out != stdout)
+                fclose(out);
+            continue;
         }
 
         int blockSize = 16;
@@ -207,18 +989,150 @@ int main()
         dim3 block(blockSize, blockSize);
         dim3 grid((WIDTH + block.x - 1) / block.x, (HEIGHT + block.y - 1) / block.y);
 
-        fprintf(stderr, "Received: zoom=%.2f, centerX=%.2f, centerY=%.2f, WIDTH=%d, HEIGHT=%d\n", zoom, centerX, centerY, WIDTH, HEIGHT);
+        if (recolor)
+            fprintf(stderr, "Received #%u: recolor, hue=%g, saturation=%g, brightness=%g, exponent=%g\n", req.requestId,
+                    req.colors.hueOffset, req.colors.saturation, req.colors.brightness, req.colors.exponent);
+        else
+            fprintf(stderr, "Received #%u: zoom=%.2f, centerX=%.2f, centerY=%.2f, WIDTH=%d, HEIGHT=%d\n", req.requestId, req.zoom, req.centerX, req.centerY, WIDTH, HEIGHT);
         fflush(stderr);
 
-        double scale = 4.0 / (WIDTH * zoom);
-
-        // Timing START
+        // Timing START (inklusive Referenzorbit)
         cudaEventRecord(start);
         
-        cudaMemset(d_image, 0, newImageSize); 
+        if (!tiled && !recolor)
+            cudaMemset(d_image, 0, newImageSize);
+
+        FrameParams frame = cache.frame;
+        bool ready = recolor || prepareFrame(frame, req, opts, orbit, bla);
+
+        if (!recolor && ready && frame.precision == PRECISION_PERTURBATION) {
+            if (orbit.capacity > d_refCapacity) {
+                cudaFree(d_refReal);
+                cudaFree(d_refImag);
+                cudaMalloc(&d_refReal, sizeof(double) * orbit.capacity);
+                cudaMalloc(&d_refImag, sizeof(double) * orbit.capacity);
+                d_refCapacity = orbit.capacity;
+            }
+            cudaMemcpy(d_refReal, orbit.real, sizeof(double) * orbit.length, cudaMemcpyHostToDevice);
+            cudaMemcpy(d_refImag, orbit.imag, sizeof(double) * orbit.length, cudaMemcpyHostToDevice);
+            frame.refReal = d_refReal;
+            frame.refImag = d_refImag;
 
-        //Aufruf der Regderfunktion auf der GPU
-        render<<<grid, block>>>(d_image, scale, centerX, centerY, WIDTH, HEIGHT);
+            if (frame.blaLevels > 0) {
+                int blaCount = bla.offset[bla.levels];
+                if (blaCount > d_blaCapacity) {
+                    cudaFree(d_bla);
+                    cudaMalloc(&d_bla, sizeof(BlaStep) * blaCount);
+                    d_blaCapacity = blaCount;
+                }
+                cudaMemcpy(d_bla, bla.steps, sizeof(BlaStep) * blaCount, cudaMemcpyHostToDevice);
+                frame.bla = d_bla;
+            }
+        }
+
+        // Bilder auf dem Raster des Kachelcaches übernehmen, was er von ihnen hat, und füllen ihn
+        int64_t originX = 0, originY = 0;
+        bool onGrid = ready && !recolor && !tiled && tiles.capacity > 0 && tileOrigin(frame, originX, originY);
+        if (onGrid && h_iters == NULL) {
+            h_iters = (int *)malloc(pixels * sizeof(int));
+            onGrid = h_iters != NULL;
+        }
+        TileCacheStats tileStats = {0, 0, 0};
+
+        res.precision = frame.precision;
+        res.status = ready ? RESPONSE_OK : RESPONSE_FAILED;
+        // Das Bild geht mit --output in die Datei, über stdout kommt dann nur der Kopf
+        res.byteLength = outputPath != NULL ? 0 : newImageSize;
+
+        //Aufruf der Regderfunktion auf der GPU; ohne Referenzorbit bleibt das Bild schwarz
+        if (tiled) {
+            // Kacheln gehen schon während der Berechnung hinaus; Mariani-Silver braucht das ganze Bild und entfällt.
+            // Der Antwortkopf muss vorher raus und kennt die Renderzeit noch nicht
+            if (!textProtocol) {
+                res.renderMs = -1.0;
+                writeResponseHeader(stdout, res);
+            }
+            TileWriter writer;
+            int size = tileSize > 0 ? tileSize : TILE_SIZE_DEFAULT;
+            bool ok = openTileWriter(writer, out, outputPath != NULL, WIDTH, HEIGHT, size);
+            if (ok)
+                ok = ready ? renderTiled(writer, frame, opts, req.colors) : writeBlackTiles(writer);
+            if (!closeTileWriter(writer) || !ok) {
+                fprintf(stderr, "Tiled output failed for %d x %d frame\n", WIDTH, HEIGHT);
+                if (out != stdout)
+                    fclose(out);
+                break;
+            }
+            fprintf(stderr, "Tiled: %d x %d tiles of %d px\n", (WIDTH + size - 1) / size, (HEIGHT + size - 1) / size, size);
+            cache.valid = false;
+        }
+        else if (recolor) {
+            const float *cdf = req.colors.histogram ? histogramCdf(hist, d_iters, WIDTH, WIDTH, HEIGHT, 1, frame.MAX_ITER) : NULL;
+            colorize<<<grid, block>>>(d_image, d_iters, cache.smooth ? d_smooth : NULL, WIDTH, HEIGHT, frame.MAX_ITER, req.colors, cdf);
+        }
+        else {
+            // Beim Ziehen mit gleichem Zoom stehen die meisten Pixel schon im Puffer. Verschobene Bilder,
+            // Kacheln aus dem Cache, Vorschauen und Mariani-Silver haben keine glatten Iterationsanzahlen,
+            // daher mit smooth alles neu. Der zweite Puffer kommt mit dem ersten Verschieben, ohne ihn wird neu gerechnet
+            int shiftX = 0, shiftY = 0;
+            bool panned = ready && !smooth && opts.panCache && panShift(cache, frame, req, shiftX, shiftY);
+            if (panned && d_itersSpare == NULL)
+                panned = deviceAlloc(&d_itersSpare, pixels * sizeof(int));
+            if (onGrid && !panned && !smooth) {
+                fetchTiles(tiles, frame, originX, originY, h_iters, tileStats);
+                if (tileStats.hits > 0)
+                    cudaMemcpy(d_iters, h_iters, (size_t)WIDTH * HEIGHT * sizeof(int), cudaMemcpyHostToDevice);
+            }
+            bool cached = tileStats.hits > 0;
+            // Vorschauen nur, wenn die GUI sie sieht; ein verschobenes oder aus Kacheln gesetztes Bild ist ohnehin schnell fertig
+            bool progressive = ready && !smooth && !panned && !cached && (req.flags & REQUEST_FLAG_PROGRESSIVE) && !textProtocol &&
+                               outputPath == NULL;
+            cache.valid = false;
+
+            bool complete = true;
+            if (panned) {
+                shiftIterations<<<grid, block>>>(d_itersSpare, d_iters, WIDTH, HEIGHT, shiftX, shiftY);
+                int *swap = d_iters;
+                d_iters = d_itersSpare;
+                d_itersSpare = swap;
+                renderRemaining<<<grid, block>>>(d_iters, frame, opts);
+                colorize<<<grid, block>>>(d_image, d_iters, NULL, WIDTH, HEIGHT, frame.MAX_ITER, req.colors, NULL);
+                fprintf(stderr, "Panned by %d x %d px, reused %.1f%% of the pixels\n", shiftX, shiftY,
+                        100.0 * (WIDTH - abs(shiftX)) * (HEIGHT - abs(shiftY)) / ((double)WIDTH * HEIGHT));
+            }
+            else if (cached) {
+                renderRemaining<<<grid, block>>>(d_iters, frame, opts);
+                colorize<<<grid, block>>>(d_image, d_iters, NULL, WIDTH, HEIGHT, frame.MAX_ITER, req.colors, NULL);
+            }
+            else if (progressive) {
+                complete = renderProgressive(d_image, d_iters, hist, h_image, frame, req, res, opts, block, queue.cancel,
+                                             useShared ? &shared : NULL, start, stop);
+                res.pass = PROGRESSIVE_PASSES - 1;
+                res.passes = PROGRESSIVE_PASSES;
+            }
+            else if (ready && opts.marianiSilver && !smooth && allocPending(d_pending, WIDTH, HEIGHT))
+                complete = renderMarianiSilver(d_image, d_iters, d_pending, frame, opts, req.colors, grid, block, queue.cancel);
+            else if (ready)
+                complete = renderSliced(d_image, d_iters, smooth ? d_smooth : NULL, frame, opts, req.colors, block, queue.cancel);
+
+            if (!complete) {
+                // Eine neuere Anfrage wartet schon; das halbe Bild geht nicht mehr hinaus
+                cudaDeviceSynchronize();
+                fprintf(stderr, "Frame #%u cancelled\n", req.requestId);
+                fflush(stderr);
+                if (out != stdout)
+                    fclose(out);
+                continue;
+            }
+            if (ready && req.colors.histogram) {
+                // Zweiter Durchlauf über das fertige Bild, ersetzt die Farben von eben
+                const float *cdf = histogramCdf(hist, d_iters, WIDTH, WIDTH, HEIGHT, 1, frame.MAX_ITER);
+                if (cdf != NULL)
+                    colorize<<<grid, block>>>(d_image, d_iters, smooth ? d_smooth : NULL, WIDTH, HEIGHT, frame.MAX_ITER, req.colors, cdf);
+            }
+            if (ready)
+                keepFrame(cache, frame, req);
+        }
 
         cudaDeviceSynchronize();
 
@@ -229,12 +1143,48 @@ int main()
         float milliseconds = 0.0f;
         cudaEventElapsedTime(&milliseconds, start, stop);
 
-        cudaMemcpy(h_image, d_image, newImageSize, cudaMemcpyDeviceToHost);
+        if (useShared) {
+            // Direkt von der GPU in den Slot, über die Pipe geht nur der Kopf
+            int slot;
+            uint8_t *image = beginSharedFrame(shared, newImageSize, slot);
+            if (image == NULL) {
+                fprintf(stderr, "Cannot grow shared frame file to %d x %d\n", WIDTH, HEIGHT);
+                break;
+            }
+            cudaMemcpy(image, d_image, newImageSize, cudaMemcpyDeviceToHost);
+            publishSharedFrame(shared, slot, res);
+            res.renderMs = milliseconds;
+            writeResponseHeader(stdout, res);
+            fflush(stdout);
+        }
+        else if (!tiled) {
+            cudaMemcpy(h_image, d_image, newImageSize, cudaMemcpyDeviceToHost);
 
-        fwrite(h_image, 1, newImageSize, stdout);
-        fflush(stdout);
+            if (!textProtocol) {
+                res.renderMs = milliseconds;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+
+            if (outputPath != NULL)
+                fprintf(out, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+            fwrite(h_image, 1, newImageSize, out);
+            fflush(out);
+        }
+        if (out != stdout)
+            fclose(out);
+        // Erst nach dem Senden, die GUI wartet nicht darauf
+        if (onGrid) {
+            cudaMemcpy(h_iters, d_iters, (size_t)WIDTH * HEIGHT * sizeof(int), cudaMemcpyDeviceToHost);
+            storeTiles(tiles, frame, originX, originY, h_iters);
+        }
 
-        fprintf(stderr, "Frame render time: %.3f ms\n", milliseconds);
+        if (tileStats.hits + tileStats.misses > 0)
+            fprintf(stderr, "Tile cache: %d hits (%d from disk), %d misses\n", tileStats.hits, tileStats.diskHits, tileStats.misses);
+        if (recolor)
+            fprintf(stderr, "Recolor time: %.3f ms\n", milliseconds);
+        else
+            fprintf(stderr, "Frame render time: %.3f ms (%s)\n", milliseconds, precisionName(frame.precision));
         fflush(stderr);
     }
     if (d_image) {
@@ -243,8 +1193,29 @@ int main()
     if (h_image) {
         free(h_image);
     }
+    cudaFree(d_iters);
+    cudaFree(d_itersSpare);
+    cudaFree(d_smooth);
+    free(h_iters);
+    if (tiles.hits + tiles.misses > 0)
+        fprintf(stderr, "Tile cache: %lld hits, %lld misses in total\n", tiles.hits, tiles.misses);
+    closeTileCache(tiles);
+    cudaFree(d_pending[0]);
+    cudaFree(d_pending[1]);
+    cudaFree(d_refReal);
+    cudaFree(d_refImag);
+    cudaFree(d_bla);
+    cudaFree(d_palette);
+    cudaFree(hist.d_counts);
+    cudaFree(hist.d_cdf);
+    free(hist.h_counts);
+    free(hist.h_cdf);
+    freeReferenceOrbit(orbit);
+    freeBlaTable(bla);
     cudaEventDestroy(start);
     cudaEventDestroy(stop);
+    if (sharedPath != NULL)
+        closeSharedFrames(shared);
 
     fprintf(stderr, "CUDA Backend clean exit\n");
     fflush(stderr);
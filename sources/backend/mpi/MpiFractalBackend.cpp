@@ -0,0 +1,638 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../common/FractalProtocol.h"
+#include "../common/Palette.h"
+#include "../common/Perturbation.h"
+#include "../common/RequestQueue.h"
+#include "../common/SharedFrames.h"
+#include "../common/TileWriter.h"
+#include "../c/CpuRenderer.h"
+#include "../c/FractalSimd.h"
+
+/*
+ * MPI-Backend: mpirun -np N bin/backend/mpi/MpiFractalBackend [Optionen]
+ *
+ * Rang 0 spricht das Protokoll auf stdin/stdout wie das OpenMP-Backend und verteilt jedes Bild in
+ * Kacheln an die Ränge 1..N-1. Die Verteilung ist dynamisch (Master-Worker): jeder Arbeiter bekommt
+ * eine Kachel, schickt ihre Iterationen zurück und erhält sofort die nächste. Statische Streifen
+ * wären ungleich verteilt, da Kacheln nahe der Menge um Größenordnungen teurer sind als außen.
+ *
+ * Pro Bild geht nur die Anfrage an alle Ränge (MPI_Bcast); jeder Arbeiter bereitet das Bild daraus
+ * selbst vor (prepareFrame() ist deterministisch, der Referenzorbit entsteht so parallel auf allen
+ * Rängen statt einmal verschickt zu werden). Ein Arbeiter hält nur eine Kachel, das ganze Bild gibt
+ * es nur in Rang 0, der die Kacheln einsetzt und färbt. Da dort die Iterationen liegen, geht
+ * Neufärben ohne Rechnen wie im OpenMP-Backend. Mit COLOR_FLAG_SMOOTH folgen in jeder Kachel den
+ * Iterationen ihre glatten Iterationsanzahlen.
+ *
+ * Nicht unterstützt: Verschieben ohne Neurechnen, Kachelcache, Vorschauen (das Bild kommt in einem
+ * Durchlauf), Mariani-Silver sowie Bilder über TILE_FRAME_LIMIT.
+ */
+
+// Kantenlänge der verteilten Kacheln
+#define MPI_TILE_DEFAULT 64
+
+#define MPI_TAG_TILE 1
+#define MPI_TAG_RESULT 2
+
+#define MPI_JOB_FRAME 0
+#define MPI_JOB_EXIT 1
+
+/**
+ * @brief Auftrag von Rang 0 an alle Arbeiter, per MPI_Bcast.
+ */
+struct MpiJob
+{
+    int command;
+    int tileSize;
+    FrameRequest req;
+};
+
+/**
+ * @brief Kopf einer fertigen Kachel, dahinter ihre w * h Iterationen und mit colors.smooth ebenso
+ * viele glatte Iterationsanzahlen.
+ */
+struct MpiTileResult
+{
+    int tile;
+    // 0, wenn der Arbeiter das Bild nicht vorbereiten konnte
+    int ok;
+    long long iterations;
+    long long steps;
+};
+
+// Platz für eine Kachel samt MpiTileResult und glatten Iterationsanzahlen
+#define MPI_TILE_BYTES(tileSize) (sizeof(MpiTileResult) + (sizeof(int) + sizeof(float)) * (tileSize) * (tileSize))
+
+/**
+ * @brief Lage einer Kachel im Bild; Kacheln sind zeilenweise nummeriert.
+ */
+static void tileRect(int tile, int tileSize, int WIDTH, int HEIGHT, int &x0, int &y0, int &w, int &h)
+{
+    int cols = (WIDTH + tileSize - 1) / tileSize;
+    x0 = (tile % cols) * tileSize;
+    y0 = (tile / cols) * tileSize;
+    w = WIDTH - x0 < tileSize ? WIDTH - x0 : tileSize;
+    h = HEIGHT - y0 < tileSize ? HEIGHT - y0 : tileSize;
+}
+
+/**
+ * @brief Liest die Kommandozeile, in allen Rängen gleich. Unterstützt werden
+ *   --tile N                     Kantenlänge der verteilten Kacheln (Standard: MPI_TILE_DEFAULT)
+ *   --simd scalar|sse2|avx2|avx512  Kernel erzwingen (Standard: bester per CPUID)
+ *   --no-interior-check          Kardioiden-/Knospen-Test abschalten (zum Validieren)
+ *   --no-periodicity-check       Zykluserkennung in mandelbrot() abschalten (zum Validieren)
+ *   --precision auto|float|double|double-double|perturbation  Rechenverfahren erzwingen (Standard: auto nach Zoomtiefe)
+ *   --no-bla                     Bei Störungsrechnung keine Iterationen per BLA überspringen (zum Validieren)
+ *   --protocol binary|text       Anfrage-/Antwortformat, siehe FractalProtocol.h (Standard: binary)
+ *   --no-coalesce                Jede Anfrage vollständig rechnen, statt veraltete zu verwerfen (Stapelbetrieb)
+ *                                (im Textprotokoll immer so, dort sind Antworten nicht zuzuordnen)
+ *   --shared-memory FILE         Bilder in die gemeinsam gemappte Datei FILE rechnen statt durch die Pipe
+ *                                (nur Binärprotokoll, siehe SharedFrames.h)
+ *   --palette FILE               Farbverlauf aus FILE statt des HSV-Farbkreises, siehe Palette.h
+ *
+ * @param argc
+ * @param argv
+ * @param opts Ergebnis der Rechenschalter
+ * @param simd Ergebnis von --simd, vorbelegt mit detectSimdLevel()
+ * @param tileSize Ergebnis von --tile
+ * @param textProtocol Ergebnis von --protocol
+ * @param coalesce Ergebnis von --no-coalesce
+ * @param sharedPath Ergebnis von --shared-memory, NULL ohne
+ * @param palettePath Ergebnis von --palette, NULL ohne
+ * @param report false in den Arbeitern, damit Fehler nur einmal erscheinen
+ * @return 0 bei Erfolg, sonst 1
+ */
+static int parseArguments(int argc, char **argv, RenderOptions &opts, SimdLevel &simd, int &tileSize, bool &textProtocol, bool &coalesce,
+                          const char *&sharedPath, const char *&palettePath, bool report)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc)
+        {
+            tileSize = atoi(argv[++i]);
+            if (tileSize < 8 || tileSize > 1024)
+            {
+                if (report)
+                    fprintf(stderr, "Invalid tile size: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+        {
+            SimdLevel requested;
+            if (!parseSimdLevel(argv[++i], requested))
+            {
+                if (report)
+                    fprintf(stderr, "Unknown SIMD level: %s\n", argv[i]);
+                return 1;
+            }
+            if (requested > simd)
+            {
+                if (report)
+                    fprintf(stderr, "SIMD level %s not supported by this CPU, using %s\n", argv[i], simdLevelName(simd));
+            }
+            else
+            {
+                simd = requested;
+            }
+        }
+        else if (strcmp(argv[i], "--no-interior-check") == 0)
+        {
+            opts.interiorCheck = false;
+        }
+        else if (strcmp(argv[i], "--no-periodicity-check") == 0)
+        {
+            opts.periodicityCheck = false;
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc)
+        {
+            if (!parsePrecision(argv[++i], opts.precision))
+            {
+                if (report)
+                    fprintf(stderr, "Unknown precision: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--no-bla") == 0)
+        {
+            opts.bla = false;
+        }
+        else if (strcmp(argv[i], "--protocol") == 0 && i + 1 < argc)
+        {
+            const char *kind = argv[++i];
+            if (strcmp(kind, "text") == 0)
+            {
+                textProtocol = true;
+            }
+            else if (strcmp(kind, "binary") == 0)
+            {
+                textProtocol = false;
+            }
+            else
+            {
+                if (report)
+                    fprintf(stderr, "Unknown protocol: %s\n", kind);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--no-coalesce") == 0)
+        {
+            coalesce = false;
+        }
+        else if (strcmp(argv[i], "--shared-memory") == 0 && i + 1 < argc)
+        {
+            sharedPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--palette") == 0 && i + 1 < argc)
+        {
+            palettePath = argv[++i];
+        }
+        else
+        {
+            if (report)
+                fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (sharedPath != NULL && textProtocol)
+    {
+        if (report)
+            fprintf(stderr, "--shared-memory needs the binary protocol\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Schleife der Ränge 1..N-1: wartet auf Aufträge von Rang 0 und rechnet Kacheln, bis
+ * MPI_JOB_EXIT kommt.
+ */
+static void workerLoop(const RenderOptions &opts, SimdLevel simd)
+{
+    ReferenceOrbit orbit = {NULL, NULL, 0, 0};
+    BlaTable bla = {NULL, 0, 0, {0}};
+    uint8_t *buffer = NULL;
+    int bufferTile = 0;
+
+    while (true)
+    {
+        MpiJob job;
+        MPI_Bcast(&job, sizeof(job), MPI_BYTE, 0, MPI_COMM_WORLD);
+        if (job.command == MPI_JOB_EXIT)
+            break;
+
+        if (job.tileSize != bufferTile)
+        {
+            free(buffer);
+            buffer = (uint8_t *)malloc(MPI_TILE_BYTES(job.tileSize));
+            if (buffer == NULL)
+            {
+                fprintf(stderr, "Out of memory for a %d px tile\n", job.tileSize);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            bufferTile = job.tileSize;
+        }
+
+        FrameParams frame;
+        bool ready = prepareFrame(frame, job.req, opts, orbit, bla);
+        while (true)
+        {
+            int tile;
+            MPI_Recv(&tile, 1, MPI_INT, 0, MPI_TAG_TILE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (tile < 0)
+                break;
+
+            int x0, y0, w, h;
+            tileRect(tile, job.tileSize, job.req.WIDTH, job.req.HEIGHT, x0, y0, w, h);
+            MpiTileResult result = {tile, ready ? 1 : 0, 0, 0};
+            RenderStats stats = {0, 0};
+            int *iterations = (int *)(buffer + sizeof(MpiTileResult));
+            float *smooth = job.req.colors.smooth ? (float *)(iterations + w * h) : NULL;
+            if (ready)
+                computeRegion(iterations, frame, opts, simd, x0, y0, w, h, &stats, smooth);
+            result.iterations = stats.iterations;
+            result.steps = stats.steps;
+            memcpy(buffer, &result, sizeof(result));
+            size_t bytes = sizeof(MpiTileResult) + (smooth != NULL ? sizeof(int) + sizeof(float) : sizeof(int)) * w * h;
+            MPI_Send(buffer, (int)bytes, MPI_BYTE, 0, MPI_TAG_RESULT, MPI_COMM_WORLD);
+        }
+    }
+    freeReferenceOrbit(orbit);
+    freeBlaTable(bla);
+    free(buffer);
+}
+
+/**
+ * @brief Setzt eine fertige w x h Kachel an x0, y0 in die Puffer des ganzen Bildes.
+ *
+ * @param tileSmooth NULL ohne glatte Iterationsanzahlen
+ */
+static void placeTile(int *iterations, float *smooth, const int *tileIters, const float *tileSmooth, int WIDTH, int x0, int y0, int w, int h)
+{
+    for (int y = 0; y < h; y++)
+    {
+        memcpy(iterations + (size_t)(y0 + y) * WIDTH + x0, tileIters + (size_t)y * w, sizeof(int) * w);
+        if (tileSmooth != NULL)
+            memcpy(smooth + (size_t)(y0 + y) * WIDTH + x0, tileSmooth + (size_t)y * w, sizeof(float) * w);
+    }
+}
+
+/**
+ * @brief Rechnet ein Bild auf den Arbeitern: schickt jedem eine Kachel und jedem, der eine
+ * zurückgibt, die nächste, bis alle fertig sind. Nach cancel gibt es keine neuen Kacheln mehr,
+ * die ausstehenden werden noch abgeholt. Ohne Arbeiter (mpirun -np 1) rechnet Rang 0 selbst.
+ *
+ * @param iterations Ergebnis, WIDTH * HEIGHT Einträge
+ * @param smooth mit job.req.colors.smooth: Ergebnis der glatten Iterationsanzahlen, WIDTH * HEIGHT Einträge
+ * @param job bereits an alle Ränge verschickt
+ * @param frame Bildparameter von Rang 0, nur ohne Arbeiter gebraucht
+ * @param opts
+ * @param simd
+ * @param ranks Anzahl der Ränge
+ * @param buffer Platz für eine Kachel samt MpiTileResult
+ * @param stats Ergebnis
+ * @param cancel
+ * @return false, wenn das Bild wegen cancel unvollständig ist oder ein Arbeiter es nicht vorbereiten konnte
+ */
+static bool distributeTiles(int *iterations, float *smooth, const MpiJob &job, const FrameParams &frame, const RenderOptions &opts, SimdLevel simd,
+                            int ranks, uint8_t *buffer, RenderStats &stats, const std::atomic<bool> &cancel)
+{
+    int WIDTH = job.req.WIDTH;
+    int HEIGHT = job.req.HEIGHT;
+    int tiles = ((WIDTH + job.tileSize - 1) / job.tileSize) * ((HEIGHT + job.tileSize - 1) / job.tileSize);
+    int *tileIters = (int *)(buffer + sizeof(MpiTileResult));
+
+    if (ranks == 1)
+    {
+        for (int tile = 0; tile < tiles; tile++)
+        {
+            if (cancel.load(std::memory_order_relaxed))
+                return false;
+            int x0, y0, w, h;
+            tileRect(tile, job.tileSize, WIDTH, HEIGHT, x0, y0, w, h);
+            float *tileSmooth = job.req.colors.smooth ? (float *)(tileIters + w * h) : NULL;
+            computeRegion(tileIters, frame, opts, simd, x0, y0, w, h, &stats, tileSmooth);
+            placeTile(iterations, smooth, tileIters, tileSmooth, WIDTH, x0, y0, w, h);
+        }
+        return true;
+    }
+
+    int next = 0;
+    int outstanding = 0;
+    for (int rank = 1; rank < ranks; rank++)
+    {
+        int tile = next < tiles ? next++ : -1;
+        MPI_Send(&tile, 1, MPI_INT, rank, MPI_TAG_TILE, MPI_COMM_WORLD);
+        if (tile >= 0)
+            outstanding++;
+    }
+
+    bool ok = true;
+    int bytes = (int)MPI_TILE_BYTES(job.tileSize);
+    while (outstanding > 0)
+    {
+        MPI_Status status;
+        MPI_Recv(buffer, bytes, MPI_BYTE, MPI_ANY_SOURCE, MPI_TAG_RESULT, MPI_COMM_WORLD, &status);
+        outstanding--;
+
+        MpiTileResult result;
+        memcpy(&result, buffer, sizeof(result));
+        if (!result.ok)
+            ok = false;
+        stats.iterations += result.iterations;
+        stats.steps += result.steps;
+        int x0, y0, w, h;
+        tileRect(result.tile, job.tileSize, WIDTH, HEIGHT, x0, y0, w, h);
+        placeTile(iterations, smooth, tileIters, job.req.colors.smooth ? (float *)(tileIters + w * h) : NULL, WIDTH, x0, y0, w, h);
+
+        if (cancel.load(std::memory_order_relaxed))
+            ok = false;
+        int tile = ok && next < tiles ? next++ : -1;
+        MPI_Send(&tile, 1, MPI_INT, status.MPI_SOURCE, MPI_TAG_TILE, MPI_COMM_WORLD);
+        if (tile >= 0)
+            outstanding++;
+    }
+    // Arbeiter, die zuletzt noch eine Kachel hatten, haben ihr Ende oben bekommen; die übrigen schon vorher
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    // Nur der Hauptthread von Rang 0 ruft MPI auf, der Lesethread nicht
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    RenderOptions opts;
+    SimdLevel simd = detectSimdLevel();
+    int tileSize = MPI_TILE_DEFAULT;
+    bool textProtocol = false;
+    bool coalesce = true;
+    const char *sharedPath = NULL;
+    const char *palettePath = NULL;
+
+    // Alle Ränge sehen dieselbe Kommandozeile und kommen zum selben Ergebnis
+    if (parseArguments(argc, argv, opts, simd, tileSize, textProtocol, coalesce, sharedPath, palettePath, rank == 0) != 0)
+    {
+        MPI_Finalize();
+        return 1;
+    }
+    // Jeder Rang rechnet seine Kachel in einem Thread; Rang 0 färbt mit OpenMP
+    opts.marianiSilver = false;
+
+    if (rank != 0)
+    {
+        workerLoop(opts, simd);
+        MPI_Finalize();
+        return 0;
+    }
+
+    // Nur Rang 0 färbt und braucht die Farbtabelle
+    Gradient gradient;
+    PaletteCache palettes = {};
+    if (palettePath != NULL)
+    {
+        if (!loadGradient(palettePath, gradient))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        palettes.gradient = &gradient;
+    }
+
+    fprintf(stderr, "MPI Backend started (%d ranks, %s, %d px tiles)\n", ranks, simdLevelName(simd), tileSize);
+    fflush(stderr);
+
+    uint8_t *h_image = NULL;
+    size_t currentImageSize = 0;
+    int *h_iters = NULL;
+    float *h_smooth = NULL;
+    size_t iterationPixels = 0;
+    // Bild, dessen Iterationen in h_iters (und mit smooth in h_smooth) liegen, zum Neufärben
+    bool hasFrame = false;
+    bool hasSmooth = false;
+    FrameParams lastFrame = {};
+    ReferenceOrbit orbit = {NULL, NULL, 0, 0};
+    BlaTable bla = {NULL, 0, 0, {0}};
+    uint8_t *tileBuffer = (uint8_t *)malloc(MPI_TILE_BYTES(tileSize));
+    if (tileBuffer == NULL)
+    {
+        fprintf(stderr, "Out of memory for a %d px tile\n", tileSize);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    SharedFrames shared = {};
+    if (sharedPath != NULL && !openSharedFrames(shared, sharedPath))
+    {
+        fprintf(stderr, "Cannot create shared frame file %s\n", sharedPath);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    RequestQueue queue;
+    startRequestReader(queue, textProtocol, coalesce);
+
+    while (true)
+    {
+        FrameRequest req;
+        long long dropped;
+        RequestResult result = nextRequest(queue, req, dropped);
+        if (dropped > 0)
+        {
+            fprintf(stderr, "Skipped %lld stale requests\n", dropped);
+            fflush(stderr);
+        }
+        if (result == REQUEST_END)
+            break;
+
+        FrameResponse res = {req.requestId, req.pixelFormat, req.WIDTH, req.HEIGHT, PRECISION_AUTO, RESPONSE_INVALID_REQUEST, 0.0, 0, -1, 0, 0, 0, 1};
+        if (result == REQUEST_INVALID)
+        {
+            // Im Textprotokoll gibt es keine Antwort ohne Bild
+            if (!textProtocol)
+            {
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+            continue;
+        }
+
+        bool recolor = (req.flags & REQUEST_FLAG_RECOLOR) != 0;
+        if (recolor)
+        {
+            if (!hasFrame)
+            {
+                fprintf(stderr, "Received #%u: recolor, but there is no frame to recolor\n", req.requestId);
+                fflush(stderr);
+                res.status = RESPONSE_FAILED;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+                continue;
+            }
+            req.WIDTH = res.WIDTH = lastFrame.WIDTH;
+            req.HEIGHT = res.HEIGHT = lastFrame.HEIGHT;
+        }
+
+        size_t pixels = (size_t)req.WIDTH * req.HEIGHT;
+        size_t newImageSize = pixels * 3;
+        if ((long long)newImageSize > TILE_FRAME_LIMIT)
+        {
+            fprintf(stderr, "Received #%u: %d x %d is too large for the MPI backend\n", req.requestId, req.WIDTH, req.HEIGHT);
+            fflush(stderr);
+            if (!textProtocol)
+            {
+                res.status = RESPONSE_FAILED;
+                writeResponseHeader(stdout, res);
+                fflush(stdout);
+            }
+            continue;
+        }
+
+        uint8_t *image = h_image;
+        int sharedSlot = -1;
+        if (sharedPath == NULL && newImageSize != currentImageSize)
+        {
+            free(h_image);
+            h_image = (uint8_t *)malloc(newImageSize);
+            if (h_image == NULL)
+            {
+                fprintf(stderr, "Out of memory for %d x %d frame\n", req.WIDTH, req.HEIGHT);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            currentImageSize = newImageSize;
+            image = h_image;
+        }
+        if (pixels != iterationPixels)
+        {
+            // Mit den Puffern ist das letzte Bild weg, auch wenn prepareFrame() gleich scheitert
+            hasFrame = false;
+            free(h_iters);
+            free(h_smooth);
+            h_iters = (int *)malloc(sizeof(int) * pixels);
+            h_smooth = (float *)malloc(sizeof(float) * pixels);
+            if (h_iters == NULL || h_smooth == NULL)
+            {
+                fprintf(stderr, "Out of memory for %d x %d iteration buffer\n", req.WIDTH, req.HEIGHT);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            iterationPixels = pixels;
+        }
+
+        if (recolor)
+            fprintf(stderr, "Received #%u: recolor, hue=%g, saturation=%g, brightness=%g, exponent=%g\n", req.requestId,
+                    req.colors.hueOffset, req.colors.saturation, req.colors.brightness, req.colors.exponent);
+        else
+            fprintf(stderr, "Received #%u: zoom=%.2f, centerX=%.2f, centerY=%.2f, WIDTH=%d, HEIGHT=%d\n", req.requestId, req.zoom, req.centerX, req.centerY, req.WIDTH, req.HEIGHT);
+        fflush(stderr);
+
+        // Timing START
+        double start = MPI_Wtime();
+
+        FrameParams frame = lastFrame;
+        RenderStats stats = {0, 0};
+        bool ready = recolor || prepareFrame(frame, req, opts, orbit, bla);
+        bool complete = true;
+        if (ready && !recolor)
+        {
+            hasFrame = false;
+            MpiJob job = {MPI_JOB_FRAME, tileSize, req};
+            MPI_Bcast(&job, sizeof(job), MPI_BYTE, 0, MPI_COMM_WORLD);
+            complete = distributeTiles(h_iters, h_smooth, job, frame, opts, simd, ranks, tileBuffer, stats, queue.cancel);
+            if (!complete && !queue.cancel.load())
+            {
+                // Ein Arbeiter konnte das Bild nicht vorbereiten, obwohl Rang 0 es konnte
+                fprintf(stderr, "Frame #%u failed on a worker\n", req.requestId);
+                ready = false;
+                complete = true;
+            }
+        }
+        if (!complete)
+        {
+            // Eine neuere Anfrage wartet schon; das halbe Bild geht nicht mehr hinaus
+            fprintf(stderr, "Frame #%u cancelled after %.3f ms\n", req.requestId, (MPI_Wtime() - start) * 1000.0);
+            fflush(stderr);
+            continue;
+        }
+
+        res.precision = frame.precision;
+        res.status = ready ? RESPONSE_OK : RESPONSE_FAILED;
+        res.byteLength = newImageSize;
+
+        if (sharedPath != NULL)
+        {
+            image = beginSharedFrame(shared, newImageSize, sharedSlot);
+            if (image == NULL)
+            {
+                fprintf(stderr, "Cannot grow shared frame file to %d x %d\n", req.WIDTH, req.HEIGHT);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        bool smooth = recolor ? hasSmooth : req.colors.smooth;
+        updatePalette(palettes, req.colors);
+        req.colors.palette = &palettes.palette;
+        if (!ready || !colorizeFrame(image, h_iters, pixels, frame.MAX_ITER, req.colors, smooth ? h_smooth : NULL))
+        {
+            memset(image, 0, newImageSize);
+            res.status = RESPONSE_FAILED;
+        }
+        if (ready && !recolor)
+        {
+            hasFrame = true;
+            hasSmooth = req.colors.smooth;
+            lastFrame = frame;
+        }
+
+        // Timing STOP
+        double milliseconds = (MPI_Wtime() - start) * 1000.0;
+
+        if (sharedPath != NULL)
+        {
+            // Das Bild liegt schon im Slot, über die Pipe geht nur der Kopf
+            publishSharedFrame(shared, sharedSlot, res);
+            res.renderMs = milliseconds;
+            writeResponseHeader(stdout, res);
+        }
+        else
+        {
+            if (!textProtocol)
+            {
+                res.renderMs = milliseconds;
+                writeResponseHeader(stdout, res);
+            }
+            fwrite(image, 1, newImageSize, stdout);
+        }
+        fflush(stdout);
+
+        if (stats.steps > 0)
+        {
+            fprintf(stderr, "Perturbation: %lld iterations in %lld steps (%.1fx, %d BLA levels)\n",
+                    stats.iterations, stats.steps, (double)stats.iterations / stats.steps, frame.blaLevels);
+        }
+        if (recolor)
+            fprintf(stderr, "Recolor time: %.3f ms\n", milliseconds);
+        else
+            fprintf(stderr, "Frame render time: %.3f ms (%s)\n", milliseconds, precisionName(frame.precision));
+        fflush(stderr);
+    }
+
+    MpiJob job = {MPI_JOB_EXIT, tileSize, FrameRequest()};
+    MPI_Bcast(&job, sizeof(job), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    freeReferenceOrbit(orbit);
+    freeBlaTable(bla);
+    free(h_image);
+    free(h_iters);
+    free(h_smooth);
+    free(tileBuffer);
+    if (sharedPath != NULL)
+        closeSharedFrames(shared);
+
+    fprintf(stderr, "MPI Backend clean exit\n");
+    fflush(stderr);
+
+    MPI_Finalize();
+    return 0;
+}
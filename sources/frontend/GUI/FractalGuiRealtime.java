@@ -2,7 +2,22 @@ import javax.swing.*;
 import java.awt.*;
 import java.awt.event.*;
 import java.awt.image.BufferedImage;
+import java.awt.image.DataBufferInt;
 import java.io.*;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.VarHandle;
+import java.math.BigDecimal;
+import java.math.RoundingMode;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardOpenOption;
+import java.util.concurrent.TimeUnit;
 
 public class FractalGuiRealtime extends JFrame {
 
@@ -14,11 +29,21 @@ public class FractalGuiRealtime extends JFrame {
     private JButton resetButton;
     private JSpinner widthSpinner;
     private JSpinner heightSpinner;
+    private JSlider hueSlider;
+    private JCheckBox smoothBox;
+    private JCheckBox histogramBox;
     private JLabel imageLabel;
 
     private volatile boolean running = false;
     private volatile double zoom = 1.0;
-    private volatile double centerX = 0.0, centerY = 0.0;
+    // Zentrum als BigDecimal, damit es auch jenseits der double-Genauigkeit (Zoom > 1e13) verschoben werden kann
+    private volatile BigDecimal centerX = BigDecimal.ZERO, centerY = BigDecimal.ZERO;
+    // Farbton-Verschiebung in Grad; eine Änderung färbt nur neu, siehe sendRecolor()
+    private volatile double hueOffset = 0.0;
+    // Stufenlose Farben aus der normierten Iterationsanzahl (COLOR_FLAG_SMOOTH)
+    private volatile boolean smoothColors = false;
+    // Farben nach der Verteilung der Iterationen im Bild (COLOR_FLAG_HISTOGRAM)
+    private volatile boolean histogramColors = false;
 
     // Default image size
     private int WIDTH = 800, HEIGHT = 600;
@@ -31,15 +56,44 @@ public class FractalGuiRealtime extends JFrame {
     private int lastMouseX;
     private int lastMouseY;
 
-    // Define the initial world dimensions for the fractal at zoom 1.0
-    // Assuming a typical Mandelbrot range like x:[-2, 2], y:[-1.5, 1.5]
+    // Define the initial world width for the fractal at zoom 1.0 (x:[-2, 2]); the height
+    // follows from the aspect ratio because pixels are square
     private final double INITIAL_WORLD_WIDTH = 4.0;
-    private final double INITIAL_WORLD_HEIGHT = 3.0;
 
     private Process externalProcess = null;
     private OutputStream processStdin;
     private InputStream processStdout;
 
+    // Binärprotokoll, siehe sources/backend/common/FractalProtocol.h. Mit -Dfractal.textProtocol=true
+    // wird das alte Zeilenformat verwendet (Backends mit --protocol text)
+    private static final boolean TEXT_PROTOCOL = Boolean.getBoolean("fractal.textProtocol");
+    private static final int REQUEST_MAGIC = 0x31515246;
+    private static final int RESPONSE_MAGIC = 0x31535246;
+    private static final int PROTOCOL_VERSION = 3;
+    private static final int NUMBER_MAX = 256;
+    private static final int REQUEST_SIZE = 56 + 2 * NUMBER_MAX + 32 + 4;
+    private static final int REQUEST_FLAG_RECOLOR = 1;
+    private static final int REQUEST_FLAG_PROGRESSIVE = 2;
+    private static final int COLOR_FLAG_SMOOTH = 1;
+    private static final int COLOR_FLAG_HISTOGRAM = 2;
+    private static final int RESPONSE_SIZE = 72;
+    private static final int PIXEL_FORMAT_RGB24 = 1;
+    private static final int PRECISION_AUTO = -1;
+
+    private volatile boolean binaryProtocol = false;
+    private int nextRequestId = 1;
+
+    // Bilder über eine gemeinsam gemappte Datei statt durch die Pipe, siehe
+    // sources/backend/common/SharedFrames.h. Mit -Dfractal.pipeTransport=true abschaltbar
+    private static final boolean PIPE_TRANSPORT = Boolean.getBoolean("fractal.pipeTransport");
+    private static final int SHARED_SEQUENCE_OFFSET = 16;
+    private static final int SHARED_READER_SLOT_OFFSET = 28;
+    private static final VarHandle SHARED_INT = MethodHandles.byteBufferViewVarHandle(int[].class, ByteOrder.LITTLE_ENDIAN);
+    private Path sharedPath;
+    private FileChannel sharedChannel;
+    private MappedByteBuffer sharedMap;
+    private byte[] sharedRow = new byte[0];
+
     // --- Debounce-Variablen für gesteuerte Aktualisierungen ---
     // paramSendTimer wird nur noch für Tastatur-Schwenken verwendet
     private Timer paramSendTimer;
@@ -114,6 +168,33 @@ public class FractalGuiRealtime extends JFrame {
         widthSpinner.addChangeListener(e -> updateResolutionFromUI());
         heightSpinner.addChangeListener(e -> updateResolutionFromUI());
 
+        hueSlider = new JSlider(0, 359, 0);
+        hueSlider.addChangeListener(e -> {
+            hueOffset = hueSlider.getValue();
+            if (running)
+                sendRecolor();
+        });
+
+        // Ein ganzzahlig gerechnetes Bild hat keine glatten Werte, zum Einschalten wird neu gerechnet
+        smoothBox = new JCheckBox("Glatte Farben");
+        smoothBox.addActionListener(e -> {
+            smoothColors = smoothBox.isSelected();
+            if (!running)
+                return;
+            if (smoothColors)
+                sendParameters();
+            else
+                sendRecolor();
+        });
+
+        // Das Histogramm entsteht im Backend aus den gespeicherten Iterationen, Neufärben genügt
+        histogramBox = new JCheckBox("Histogramm");
+        histogramBox.addActionListener(e -> {
+            histogramColors = histogramBox.isSelected();
+            if (running)
+                sendRecolor();
+        });
+
         JPanel topPanel = new JPanel();
         topPanel.add(new JLabel("Backend:"));
         topPanel.add(backendSelector);
@@ -125,6 +206,10 @@ public class FractalGuiRealtime extends JFrame {
         topPanel.add(widthSpinner);
         topPanel.add(new JLabel("Height:"));
         topPanel.add(heightSpinner);
+        topPanel.add(new JLabel("Hue:"));
+        topPanel.add(hueSlider);
+        topPanel.add(smoothBox);
+        topPanel.add(histogramBox);
 
         imageLabel = new JLabel();
         imageLabel.setPreferredSize(new Dimension(WIDTH, HEIGHT));
@@ -212,11 +297,13 @@ public class FractalGuiRealtime extends JFrame {
                     int deltaPx = currentMouseX - lastMouseX;
                     int deltaPy = currentMouseY - lastMouseY;
 
-                    double currentWorldWidth = INITIAL_WORLD_WIDTH / zoom;
-                    double currentWorldHeight = INITIAL_WORLD_HEIGHT / zoom;
+                    // Pixel sind quadratisch (Backend: scale = 4 / (WIDTH * zoom)), auch senkrecht gilt
+                    // die Breite. So verschiebt sich das Bild um ganze Pixel und das Backend kann den
+                    // Rest des vorigen Bildes weiterverwenden
+                    double pixelSize = INITIAL_WORLD_WIDTH / zoom / WIDTH;
 
-                    centerX -= (double) deltaPx * (currentWorldWidth / WIDTH);
-                    centerY += (double) deltaPy * (currentWorldHeight / HEIGHT);
+                    centerX = roundCenter(centerX.subtract(BigDecimal.valueOf((double) deltaPx * pixelSize)));
+                    centerY = roundCenter(centerY.add(BigDecimal.valueOf((double) deltaPy * pixelSize)));
 
                     lastMouseX = currentMouseX;
                     lastMouseY = currentMouseY;
@@ -230,18 +317,37 @@ public class FractalGuiRealtime extends JFrame {
 
     private void resetView() {
         zoom = 1.0;
-        centerX = 0.0;
-        centerY = 0.0;
+        centerX = BigDecimal.ZERO;
+        centerY = BigDecimal.ZERO;
         sendParameters();
     }
 
+    // Begrenzt die Nachkommastellen auf das, was beim aktuellen Zoom sichtbar ist (plus Reserve),
+    // sonst wächst die Zahl mit jedem Verschieben
+    private BigDecimal roundCenter(BigDecimal value) {
+        int digits = Math.max(17, (int) Math.ceil(Math.log10(zoom)) + 20);
+        return value.setScale(digits, RoundingMode.HALF_EVEN).stripTrailingZeros();
+    }
+
     private void startRenderLoop() {
         new Thread(() -> {
             frameSize = WIDTH * HEIGHT * 3;
             buffer = new byte[frameSize];
             try {
                 String backend = (String) backendSelector.getSelectedItem();
+                boolean binaryCapable = speaksBinaryProtocol(backend);
+                binaryProtocol = !TEXT_PROTOCOL && binaryCapable;
                 ProcessBuilder pb = getProcessBuilderForBackend(backend);
+                if (TEXT_PROTOCOL && binaryCapable) {
+                    pb.command().add("--protocol");
+                    pb.command().add("text");
+                }
+                if (binaryProtocol && !PIPE_TRANSPORT) {
+                    // Das Backend legt die Datei an; die GUI bildet sie beim ersten Bild ab
+                    sharedPath = sharedFramePath();
+                    pb.command().add("--shared-memory");
+                    pb.command().add(sharedPath.toString());
+                }
                 externalProcess = pb.start();
                 System.out.println("Backend-Prozess gestartet: " + backend);
 
@@ -263,7 +369,11 @@ public class FractalGuiRealtime extends JFrame {
                 sendParameters(); // Initiales Bild anfordern
 
                 // Die Haupt-Render-Schleife
-                while (running) {
+                while (running && binaryProtocol) {
+                    if (!readBinaryFrame())
+                        break;
+                }
+                while (running && !binaryProtocol) {
                     int bytesRead = 0;
                     while (bytesRead < frameSize) {
                         int r = processStdout.read(buffer, bytesRead, frameSize - bytesRead);
@@ -300,6 +410,7 @@ public class FractalGuiRealtime extends JFrame {
                     externalProcess.destroy();
                     externalProcess = null;
                 }
+                closeSharedFrames();
 
                 // Prüfen, ob ein Neustart angefordert wurde
                 if (restartPending) {
@@ -318,10 +429,266 @@ public class FractalGuiRealtime extends JFrame {
         }).start();
     }
 
-    private void sendParameters() {
+    /**
+     * Liest eine Antwort des Binärprotokolls (Kopf und Bild) und zeigt das Bild an.
+     *
+     * @return false, wenn die Schleife enden soll (geplanter Stopp)
+     */
+    private boolean readBinaryFrame() throws IOException {
+        byte[] headerBytes = new byte[RESPONSE_SIZE];
+        if (!readFully(headerBytes, RESPONSE_SIZE))
+            return false;
+
+        ByteBuffer header = ByteBuffer.wrap(headerBytes).order(ByteOrder.LITTLE_ENDIAN);
+        int magic = header.getInt(0);
+        int headerSize = header.getShort(6) & 0xFFFF;
+        if (magic != RESPONSE_MAGIC || headerSize < RESPONSE_SIZE)
+            throw new IOException("Invalid response header from backend");
+        // Neuere Backends dürfen den Kopf verlängern
+        byte[] extra = new byte[headerSize - RESPONSE_SIZE];
+        if (!readFully(extra, extra.length))
+            return false;
+
+        int requestId = header.getInt(8);
+        int width = header.getInt(16);
+        int height = header.getInt(20);
+        int status = header.getInt(28);
+        double renderMs = header.getDouble(32);
+        long byteLength = header.getLong(40);
+        int sharedSlot = header.getInt(48);
+        int pass = header.getInt(64);
+        int passes = header.getInt(68);
+        String passInfo = passes > 1 ? ", pass " + (pass + 1) + "/" + passes : "";
+
+        if (sharedSlot >= 0) {
+            if (status != 0) {
+                System.err.println("Request " + requestId + " failed with status " + status);
+                return true;
+            }
+            BufferedImage img = readSharedFrame(sharedSlot, header.getInt(52), header.getLong(56), width, height);
+            if (img == null) {
+                // Schon vom nächsten Bild überschrieben, das ist unterwegs
+                System.out.println("Frame " + requestId + " overwritten, skipped");
+                return true;
+            }
+            System.out.println("Frame " + requestId + " (" + width + "x" + height + "): "
+                    + String.format("%.3f ms", renderMs) + ", shared slot " + sharedSlot + passInfo);
+            showFrame(img);
+            return true;
+        }
+
+        if (byteLength > Integer.MAX_VALUE)
+            throw new IOException("Frame too large for the GUI: " + byteLength + " bytes");
+        int length = (int) byteLength;
+        if (buffer.length < length)
+            buffer = new byte[length];
+        if (!readFully(buffer, length))
+            return false;
+
+        if (status != 0 || length != width * height * 3) {
+            System.err.println("Request " + requestId + " failed with status " + status);
+            return true;
+        }
+        System.out.println("Frame " + requestId + " (" + width + "x" + height + "): "
+                + (renderMs >= 0 ? String.format("%.3f ms", renderMs) : "streamed") + passInfo);
+
+        showFrame(bytesToBufferedImage(buffer, width, height));
+        return true;
+    }
+
+    /**
+     * Zeigt ein Bild an. Vorschauen des progressiven Renderns sind kleiner als das Fenster und werden
+     * auf dessen Größe hochskaliert, bis das nächste Bild kommt.
+     */
+    private void showFrame(BufferedImage img) {
+        Image shown = img.getWidth() < WIDTH ? img.getScaledInstance(WIDTH, HEIGHT, Image.SCALE_FAST) : img;
+        SwingUtilities.invokeLater(() -> imageLabel.setIcon(new ImageIcon(shown)));
+    }
+
+    /**
+     * Holt ein Bild aus einem Slot der gemeinsamen Datei. Während des Kopierens ist der Slot als
+     * gelesen markiert; hat das Backend ihn trotzdem überschrieben (die GUI hing mehr als ein Bild
+     * zurück), ändert sich seine Sequenz und das Bild wird verworfen.
+     *
+     * @return das Bild oder null, wenn es inzwischen überschrieben wurde
+     */
+    private BufferedImage readSharedFrame(int slot, int sequence, long offset, int width, int height) throws IOException {
+        long length = (long) width * height * 3;
+        if (sharedMap == null || offset + length > sharedMap.capacity()) {
+            // Die Datei ist gewachsen (größeres Bild), neu abbilden
+            if (sharedChannel == null)
+                sharedChannel = FileChannel.open(sharedPath, StandardOpenOption.READ, StandardOpenOption.WRITE);
+            if (sharedChannel.size() > Integer.MAX_VALUE)
+                throw new IOException("Shared frame file too large for the GUI");
+            sharedMap = sharedChannel.map(FileChannel.MapMode.READ_WRITE, 0, sharedChannel.size());
+        }
+
+        int sequenceOffset = SHARED_SEQUENCE_OFFSET + 4 * slot;
+        SHARED_INT.setVolatile(sharedMap, SHARED_READER_SLOT_OFFSET, slot);
+        try {
+            if ((int) SHARED_INT.getVolatile(sharedMap, sequenceOffset) != sequence)
+                return null;
+
+            BufferedImage img = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
+            int[] pixels = ((DataBufferInt) img.getRaster().getDataBuffer()).getData();
+            if (sharedRow.length < width * 3)
+                sharedRow = new byte[width * 3];
+            ByteBuffer frame = sharedMap.duplicate();
+            frame.position((int) offset);
+            for (int y = 0, idx = 0; y < height; y++) {
+                frame.get(sharedRow, 0, width * 3);
+                for (int x = 0, i = 0; x < width; x++, i += 3)
+                    pixels[idx++] = (sharedRow[i] & 0xFF) << 16 | (sharedRow[i + 1] & 0xFF) << 8 | (sharedRow[i + 2] & 0xFF);
+            }
+
+            VarHandle.acquireFence();
+            if ((int) SHARED_INT.getVolatile(sharedMap, sequenceOffset) != sequence)
+                return null;
+            return img;
+        } finally {
+            SHARED_INT.setVolatile(sharedMap, SHARED_READER_SLOT_OFFSET, -1);
+        }
+    }
+
+    /**
+     * Pfad der gemeinsamen Datei: im RAM unter /dev/shm, wo vorhanden, sonst im Temp-Verzeichnis.
+     */
+    private Path sharedFramePath() {
+        Path dir = Paths.get("/dev/shm");
+        if (!Files.isDirectory(dir))
+            dir = Paths.get(System.getProperty("java.io.tmpdir"));
+        return dir.resolve("fractal-" + ProcessHandle.current().pid() + "-" + System.nanoTime() + ".frames");
+    }
+
+    private void closeSharedFrames() {
+        sharedMap = null;
+        try {
+            if (sharedChannel != null)
+                sharedChannel.close();
+            if (sharedPath != null)
+                Files.deleteIfExists(sharedPath);
+        } catch (IOException e) {
+            System.err.println("Cannot remove shared frame file: " + e.getMessage());
+        }
+        sharedChannel = null;
+        sharedPath = null;
+    }
+
+    /**
+     * Liest genau length Bytes vom Backend.
+     *
+     * @return false bei einem geplanten Stopp
+     */
+    private boolean readFully(byte[] target, int length) throws IOException {
+        int bytesRead = 0;
+        while (bytesRead < length) {
+            int r = processStdout.read(target, bytesRead, length - bytesRead);
+            if (r == -1) {
+                if (!running)
+                    return false; // Geplanter Stopp, kein Fehler
+                throw new IOException("Process closed stream unexpectedly");
+            }
+            bytesRead += r;
+        }
+        return running;
+    }
+
+    /**
+     * Backends, die das Binärprotokoll sprechen; die übrigen bekommen Textzeilen. CUDA und OpenMP
+     * werden mit --protocol-version gefragt, denn ein älterer Build (etwa die eingecheckte
+     * CudaFractalBackend.exe) liest nur Textzeilen und würde auf Binäranfragen nie antworten.
+     * MPI wird nicht gefragt, der Start über mpirun dauert dafür zu lange.
+     */
+    private boolean speaksBinaryProtocol(String backend) {
+        if (backend.equals("C MPI"))
+            return true;
+        if (!backend.equals("CUDA") && !backend.equals("C OpenMP"))
+            return false;
+        int version = probeProtocolVersion(backend);
+        if (version < PROTOCOL_VERSION)
+            System.out.println("Backend " + backend + " spricht kein Binärprotokoll v" + PROTOCOL_VERSION
+                    + ", verwende Textzeilen");
+        return version >= PROTOCOL_VERSION;
+    }
+
+    /**
+     * Startet das Backend mit --protocol-version und liest die Version aus der ersten Zeile.
+     *
+     * @return Protokollversion, 0 wenn das Backend keine nennt
+     */
+    private int probeProtocolVersion(String backend) {
+        try {
+            ProcessBuilder pb = getProcessBuilderForBackend(backend);
+            pb.command().add("--protocol-version");
+            pb.redirectError(ProcessBuilder.Redirect.INHERIT);
+            Process probe = pb.start();
+            // Ein älterer Build liest bis zum Ende von stdin und endet dann ohne Ausgabe
+            probe.getOutputStream().close();
+            String line;
+            try (BufferedReader out = new BufferedReader(new InputStreamReader(probe.getInputStream()))) {
+                line = out.readLine();
+            }
+            if (!probe.waitFor(5, TimeUnit.SECONDS))
+                probe.destroy();
+            return line == null ? 0 : Integer.parseInt(line.trim());
+        } catch (IOException | NumberFormatException e) {
+            return 0;
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            return 0;
+        }
+    }
+
+    /**
+     * Baut eine Anfrage des Binärprotokolls. Das Zentrum geht als double und zusätzlich als
+     * Dezimaltext in voller Genauigkeit mit, dahinter die Farben.
+     */
+    private byte[] encodeRequest(int requestId, int flags) {
+        ByteBuffer request = ByteBuffer.allocate(REQUEST_SIZE).order(ByteOrder.LITTLE_ENDIAN);
+        request.putInt(REQUEST_MAGIC);
+        request.putShort((short) PROTOCOL_VERSION);
+        request.putShort((short) REQUEST_SIZE);
+        request.putInt(requestId);
+        request.putInt(PIXEL_FORMAT_RGB24);
+        request.putInt(WIDTH);
+        request.putInt(HEIGHT);
+        request.putInt(PRECISION_AUTO);
+        request.putInt(flags);
+        request.putDouble(zoom);
+        request.putDouble(centerX.doubleValue());
+        request.putDouble(centerY.doubleValue());
+        putText(request, 56, centerX.toString());
+        putText(request, 56 + NUMBER_MAX, centerY.toString());
+        request.position(56 + 2 * NUMBER_MAX);
+        request.putDouble(hueOffset);
+        request.putDouble(0.8); // Sättigung
+        request.putDouble(1.0); // Helligkeit
+        request.putDouble(0.5); // Exponent
+        request.putInt((smoothColors ? COLOR_FLAG_SMOOTH : 0) | (histogramColors ? COLOR_FLAG_HISTOGRAM : 0));
+        return request.array();
+    }
+
+    private void putText(ByteBuffer target, int offset, String text) {
+        byte[] bytes = text.getBytes(StandardCharsets.US_ASCII);
+        // Passt der Text nicht, nimmt das Backend den double
+        if (bytes.length < NUMBER_MAX) {
+            target.position(offset);
+            target.put(bytes);
+        }
+    }
+
+    private synchronized void sendParameters() {
         if (processStdin == null)
             return;
         try {
+            if (binaryProtocol) {
+                int requestId = nextRequestId++;
+                processStdin.write(encodeRequest(requestId, REQUEST_FLAG_PROGRESSIVE));
+                processStdin.flush();
+                System.out.println("Anfrage " + requestId + " gesendet: Zoom=" + zoom + ", X=" + centerX + ", Y=" + centerY
+                        + ", Width=" + WIDTH + ", Height=" + HEIGHT);
+                return;
+            }
             String msg = zoom + " " + centerX + " " + centerY + " " + WIDTH + " " + HEIGHT + "\n";
             processStdin.write(msg.getBytes());
             processStdin.flush();
@@ -333,6 +700,24 @@ public class FractalGuiRealtime extends JFrame {
         }
     }
 
+    /**
+     * Lässt das Backend das letzte Bild mit den aktuellen Farben neu einfärben, ohne es neu zu
+     * rechnen. Das Textprotokoll kennt keine Farben, dort gilt der Farbton erst gar nicht.
+     */
+    private synchronized void sendRecolor() {
+        if (processStdin == null || !binaryProtocol)
+            return;
+        try {
+            int requestId = nextRequestId++;
+            processStdin.write(encodeRequest(requestId, REQUEST_FLAG_RECOLOR));
+            processStdin.flush();
+            System.out.println("Anfrage " + requestId + " gesendet: Neufärben, Farbton=" + hueOffset);
+        } catch (IOException e) {
+            e.printStackTrace();
+            System.err.println("Error sending recolor request to backend: " + e.getMessage());
+        }
+    }
+
     private BufferedImage bytesToBufferedImage(byte[] bytes, int width, int height) {
         BufferedImage img = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
         int idx = 0;
@@ -367,16 +752,27 @@ public class FractalGuiRealtime extends JFrame {
             case "Rust":
                 return new ProcessBuilder("./fractal_rust");
             case "C MPI":
-                return new ProcessBuilder(
-                        "sources/Backend/c/fractal_c_mpi_live");
+                // Ein Rang verteilt und färbt, die übrigen rechnen Kacheln; ein Rang pro Kern
+                String ranks = Integer.toString(Runtime.getRuntime().availableProcessors() + 1);
+                if (System.getProperty("os.name").toLowerCase().contains("win")) {
+                    return new ProcessBuilder("mpiexec", "-n", ranks, executablePath("bin/backend/mpi/MpiFractalBackend"));
+                }
+                return new ProcessBuilder("mpirun", "--oversubscribe", "-np", ranks, "bin/backend/mpi/MpiFractalBackend");
             case "C OpenMP":
-                return new ProcessBuilder(
-                        "sources/Backend/c/fractal_c_openmp_live");
+                return new ProcessBuilder(executablePath("bin/backend/c/OpenMPFractalBackend"));
             default:
                 throw new IllegalArgumentException("Unbekanntes Backend: " + backend);
         }
     }
 
+    /**
+     * Hängt unter Windows ".exe" an den Pfad eines nativen Backends an.
+     */
+    private String executablePath(String basePath) {
+        String os = System.getProperty("os.name").toLowerCase();
+        return os.contains("win") ? basePath + ".exe" : basePath;
+    }
+
     public static void main(String[] args) {
         SwingUtilities.invokeLater(FractalGuiRealtime::new);
     }
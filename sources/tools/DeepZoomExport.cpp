@@ -0,0 +1,452 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "../backend/common/FractalProtocol.h"
+#include "../backend/common/Palette.h"
+#include "../backend/common/Perturbation.h"
+#include "../backend/c/CpuRenderer.h"
+#include "../backend/c/FractalSimd.h"
+#include "PngWriter.h"
+
+/*
+ * Batch-Export einer Deep-Zoom-Pyramide (DZI, z. B. für OpenSeadragon) direkt aus dem Renderer, ohne
+ * erst ein riesiges Bild zu rechnen und zu zerschneiden. Das Bild zeigt den Ausschnitt der GUI bei
+ * --zoom mit --size Pixeln, in der tiefsten Ebene aber mit der Pixelgröße von --target-zoom, also
+ * W * T / Z x H * T / Z Pixel. Jede Ebene darüber hat die halbe Auflösung bis hinunter zu 1 x 1 Pixel
+ * und wird mit ihrer eigenen Pixelgröße gerechnet, nicht aus der tieferen verkleinert.
+ *
+ * Ausgabe zu --output NAME: NAME.dzi und NAME_files/<Ebene>/<Spalte>_<Zeile>.png, Kacheln von
+ * --tile-size Pixeln mit einem Pixel Überlappung. Alle Kacheln einer Ebene werden per OpenMP verteilt,
+ * jede in einem Thread gerechnet und kodiert.
+ *
+ * Fortsetzen: vorhandene Kacheln werden übersprungen, jede Kachel entsteht unter .tmp und wird erst
+ * fertig umbenannt. Die Parameter stehen im Deskriptor; ein Lauf mit anderen bricht ab, statt Kacheln
+ * zu mischen. Übersetzen: siehe docs/makescript.
+ */
+
+#define DZI_TILE_SIZE_DEFAULT 256
+#define DZI_OVERLAP 1
+#define DZI_PATH_MAX 4096
+// Größte Kantenlänge der tiefsten Ebene; Bildkoordinaten sind int
+#define DZI_MAX_SIZE (1 << 30)
+// Fortschritt auf stderr nach so vielen Kacheln
+#define DZI_PROGRESS_TILES 1000
+
+struct ExportSettings
+{
+    const char *centerX;
+    const char *centerY;
+    double zoom;
+    double targetZoom;
+    int WIDTH, HEIGHT;
+    const char *output;
+    int tileSize;
+    Precision precision;
+    double hueOffset;
+    bool smooth;
+    const char *palettePath;
+};
+
+/**
+ * @brief Liest die Kommandozeile:
+ *   --center X Y          Zentrum, Dezimaltext in voller Genauigkeit (Standard: 0 0)
+ *   --zoom Z              Zoom der Gesamtansicht (Standard: 1)
+ *   --size W H            Größe der Gesamtansicht in Pixeln bei Zoom Z (Standard: 800 600)
+ *   --target-zoom T       Zoom, dessen Pixelgröße die tiefste Ebene hat (Pflicht, mindestens Z)
+ *   --output NAME         Ergebnis NAME.dzi und NAME_files/ (Pflicht)
+ *   --tile-size N         Kantenlänge der Kacheln (Standard: DZI_TILE_SIZE_DEFAULT)
+ *   --threads N           Anzahl der OpenMP-Threads (Standard: alle Kerne)
+ *   --precision auto|float|double|double-double|perturbation  Rechenverfahren erzwingen
+ *   --hue DEG             Verschiebung des Farbtons
+ *   --smooth              Stufenlose Farben aus der normierten Iterationsanzahl
+ *   --palette FILE        Farbverlauf aus FILE statt des HSV-Farbkreises, siehe Palette.h
+ *
+ * @return 0 bei Erfolg, sonst 1
+ */
+static int parseArguments(int argc, char **argv, ExportSettings &s)
+{
+    s.centerX = "0";
+    s.centerY = "0";
+    s.zoom = 1.0;
+    s.targetZoom = 0.0;
+    s.WIDTH = 800;
+    s.HEIGHT = 600;
+    s.output = NULL;
+    s.tileSize = DZI_TILE_SIZE_DEFAULT;
+    s.precision = PRECISION_AUTO;
+    s.hueOffset = 0.0;
+    s.smooth = false;
+    s.palettePath = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--center") == 0 && i + 2 < argc)
+        {
+            s.centerX = argv[++i];
+            s.centerY = argv[++i];
+        }
+        else if (strcmp(argv[i], "--zoom") == 0 && i + 1 < argc)
+        {
+            s.zoom = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+        {
+            s.WIDTH = atoi(argv[++i]);
+            s.HEIGHT = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--target-zoom") == 0 && i + 1 < argc)
+        {
+            s.targetZoom = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            s.output = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc)
+        {
+            s.tileSize = atoi(argv[++i]);
+            if (s.tileSize < 16 || s.tileSize > 4096)
+            {
+                fprintf(stderr, "Invalid tile size: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            int threads = atoi(argv[++i]);
+            if (threads < 1)
+            {
+                fprintf(stderr, "Invalid thread count: %s\n", argv[i]);
+                return 1;
+            }
+            omp_set_num_threads(threads);
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc)
+        {
+            if (!parsePrecision(argv[++i], s.precision))
+            {
+                fprintf(stderr, "Unknown precision: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--hue") == 0 && i + 1 < argc)
+        {
+            s.hueOffset = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--smooth") == 0)
+        {
+            s.smooth = true;
+        }
+        else if (strcmp(argv[i], "--palette") == 0 && i + 1 < argc)
+        {
+            s.palettePath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (s.output == NULL || !(s.targetZoom > 0.0))
+    {
+        fprintf(stderr, "Usage: DeepZoomExport --target-zoom T --output NAME [--center X Y] [--zoom Z] [--size W H]\n"
+                        "       [--tile-size N] [--threads N] [--precision P] [--hue DEG] [--smooth]\n"
+                        "       [--palette FILE]\n");
+        return 1;
+    }
+    if (!(s.zoom > 0.0) || s.targetZoom < s.zoom || !isfinite(s.hueOffset))
+    {
+        fprintf(stderr, "Need 0 < zoom <= target zoom\n");
+        return 1;
+    }
+    return 0;
+}
+
+static void makeDirectory(const char *path)
+{
+    // Ein schon vorhandenes Verzeichnis ist beim Fortsetzen normal; andere Fehler zeigt das Schreiben
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+static bool fileExists(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Schreibt den Deskriptor oder prüft beim Fortsetzen, dass der vorhandene zu den Parametern passt.
+ *
+ * @return false bei Schreibfehler oder abweichenden Parametern
+ */
+static bool writeDescriptor(const ExportSettings &s, long long width, long long height)
+{
+    char text[2048];
+    snprintf(text, sizeof(text),
+             "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+             "<!-- DeepZoomExport center=%s %s zoom=%.17g size=%dx%d target-zoom=%.17g precision=%s hue=%.17g%s%s%s -->\n"
+             "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"%d\" TileSize=\"%d\">\n"
+             "  <Size Width=\"%lld\" Height=\"%lld\"/>\n"
+             "</Image>\n",
+             s.centerX, s.centerY, s.zoom, s.WIDTH, s.HEIGHT, s.targetZoom, precisionName(s.precision), s.hueOffset,
+             s.smooth ? " smooth" : "", s.palettePath != NULL ? " palette=" : "", s.palettePath != NULL ? s.palettePath : "", DZI_OVERLAP, s.tileSize, width, height);
+
+    char path[DZI_PATH_MAX];
+    snprintf(path, sizeof(path), "%s.dzi", s.output);
+    FILE *file = fopen(path, "rb");
+    if (file != NULL)
+    {
+        char existing[2048];
+        size_t length = fread(existing, 1, sizeof(existing) - 1, file);
+        fclose(file);
+        existing[length] = '\0';
+        if (strcmp(existing, text) != 0)
+        {
+            fprintf(stderr, "%s was exported with other parameters; delete it or choose another --output\n", path);
+            return false;
+        }
+        fprintf(stderr, "Resuming %s\n", path);
+        return true;
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    bool ok = fputs(text, file) >= 0;
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief Bildparameter einer Ebene. Iterationsgrenze und Rechenverfahren richten sich nach ihrer
+ * Pixelgröße, wie bei einem Bild der Gesamtansicht mit dieser Pixelgröße; die BLA-Tabelle wird für
+ * die ganze Ebene neu bemessen (wie bei renderExpMap()).
+ *
+ * @param frame Ergebnis
+ * @param req Gesamtansicht
+ * @param scale Pixelgröße der Ebene
+ * @param width Größe der Ebene
+ * @param height
+ * @param opts
+ * @param orbit
+ * @param bla
+ * @return false, wenn der Referenzorbit nicht berechnet werden kann
+ */
+static bool prepareLevel(FrameParams &frame, const FrameRequest &req, double scale, int width, int height, const RenderOptions &opts,
+                         ReferenceOrbit &orbit, BlaTable &bla)
+{
+    FrameRequest levelReq = req;
+    levelReq.zoom = 4.0 / (req.WIDTH * scale);
+    if (!prepareFrame(frame, levelReq, opts, orbit, bla))
+        return false;
+    frame.WIDTH = width;
+    frame.HEIGHT = height;
+
+    if (frame.blaLevels > 0)
+    {
+        frame.blaLevels = 0;
+        if (computeBlaTable(bla, orbit, frame.scale * 0.5 * sqrt((double)width * width + (double)height * height)))
+        {
+            frame.bla = bla.steps;
+            frame.blaLevels = bla.levels;
+            memcpy(frame.blaOffset, bla.offset, sizeof(bla.offset));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Rechnet alle noch fehlenden Kacheln einer Ebene.
+ *
+ * @return false bei Schreibfehler oder fehlendem Speicher
+ */
+static bool exportLevel(const ExportSettings &s, int level, const FrameParams &frame, const RenderOptions &opts, const ColorOptions &colors,
+                        SimdLevel simd)
+{
+    char directory[DZI_PATH_MAX];
+    snprintf(directory, sizeof(directory), "%s_files/%d", s.output, level);
+    makeDirectory(directory);
+
+    int tileSize = s.tileSize;
+    int cols = (frame.WIDTH + tileSize - 1) / tileSize;
+    int rows = (frame.HEIGHT + tileSize - 1) / tileSize;
+    long long tiles = (long long)cols * rows;
+    long long done = 0;
+    long long skipped = 0;
+    bool ok = true;
+    double start = omp_get_wtime();
+
+#pragma omp parallel
+    {
+        int maxSide = tileSize + 2 * DZI_OVERLAP;
+        uint8_t *rgb = (uint8_t *)malloc((size_t)maxSide * maxSide * 3);
+        if (rgb == NULL)
+        {
+#pragma omp critical(dziProgress)
+            ok = false;
+        }
+
+#pragma omp for schedule(dynamic, 1)
+        for (long long t = 0; t < tiles; t++)
+        {
+            if (rgb == NULL || !ok)
+                continue;
+
+            int col = (int)(t % cols);
+            int row = (int)(t / cols);
+            char path[DZI_PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%d_%d.png", directory, col, row);
+            bool exists = fileExists(path);
+            bool written = true;
+            if (!exists)
+            {
+                // Kachel plus ein Pixel der Nachbarn auf jeder Seite, die es gibt
+                int x0 = col * tileSize - (col > 0 ? DZI_OVERLAP : 0);
+                int y0 = row * tileSize - (row > 0 ? DZI_OVERLAP : 0);
+                int x1 = (col + 1) * tileSize + DZI_OVERLAP < frame.WIDTH ? (col + 1) * tileSize + DZI_OVERLAP : frame.WIDTH;
+                int y1 = (row + 1) * tileSize + DZI_OVERLAP < frame.HEIGHT ? (row + 1) * tileSize + DZI_OVERLAP : frame.HEIGHT;
+
+                size_t size = 0;
+                uint8_t *png = NULL;
+                if (renderRegion(rgb, frame, opts, colors, simd, x0, y0, x1 - x0, y1 - y0))
+                    png = encodePng(rgb, x1 - x0, y1 - y0, size);
+
+                char temp[DZI_PATH_MAX + 8];
+                snprintf(temp, sizeof(temp), "%s.tmp", path);
+                FILE *file = png != NULL ? fopen(temp, "wb") : NULL;
+                written = file != NULL && fwrite(png, 1, size, file) == size;
+                if (file != NULL && fclose(file) != 0)
+                    written = false;
+                written = written && rename(temp, path) == 0;
+                free(png);
+                if (!written)
+                {
+#pragma omp critical(dziProgress)
+                    fprintf(stderr, "Cannot write tile %s\n", path);
+                }
+            }
+
+#pragma omp critical(dziProgress)
+            {
+                if (!written)
+                    ok = false;
+                done++;
+                if (exists)
+                    skipped++;
+                if (done % DZI_PROGRESS_TILES == 0 && done < tiles)
+                {
+                    fprintf(stderr, "Level %d: %lld / %lld tiles\n", level, done, tiles);
+                    fflush(stderr);
+                }
+            }
+        }
+        free(rgb);
+    }
+
+    fprintf(stderr, "Level %d: %d x %d px, %lld tiles (%lld already there), %s, %.3f s\n", level, frame.WIDTH, frame.HEIGHT, tiles,
+            skipped, precisionName(frame.precision), omp_get_wtime() - start);
+    fflush(stderr);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    ExportSettings s;
+    if (parseArguments(argc, argv, s) != 0)
+        return 1;
+
+    // Über parseTextRequest(), damit Zentrum und Größe wie eine Anfrage der GUI geprüft werden
+    char line[2 * FRACTAL_NUMBER_MAX + 64];
+    snprintf(line, sizeof(line), "%.17g %s %s %d %d", s.zoom, s.centerX, s.centerY, s.WIDTH, s.HEIGHT);
+    FrameRequest req;
+    if (strlen(s.centerX) >= FRACTAL_NUMBER_MAX || strlen(s.centerY) >= FRACTAL_NUMBER_MAX || !parseTextRequest(line, req))
+    {
+        fprintf(stderr, "Invalid center or size\n");
+        return 1;
+    }
+    req.precision = s.precision;
+    req.colors.hueOffset = s.hueOffset;
+    req.colors.smooth = s.smooth;
+
+    // Eine Farbtabelle für alle Kacheln, die Threads lesen sie nur
+    Gradient gradient;
+    if (s.palettePath != NULL && !loadGradient(s.palettePath, gradient))
+        return 1;
+    Palette palette;
+    buildPalette(palette, req.colors, s.palettePath != NULL ? &gradient : NULL);
+    req.colors.palette = &palette;
+
+    double magnification = s.targetZoom / s.zoom;
+    double fullWidth = ceil(s.WIDTH * magnification);
+    double fullHeight = ceil(s.HEIGHT * magnification);
+    if (fullWidth > DZI_MAX_SIZE || fullHeight > DZI_MAX_SIZE)
+    {
+        fprintf(stderr, "Deepest level of %.0f x %.0f px is too large\n", fullWidth, fullHeight);
+        return 1;
+    }
+    long long width = (long long)fullWidth;
+    long long height = (long long)fullHeight;
+    // Pixelgröße der tiefsten Ebene, wie ein Bild der Breite W bei --target-zoom
+    double scale = 4.0 / (s.WIDTH * s.targetZoom);
+    int maxLevel = 0;
+    while ((1LL << maxLevel) < (width > height ? width : height))
+        maxLevel++;
+
+    if (!writeDescriptor(s, width, height))
+        return 1;
+    char directory[DZI_PATH_MAX];
+    snprintf(directory, sizeof(directory), "%s_files", s.output);
+    makeDirectory(directory);
+
+    RenderOptions opts;
+    SimdLevel simd = detectSimdLevel();
+    fprintf(stderr, "DeepZoomExport: %lld x %lld px, levels 0..%d, %d threads, %s\n", width, height, maxLevel, omp_get_max_threads(),
+            simdLevelName(simd));
+    fflush(stderr);
+
+    ReferenceOrbit orbit = {NULL, NULL, 0, 0};
+    BlaTable bla = {NULL, 0, 0, {0}};
+    bool ok = true;
+    double start = omp_get_wtime();
+    for (int level = 0; level <= maxLevel && ok; level++)
+    {
+        // Ebene level ist die tiefste um 2^(maxLevel - level) verkleinert, mit gleichem Zentrum
+        int shift = maxLevel - level;
+        int levelWidth = (int)((width + (1LL << shift) - 1) >> shift);
+        int levelHeight = (int)((height + (1LL << shift) - 1) >> shift);
+        FrameParams frame;
+        ok = prepareLevel(frame, req, ldexp(scale, shift), levelWidth, levelHeight, opts, orbit, bla) &&
+             exportLevel(s, level, frame, opts, req.colors, simd);
+    }
+    freeReferenceOrbit(orbit);
+    freeBlaTable(bla);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Export incomplete; run again with the same arguments to resume\n");
+        return 1;
+    }
+    fprintf(stderr, "Export finished in %.3f s\n", omp_get_wtime() - start);
+    return 0;
+}
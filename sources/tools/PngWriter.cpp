@@ -0,0 +1,351 @@
+#include "PngWriter.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Deflate-Fenster und Hash über drei Bytes
+#define LZ_WINDOW 32768
+#define LZ_HASH_BITS 15
+// Geprüfte Vorgänger pro Position; mehr bringt bei Fraktalbildern kaum kürzere Dateien
+#define LZ_MAX_CHAIN 32
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH 258
+
+static const uint16_t LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                         31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                       193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+struct BitWriter
+{
+    uint8_t *out;
+    size_t pos;
+    uint64_t bits;
+    int count;
+};
+
+/**
+ * @brief Hängt n Bits an, das niedrigste zuerst (Reihenfolge von Deflate).
+ */
+static void putBits(BitWriter &w, uint32_t value, int n)
+{
+    w.bits |= (uint64_t)value << w.count;
+    w.count += n;
+    while (w.count >= 8)
+    {
+        w.out[w.pos++] = (uint8_t)w.bits;
+        w.bits >>= 8;
+        w.count -= 8;
+    }
+}
+
+/**
+ * @brief Hängt einen Huffman-Code an; die stehen mit dem höchsten Bit zuerst im Strom.
+ */
+static void putCode(BitWriter &w, uint32_t code, int n)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < n; i++)
+        reversed |= ((code >> i) & 1) << (n - 1 - i);
+    putBits(w, reversed, n);
+}
+
+/**
+ * @brief Symbol 0..287 des Literal-/Längenalphabets mit den festen Codes.
+ */
+static void putSymbol(BitWriter &w, int symbol)
+{
+    if (symbol < 144)
+        putCode(w, 0x30 + symbol, 8);
+    else if (symbol < 256)
+        putCode(w, 0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        putCode(w, symbol - 256, 7);
+    else
+        putCode(w, 0xC0 + symbol - 280, 8);
+}
+
+static void putMatch(BitWriter &w, int length, int distance)
+{
+    int l = 0;
+    while (l < 28 && LENGTH_BASE[l + 1] <= length)
+        l++;
+    putSymbol(w, 257 + l);
+    putBits(w, length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+    int d = 0;
+    while (d < 29 && DIST_BASE[d + 1] <= distance)
+        d++;
+    putCode(w, d, 5);
+    putBits(w, distance - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+static int hash3(const uint8_t *p)
+{
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & ((1 << LZ_HASH_BITS) - 1);
+}
+
+/**
+ * @brief Deflate in einem Block mit festen Codes. Höchstens 9 Bit pro Eingabebyte plus Blockende.
+ *
+ * @param data
+ * @param n
+ * @param out Ausgabe
+ * @param head Hilfsspeicher, 1 << LZ_HASH_BITS Einträge
+ * @param prev Hilfsspeicher, LZ_WINDOW Einträge
+ * @return Länge der Ausgabe
+ */
+static size_t deflateFixed(const uint8_t *data, int n, uint8_t *out, int *head, int *prev)
+{
+    BitWriter w = {out, 0, 0, 0};
+    // BFINAL, BTYPE 01 = feste Codes
+    putBits(w, 1, 1);
+    putBits(w, 1, 2);
+
+    memset(head, 0xFF, sizeof(int) << LZ_HASH_BITS);
+    int i = 0;
+    while (i < n)
+    {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (i + LZ_MIN_MATCH <= n)
+        {
+            int maxLength = n - i < LZ_MAX_MATCH ? n - i : LZ_MAX_MATCH;
+            int candidate = head[hash3(data + i)];
+            for (int chain = 0; candidate >= 0 && i - candidate <= LZ_WINDOW && chain < LZ_MAX_CHAIN; chain++)
+            {
+                // Nur Kandidaten, die mindestens so lang wie der bisher beste passen können
+                if (data[candidate + bestLength] == data[i + bestLength])
+                {
+                    int length = 0;
+                    while (length < maxLength && data[candidate + length] == data[i + length])
+                        length++;
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = i - candidate;
+                        if (length == maxLength)
+                            break;
+                    }
+                }
+                int next = prev[candidate & (LZ_WINDOW - 1)];
+                if (next >= candidate)
+                    break;
+                candidate = next;
+            }
+        }
+
+        int advance = 1;
+        if (bestLength >= LZ_MIN_MATCH)
+        {
+            putMatch(w, bestLength, bestDistance);
+            advance = bestLength;
+        }
+        else
+            putSymbol(w, data[i]);
+
+        for (int end = i + advance; i < end; i++)
+        {
+            if (i + LZ_MIN_MATCH <= n)
+            {
+                int h = hash3(data + i);
+                prev[i & (LZ_WINDOW - 1)] = head[h];
+                head[h] = i;
+            }
+        }
+    }
+
+    putSymbol(w, 256);
+    if (w.count > 0)
+        putBits(w, 0, 8 - w.count);
+    return w.pos;
+}
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+/**
+ * @brief Filtert eine Zeile mit Filtertyp type (0 = keiner, 1 = Sub, 2 = Up, 3 = Average, 4 = Paeth).
+ *
+ * @param row Zeile mit length Bytes
+ * @param above vorige Zeile, NULL für die erste
+ * @param length
+ * @param type
+ * @param out length Bytes
+ */
+static void filterRow(const uint8_t *row, const uint8_t *above, int length, int type, uint8_t *out)
+{
+    for (int i = 0; i < length; i++)
+    {
+        int a = i >= 3 ? row[i - 3] : 0;
+        int b = above != NULL ? above[i] : 0;
+        int c = i >= 3 && above != NULL ? above[i - 3] : 0;
+        int predicted = 0;
+        if (type == 1)
+            predicted = a;
+        else if (type == 2)
+            predicted = b;
+        else if (type == 3)
+            predicted = (a + b) / 2;
+        else if (type == 4)
+            predicted = paeth(a, b, c);
+        out[i] = (uint8_t)(row[i] - predicted);
+    }
+}
+
+/**
+ * @brief Summe der Beträge der gefilterten Bytes als vorzeichenbehaftete Zahlen, die Auswahlregel von libpng.
+ */
+static long filterCost(const uint8_t *filtered, int length)
+{
+    long cost = 0;
+    for (int i = 0; i < length; i++)
+        cost += abs((int)(int8_t)filtered[i]);
+    return cost;
+}
+
+struct CrcTable
+{
+    uint32_t entries[256];
+};
+
+static CrcTable makeCrcTable()
+{
+    CrcTable table;
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table.entries[n] = c;
+    }
+    return table;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    // Die Initialisierung lokaler statischer Variablen ist threadsicher, die Kacheln werden parallel kodiert
+    static const CrcTable table = makeCrcTable();
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++)
+        c = table.entries[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t length)
+{
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void putU32BigEndian(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief Schreibt Länge, Typ und CRC um die Daten eines Chunks, die schon ab p + 8 stehen.
+ *
+ * @return Länge des ganzen Chunks
+ */
+static size_t finishChunk(uint8_t *p, const char *type, size_t length)
+{
+    putU32BigEndian(p, (uint32_t)length);
+    memcpy(p + 4, type, 4);
+    putU32BigEndian(p + 8 + length, crc32(p + 4, length + 4));
+    return length + 12;
+}
+
+uint8_t *encodePng(const uint8_t *rgb, int width, int height, size_t &size)
+{
+    int rowBytes = 3 * width;
+    if (width <= 0 || height <= 0 || (long long)height * (1 + rowBytes) > INT_MAX / 2)
+        return NULL;
+    int rawSize = height * (1 + rowBytes);
+
+    uint8_t *raw = (uint8_t *)malloc(rawSize);
+    uint8_t *candidate = (uint8_t *)malloc(rowBytes);
+    int *head = (int *)malloc(sizeof(int) << LZ_HASH_BITS);
+    int *prev = (int *)malloc(sizeof(int) * LZ_WINDOW);
+    // Signatur, IHDR, IDAT-Rahmen, zlib-Kopf und Adler-32, IEND
+    size_t capacity = 8 + 25 + 12 + 6 + (size_t)rawSize + rawSize / 8 + 16 + 12;
+    uint8_t *png = (uint8_t *)malloc(capacity);
+    if (raw == NULL || candidate == NULL || head == NULL || prev == NULL || png == NULL)
+    {
+        free(raw);
+        free(candidate);
+        free(head);
+        free(prev);
+        free(png);
+        return NULL;
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *row = rgb + (size_t)y * rowBytes;
+        const uint8_t *above = y > 0 ? row - rowBytes : NULL;
+        uint8_t *out = raw + (size_t)y * (1 + rowBytes);
+        long bestCost = -1;
+        for (int type = 0; type <= 4; type++)
+        {
+            filterRow(row, above, rowBytes, type, candidate);
+            long cost = filterCost(candidate, rowBytes);
+            if (bestCost < 0 || cost < bestCost)
+            {
+                bestCost = cost;
+                out[0] = (uint8_t)type;
+                memcpy(out + 1, candidate, rowBytes);
+            }
+        }
+    }
+
+    static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    memcpy(png, SIGNATURE, 8);
+    size_t pos = 8;
+
+    uint8_t *ihdr = png + pos + 8;
+    putU32BigEndian(ihdr, (uint32_t)width);
+    putU32BigEndian(ihdr + 4, (uint32_t)height);
+    // 8 Bit pro Kanal, Farbtyp 2 (RGB), Deflate, Standardfilter, kein Interlacing
+    ihdr[8] = 8;
+    ihdr[9] = 2;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    pos += finishChunk(png + pos, "IHDR", 13);
+
+    uint8_t *zlib = png + pos + 8;
+    // CMF/FLG: Deflate mit 32-KiB-Fenster, Prüfsumme durch 31 teilbar
+    zlib[0] = 0x78;
+    zlib[1] = 0x01;
+    size_t zlibSize = 2 + deflateFixed(raw, rawSize, zlib + 2, head, prev);
+    putU32BigEndian(zlib + zlibSize, adler32(raw, rawSize));
+    pos += finishChunk(png + pos, "IDAT", zlibSize + 4);
+    pos += finishChunk(png + pos, "IEND", 0);
+
+    free(raw);
+    free(candidate);
+    free(head);
+    free(prev);
+    size = pos;
+    return png;
+}
@@ -0,0 +1,24 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * PNG-Ausgabe ohne zlib: Zeilenfilter wie bei libpng (kleinste Summe der Beträge), danach Deflate mit
+ * LZ77 und den festen Huffman-Codes. Die Bilder des Mandelbrots bestehen zum großen Teil aus gleichfarbigen
+ * Flächen und Verläufen, dafür reicht das; ein dynamischer Huffman-Block brächte nur wenige Prozent.
+ */
+
+/**
+ * @brief Kodiert ein RGB24-Bild als PNG.
+ *
+ * @param rgb width * height * 3 Bytes, zeilenweise von oben links
+ * @param width
+ * @param height
+ * @param size Ergebnis: Länge der Datei
+ * @return PNG-Datei, mit free() freigeben; NULL bei fehlendem Speicher
+ */
+uint8_t *encodePng(const uint8_t *rgb, int width, int height, size_t &size);
+
+#endif